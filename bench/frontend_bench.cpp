@@ -0,0 +1,102 @@
+// frontend_bench.cpp - 比较 Flex/Bison 前端与手写前端的解析吞吐
+//
+// 用法: toyc_frontend_bench [file.tc] [iterations]
+// 不给文件时生成一段合成源码（约 4MB）作为输入。
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "parser/parse_context.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static std::string generateSource(size_t targetBytes) {
+    std::string source;
+    source.reserve(targetBytes + 1024);
+    int index = 0;
+    while (source.size() < targetBytes) {
+        std::string name = "f" + std::to_string(index);
+        source += "// helper " + name + "\n";
+        source += "int " + name + "(int a, int b) {\n";
+        source += "    int sum = 0;\n";
+        source += "    /* accumulate\n       with a loop */\n";
+        source += "    while (a < b) {\n";
+        source += "        if (a % 3 == 0 && b != 7) sum = sum + a * 2;\n";
+        source += "        else sum = sum - (b / 2);\n";
+        source += "        a = a + 1;\n";
+        source += "    }\n";
+        source += "    return sum;\n";
+        source += "}\n\n";
+        index++;
+    }
+    source += "int main() {\n    return f0(1, 10);\n}\n";
+    return source;
+}
+
+template <typename Fn>
+static double measureSeconds(int iterations, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static void report(const char* name, size_t bytes, int iterations, double seconds) {
+    double mb = static_cast<double>(bytes) * iterations / (1024.0 * 1024.0);
+    std::cout << name << ": " << seconds * 1000.0 / iterations << " ms/iter, "
+              << mb / seconds << " MB/s" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string source;
+    if (argc > 1) {
+        std::ifstream file(argv[1]);
+        if (!file) {
+            std::cerr << "Error: Cannot open file " << argv[1] << std::endl;
+            return 1;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        source = buffer.str();
+    } else {
+        source = generateSource(4 * 1024 * 1024);
+    }
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (iterations <= 0) iterations = 1;
+
+    std::cout << "input: " << source.size() << " bytes, " << iterations << " iterations" << std::endl;
+
+    // Flex/Bison：扫描与解析交织进行
+    ParseContext context;
+    double flexBison = measureSeconds(iterations, [&] {
+        if (!context.parseString(source)) {
+            std::cerr << "Error: Flex/Bison frontend failed to parse input." << std::endl;
+            std::exit(1);
+        }
+    });
+
+    // 手写前端：分别统计词法与完整解析
+    double lexOnly = measureSeconds(iterations, [&] {
+        Lexer lexer(source);
+        auto tokens = lexer.tokenize();
+        if (tokens.empty()) std::exit(1);
+    });
+    double handwritten = measureSeconds(iterations, [&] {
+        Lexer lexer(source);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, lexer.getSource());
+        if (!parser.parse()) {
+            std::cerr << "Error: handwritten frontend failed to parse input." << std::endl;
+            std::exit(1);
+        }
+    });
+
+    report("flex/bison        ", source.size(), iterations, flexBison);
+    report("handwritten lexer ", source.size(), iterations, lexOnly);
+    report("handwritten parse ", source.size(), iterations, handwritten);
+    return 0;
+}
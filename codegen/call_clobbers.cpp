@@ -0,0 +1,87 @@
+#include "call_clobbers.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+// 按 x0–x31 编号排列的 ABI 名字
+const char* const kRegisterNames[32] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+    "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+    "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+    "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+};
+
+}  // namespace
+
+CallClobbers::Mask CallClobbers::bit(const std::string& reg) {
+    if (reg == "fp") {
+        return Mask(1) << 8;
+    }
+    for (int i = 0; i < 32; ++i) {
+        if (reg == kRegisterNames[i]) {
+            return Mask(1) << i;
+        }
+    }
+    return 0;
+}
+
+CallClobbers::Mask CallClobbers::standard() {
+    Mask mask = bit("ra");
+    for (const char* reg : {"t0", "t1", "t2", "t3", "t4", "t5", "t6",
+                            "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7"}) {
+        mask |= bit(reg);
+    }
+    return mask;
+}
+
+CallClobbers::Mask CallClobbers::lookup(const std::string& funcName) const {
+    auto it = masks.find(funcName);
+    return it != masks.end() ? it->second : standard();
+}
+
+void CallClobbers::record(const std::string& funcName, Mask mask) {
+    masks[funcName] = mask;
+}
+
+CallClobbers::Mask CallClobbers::atCall(const CallInstr& call) const {
+    Mask mask = lookup(call.funcName) | bit("a0");
+    for (int i = 0; i < std::min(call.paramCount, 8); ++i) {
+        mask |= bit("a" + std::to_string(i));
+    }
+    return mask;
+}
+
+std::string CallClobbers::format(Mask mask) {
+    std::string text;
+    for (int i = 0; i < 32; ++i) {
+        if (mask & (Mask(1) << i)) {
+            text += " ";
+            text += kRegisterNames[i];
+        }
+    }
+    return text;
+}
+
+void CallClobbers::recordFromAssembly(const std::string& assembly) {
+    // 摘要注释紧跟在函数的 .global 之后
+    const std::string global = "\t.global ";
+    const std::string prefix = kCommentPrefix;
+    std::string funcName;
+    std::istringstream lines(assembly);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, global.size(), global) == 0) {
+            funcName = line.substr(global.size());
+        } else if (!funcName.empty() && line.compare(0, prefix.size(), prefix) == 0) {
+            Mask mask = 0;
+            std::istringstream regs(line.substr(prefix.size()));
+            std::string reg;
+            while (regs >> reg) {
+                mask |= bit(reg);
+            }
+            record(funcName, mask);
+            funcName.clear();
+        }
+    }
+}
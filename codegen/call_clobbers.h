@@ -0,0 +1,43 @@
+#pragma once
+#include "ir/ir.h"
+#include <cstdint>
+#include <map>
+#include <string>
+
+// ==================== 过程间寄存器摘要 ====================
+
+/**
+ * 已生成函数的调用摘要：调用它之后哪些寄存器可能被改写，按 x0–x31 的编号记成位掩码。
+ *
+ * 整个程序在一个编译单元里，函数先定义后调用，按源码顺序生成时被调函数都已登记。
+ * 调用处只需避开被调函数真正改写的寄存器，跨调用活跃的值可以留在它没用到的 a 寄存器里，
+ * 不必都挤进要在序言里保存的 s 寄存器。s 寄存器仍由被调函数保存，不会出现在摘要里。
+ * 没有登记的函数（递归调用自身、main、IR 输入中排在调用者之后的函数）按标准 ABI 处理。
+ *
+ * 摘要同时以注释写在函数的汇编开头，缓存命中、没有重新生成时从汇编中找回。
+ */
+class CallClobbers {
+public:
+    using Mask = uint32_t;
+
+    // 寄存器名对应的位；不认识的名字为 0
+    static Mask bit(const std::string& reg);
+    // 标准 ABI 下调用会改写的寄存器：ra、t0–t6、a0–a7
+    static Mask standard();
+
+    Mask lookup(const std::string& funcName) const;
+    void record(const std::string& funcName, Mask mask);
+
+    // 一次调用会改写的寄存器：被调函数的摘要，加上传参和返回值用到的 a 寄存器
+    Mask atCall(const CallInstr& call) const;
+
+    // 汇编中的摘要注释，寄存器按编号顺序列出
+    static std::string format(Mask mask);
+    // 从一段汇编中找回其中各函数的摘要注释并登记
+    void recordFromAssembly(const std::string& assembly);
+
+    static constexpr const char* kCommentPrefix = "# 改写寄存器:";
+
+private:
+    std::map<std::string, Mask> masks;
+};
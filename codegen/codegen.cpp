@@ -1,4 +1,6 @@
 #include "codegen.h"
+#include "range_split.h"
+#include "ssa.h"
 #include <sstream>
 #include <iostream>
 #include <cassert>
@@ -6,6 +8,8 @@
 #include <queue>
 #include <stack>
 #include <limits>
+#include <future>
+#include <thread>
 
 // ==================== 构造函数和析构函数 ====================
 
@@ -20,18 +24,6 @@ CodeGenerator::CodeGenerator(std::ostream& outputStream,
 
     initializeRegisters();
     // std::cerr << "寄存器信息初始化完成\n";
-    // std::cerr << "输出文件头\n";
-
-    emitComment("由ToyC编译器生成");
-    emitComment("RISC-V汇编代码");
-    emitSection(".text");
-    
-    if (config.regAllocStrategy != RegisterAllocStrategy::NAIVE) {
-        // std::cerr << "执行寄存器分配\n";
-        allocateRegisters();
-        // std::cerr << "寄存器分配完成\n";
-    }
-    // std::cerr << "CodeGenerator构造函数完成\n";
 }
 
 CodeGenerator::~CodeGenerator() {
@@ -39,15 +31,65 @@ CodeGenerator::~CodeGenerator() {
 
 // ==================== 主要生成函数 ====================
 
+void CodeGenerator::emitFileHeader(std::ostream& stream) {
+    stream << "# 由ToyC编译器生成\n";
+    stream << "# RISC-V汇编代码\n";
+    stream << ".text\n";
+}
+
 void CodeGenerator::generate() {
-    // std::cerr << "进入generate方法\n";
+    emitFileHeader(output);
+    generateFunctions();
+}
+
+void CodeGenerator::generateFunctions() {
+    // 按 FUNCTION_BEGIN/FUNCTION_END 切分，每个函数独立分配寄存器和计算栈帧
+    size_t begin = 0;
+    while (begin < instructions.size()) {
+        size_t end = begin + 1;
+        while (end < instructions.size() && instructions[end - 1]->opcode != OpCode::FUNCTION_END) {
+            end++;
+        }
+        functionInstrs.assign(instructions.begin() + begin, instructions.begin() + end);
+        generateFunction();
+        begin = end;
+    }
+    functionInstrs.clear();
+}
+
+void CodeGenerator::generateFunction() {
+    // std::cerr << "进入generateFunction方法\n";
+
+    labelCount = 0;
+    std::string funcName;
+    for (const auto& instr : functionInstrs) {
+        if (auto begin = std::dynamic_pointer_cast<FunctionBeginInstr>(instr)) {
+            funcName = begin->funcName;
+            break;
+        }
+    }
+
+    RegisterAllocStrategy strategy = config.regAllocStrategy;
+    bool buildsGraph = strategy == RegisterAllocStrategy::GRAPH_COLOR || strategy == RegisterAllocStrategy::SSA;
+    if (buildsGraph && config.graphColorBudget) {
+        // 冲突图按名字两两建边，超大函数上降级为线性扫描
+        uint64_t cost = FunctionSize::measure(functionInstrs).pairCost();
+        if (cost > config.graphColorBudget) {
+            const char* from = strategy == RegisterAllocStrategy::SSA ? "ssa" : "graph";
+            budgetEvents.push_back({funcName, from, "linear", cost, config.graphColorBudget});
+            strategy = RegisterAllocStrategy::LINEAR_SCAN;
+        }
+    }
+    if (strategy == RegisterAllocStrategy::AUTO) {
+        autotuneRegisterAllocation(funcName);
+    } else if (strategy != RegisterAllocStrategy::NAIVE) {
+        allocateRegisters(strategy);
+    }
 
     std::vector<std::string> asmInstructions;
 
-    // std::cerr << "开始处理IR指令, 总数: " << instructions.size() << "\n";
-    for (const auto& instr : instructions) {
+    for (const auto& instr : functionInstrs) {
         std::stringstream tempOutput;
-        std::streampos originalPos = output.tellp();
         
         processInstructionToStream(instr, tempOutput);
         
@@ -65,8 +107,6 @@ void CodeGenerator::generate() {
             }
         }
     }
-    
-    // std::cerr << "IR指令处理完成\n";
 
     if (config.enablePeepholeOptimizations) {
         peepholeOptimize(asmInstructions);
@@ -80,7 +120,7 @@ void CodeGenerator::generate() {
         output << "\t" << instr << "\n";
     }
 
-    // std::cerr << "generate方法执行完成\n";
+    // std::cerr << "generateFunction方法执行完成\n";
 }
 
 // ==================== 指令流处理 ====================
@@ -131,10 +171,6 @@ void CodeGenerator::processInstruction(const std::shared_ptr<IRInstr>& instr) {
             processIfGoto(std::dynamic_pointer_cast<IfGotoInstr>(instr));
             break;
             
-        case OpCode::PARAM:
-            processParam(std::dynamic_pointer_cast<ParamInstr>(instr));
-            break;
-            
         case OpCode::CALL:
             processCall(std::dynamic_pointer_cast<CallInstr>(instr));
             break;
@@ -287,6 +323,16 @@ void CodeGenerator::processUnaryOp(const std::shared_ptr<UnaryOpInstr>& instr) {
 
 void CodeGenerator::processAssign(const std::shared_ptr<AssignInstr>& instr) {
     emitComment(instr->toString());
+
+    // 两边分在同一个寄存器里（合并了的复制）时不用搬
+    if (instr->source->type != OperandType::CONSTANT) {
+        auto from = regAlloc.find(instr->source->name);
+        auto to = regAlloc.find(instr->target->name);
+        if (from != regAlloc.end() && to != regAlloc.end() && from->second == to->second &&
+            isValidRegister(from->second)) {
+            return;
+        }
+    }
     
     std::string reg = allocTempReg();
     loadOperand(instr->source, reg);
@@ -308,11 +354,6 @@ void CodeGenerator::processIfGoto(const std::shared_ptr<IfGotoInstr>& instr) {
     freeTempReg(condReg);
 }
 
-void CodeGenerator::processParam(const std::shared_ptr<ParamInstr>& instr) {
-    emitComment(instr->toString());
-    paramQueue.push_back(instr->param);
-}
-
 void CodeGenerator::processCall(const std::shared_ptr<CallInstr>& instr) {
     if (!instr) {
         std::cerr << "错误: 空的函数调用指令" << std::endl;
@@ -320,63 +361,74 @@ void CodeGenerator::processCall(const std::shared_ptr<CallInstr>& instr) {
     }
 
     emitComment(instr->toString());
-    
-    int paramCount = instr->paramCount;
-    std::vector<std::shared_ptr<Operand>> params;
-    
-    if (!instr->params.empty()) {
-        params = instr->params;
-    } else if (!paramQueue.empty()) {
-        if (paramQueue.size() >= paramCount) {
-            size_t startIdx = paramQueue.size() - paramCount;
-            params.reserve(paramCount);
-            for (size_t i = 0; i < paramCount && (startIdx + i) < paramQueue.size(); ++i) {
-                params.push_back(paramQueue[startIdx + i]);
-            }
-        } else {
-            std::cerr << "错误: 参数队列大小不匹配, 预期 " << paramCount 
-                      << ", 实际 " << paramQueue.size() << std::endl;
-            return;
-        }
-    } else {
-        std::cerr << "错误: 没有可用的参数" << std::endl;
+
+    if (static_cast<int>(instr->params.size()) != instr->paramCount) {
+        std::cerr << "错误: 参数个数不匹配, 预期 " << instr->paramCount
+                  << ", 实际 " << instr->params.size() << std::endl;
         return;
     }
 
-    analyzeUsedCallerSavedRegs();
-    analyzeUsedCalleeSavedRegs();
-
-    saveCallerSavedRegs();
+    // t0–t6 不跨指令保存值，分配器也不会把跨过调用的名字放进被调函数改写的寄存器，
+    // 调用前后不必保存任何寄存器
+    emitArgumentMoves(instr->params);
+    emitInstruction("call " + instr->funcName);
 
-    for (int i = 0; i < std::min(8, paramCount); ++i) {
-        if (!params[i]) continue;
-        loadOperand(params[i], "a" + std::to_string(i));
+    if (instr->result) {
+        std::string resultReg = allocTempReg();
+        emitInstruction("addi " + resultReg + ", a0" + ", 0");
+        storeRegister(resultReg, instr->result);
+        freeTempReg(resultReg);
     }
+}
 
-    int stackParamOffset = 0;
-    for (int i = 8; i < paramCount; ++i) {
-        if (!params[i]) continue;
+void CodeGenerator::emitArgumentMoves(const std::vector<std::shared_ptr<Operand>>& args) {
+    // 第 9 个起的实参写到栈底预留的传出区，此时 a 寄存器还都没被改写
+    for (size_t i = 8; i < args.size(); ++i) {
         std::string tempReg = allocTempReg();
-        loadOperand(params[i], tempReg);
-        emitInstruction("sw " + tempReg + ", " + std::to_string(stackParamOffset) + "(sp)");
-        stackParamOffset += 4;
+        loadOperand(args[i], tempReg);
+        emitInstruction("sw " + tempReg + ", " + std::to_string((i - 8) * 4) + "(sp)");
         freeTempReg(tempReg);
     }
 
-    emitInstruction("call " + instr->funcName);
-    restoreCallerSavedRegs();
+    // 传参是一次并行赋值：实参可能就在别的 a 寄存器里，逐个装入会覆盖还没读走的值。
+    // 先做寄存器之间的搬移，目标不再被其他搬移读取时才写；剩下的都在环上，借临时寄存器拆开
+    std::vector<std::pair<std::string, std::string>> moves;   // 目标, 源
+    std::vector<size_t> loads;                                // 常量和栈上的实参
+    for (size_t i = 0; i < args.size() && i < argRegs.size(); ++i) {
+        auto it = args[i]->type == OperandType::CONSTANT ? regAlloc.end() : regAlloc.find(args[i]->name);
+        if (it == regAlloc.end()) {
+            loads.push_back(i);
+        } else if (it->second != argRegs[i]) {
+            moves.push_back({argRegs[i], it->second});
+        }
+    }
 
-    if (instr->result) {
-        std::string resultReg = allocTempReg();
-        emitInstruction("addi " + resultReg + ", a0" + ", 0");
-        storeRegister(resultReg, instr->result);
-        freeTempReg(resultReg);
+    while (!moves.empty()) {
+        auto ready = std::find_if(moves.begin(), moves.end(), [&](const auto& move) {
+            return std::none_of(moves.begin(), moves.end(),
+                                [&](const auto& other) { return other.second == move.first; });
+        });
+        if (ready != moves.end()) {
+            emitInstruction("addi " + ready->first + ", " + ready->second + ", 0");
+            moves.erase(ready);
+            continue;
+        }
+        std::string tempReg = allocTempReg();
+        std::string saved = moves.front().first;
+        emitInstruction("addi " + tempReg + ", " + saved + ", 0");
+        for (auto& move : moves) {
+            if (move.second == saved) {
+                move.second = tempReg;
+            }
+        }
+        freeTempReg(tempReg);
     }
 
-    if (!instr->params.empty() && paramCount > 0) {
-        paramQueue.erase(paramQueue.end() - paramCount, paramQueue.end());
+    // 寄存器里的实参都已就位，最后装入常量和栈上的实参
+    for (size_t i : loads) {
+        loadOperand(args[i], argRegs[i]);
     }
-}                                     
+}
 
 void CodeGenerator::processReturn(const std::shared_ptr<ReturnInstr>& instr) {
     emitComment(instr->toString());
@@ -411,41 +463,37 @@ void CodeGenerator::processFunctionBegin(const std::shared_ptr<FunctionBeginInst
     frameInitialized = false;
 
     analyzeUsedCalleeSavedRegs();
-    
-    for (size_t i = 0; i < currentFunctionParams.size(); i++) {
-        if (i < 8) {
-            regAlloc[currentFunctionParams[i]] = "a" + std::to_string(i);
-        } else {
-            localVars[currentFunctionParams[i]] = -12 - (i-8)*4;
-            localVarsSize += 4;
-        }
+
+    // 第 9 个起的形参由调用者放在栈上，直接使用调用者栈帧里的位置
+    for (size_t i = 8; i < currentFunctionParams.size(); i++) {
+        localVars[currentFunctionParams[i]] = (i - 8) * 4;
     }
 
     emitGlobal(instr->funcName);
     emitLabel(instr->funcName);
+    // main 由外部调用，保持标准 ABI；其余函数登记摘要，供后面的调用者使用
+    if (currentFunction != "main") {
+        CallClobbers::Mask clobbered = functionClobbers();
+        callClobbers->record(currentFunction, clobbered);
+        output << CallClobbers::kCommentPrefix << CallClobbers::format(clobbered) << "\n";
+    }
     emitPrologue(instr->funcName);
 
     if (currentFunctionParams.empty()) {
         return;
     }
 
-    localVars.clear();
-
+    // 分到寄存器的形参只在需要换位置时挪一次，其余存进栈槽；
+    // 先取走 a 寄存器里的形参，再装入栈上的形参，装入时不会覆盖还没取走的实参
     emitComment("函数形参压栈");
-    for (size_t i = 0; i < currentFunctionParams.size(); i++) {
+    for (size_t i = 0; i < currentFunctionParams.size() && i < 8; i++) {
         std::shared_ptr<Operand> paramVar = std::make_shared<Operand>(OperandType::VARIABLE, currentFunctionParams[i]);
-        int offset = getOperandOffset(paramVar);
-        
-        if (i < 8) {
-            std::string argReg = getArgRegister(i);
-            regAlloc.erase(currentFunctionParams[i]);
-            emitInstruction("sw " + argReg + ", " + std::to_string(offset) + "(fp)");
-        } else {
-            std::string tempReg = allocTempReg();
-            int callerStackOffset = (i - 8) * 4 ;
-            emitInstruction("lw " + tempReg + ", " + std::to_string(callerStackOffset) + "(fp)");
-            emitInstruction("sw " + tempReg + ", " + std::to_string(offset) + "(fp)");
-            freeTempReg(tempReg);
+        storeRegister(getArgRegister(i), paramVar);
+    }
+    for (size_t i = 8; i < currentFunctionParams.size(); i++) {
+        auto it = regAlloc.find(currentFunctionParams[i]);
+        if (it != regAlloc.end()) {
+            emitInstruction("lw " + it->second + ", " + std::to_string((i - 8) * 4) + "(fp)");
         }
     }
 }
@@ -466,7 +514,8 @@ void CodeGenerator::processFunctionEnd(const std::shared_ptr<FunctionEndInstr>&
 // ==================== 输出辅助函数 ====================
 
 std::string CodeGenerator::genLabel() {
-    return "L" + std::to_string(labelCount++);
+    // 与 IR 标签 .L<函数名>.<n> 区分开，编号在函数内从零开始
+    return ".L" + currentFunction + ".s" + std::to_string(labelCount++);
 }
 
 void CodeGenerator::emitComment(const std::string& comment) {
@@ -496,10 +545,10 @@ void CodeGenerator::emitPrologue(const std::string& funcName) {
     
     resetStackOffset();
 
+    // 栈槽在生成过程中按首次出现的顺序分配，这里先算出需要的总数
     calleeRegsSize = countUsedCalleeSavedRegs() * 4;
-    callerRegsSize = countUsedCallerSavedRegs() * 4;
-    int localsAndPadding = analyzeTempVars();
-    int totalFrameSize = calleeRegsSize + callerRegsSize + localsAndPadding + 8;
+    int localsAndPadding = analyzeLocalSlots();
+    int totalFrameSize = calleeRegsSize + localsAndPadding + 8;
     totalFrameSize = (totalFrameSize + 15) & ~15;
     frameSize = totalFrameSize;
 
@@ -572,16 +621,17 @@ void CodeGenerator::emitEpilogue(const std::string& funcName) {
 // ==================== 寄存器管理 ====================
 
 void CodeGenerator::initializeRegisters() {
+    // t0–t6 留给每条指令内部做临时寄存器，s0 是帧指针，都不参与分配
     registers = {
         {"zero", false, false, false, true, "常量0", false},
-        {"t0", true, false, true, false, "临时寄存器0", false},
-        {"t1", true, false, true, false, "临时寄存器1", false},
-        {"t2", true, false, true, false, "临时寄存器2", false},
-        {"t3", true, false, true, false, "临时寄存器3", false},
-        {"t4", true, false, true, false, "临时寄存器4", false},
-        {"t5", true, false, true, false, "临时寄存器5", false},
-        {"t6", true, false, true, false, "临时寄存器6", false},
-        {"s0", false, true, true, false, "保存寄存器0/帧指针", false},
+        {"t0", true, false, false, false, "临时寄存器0", false},
+        {"t1", true, false, false, false, "临时寄存器1", false},
+        {"t2", true, false, false, false, "临时寄存器2", false},
+        {"t3", true, false, false, false, "临时寄存器3", false},
+        {"t4", true, false, false, false, "临时寄存器4", false},
+        {"t5", true, false, false, false, "临时寄存器5", false},
+        {"t6", true, false, false, false, "临时寄存器6", false},
+        {"s0", false, true, false, true, "保存寄存器0/帧指针", false},
         {"s1", false, true, true, false, "保存寄存器1", false},
         {"s2", false, true, true, false, "保存寄存器2", false},
         {"s3", false, true, true, false, "保存寄存器3", false},
@@ -624,7 +674,6 @@ std::string CodeGenerator::allocTempReg() {
                 return "";
             }
             reg.isUsed = true;
-            usedCallerSavedRegs.insert(reg.name);
             break;
         }
     }
@@ -637,36 +686,6 @@ void CodeGenerator::freeTempReg(const std::string& reg) {
 
 // ==================== 寄存器保存/恢复 ====================
 
-void CodeGenerator::saveCallerSavedRegs() {
-    emitComment("保存调用者保存的寄存器");
-    
-    for (const auto& reg : usedCallerSavedRegs) {
-        int offset = getRegisterStackOffset(reg);
-        if (std::abs(offset) <= 2047) {
-            emitInstruction("sw " + reg + ", " + std::to_string(offset) + "(fp)");
-        } else {
-            emitInstruction("li t0, " + std::to_string(offset));
-            emitInstruction("add t0, fp, t0");
-            emitInstruction("sw " + reg + ", 0(t0)");
-        }
-    }
-}
-
-void CodeGenerator::restoreCallerSavedRegs() {
-    emitComment("恢复调用者保存的寄存器");
-    
-    for (const auto& reg : usedCallerSavedRegs) {
-        int offset = getRegisterStackOffset(reg);
-        if (std::abs(offset) <= 2047) {
-            emitInstruction("lw " + reg + ", " + std::to_string(offset) + "(fp)");
-        } else {
-            emitInstruction("li t0, " + std::to_string(offset));
-            emitInstruction("add t0, fp, t0");
-            emitInstruction("lw " + reg + ", 0(t0)");
-        }
-    }
-}
-
 void CodeGenerator::saveCalleeSavedRegs() {
     emitComment("保存被调用者保存的寄存器");
     
@@ -716,10 +735,10 @@ void CodeGenerator::loadOperand(const std::shared_ptr<Operand>& op, const std::s
                     if (std::abs(offset) <= 2047) {
                         emitInstruction("lw " + reg + ", " + std::to_string(offset) + "(fp)");
                     } else {
-                        std::string tempReg = (reg != "t0") ? "t0" : "t1";
-                        emitInstruction("li " + tempReg + ", " + std::to_string(offset));
-                        emitInstruction("add " + tempReg + ", fp, " + tempReg);
-                        emitInstruction("lw " + reg + ", 0(" + tempReg + ")");
+                        // 地址算在目标寄存器里，不占用可能还存着另一个操作数的 t0
+                        emitInstruction("li " + reg + ", " + std::to_string(offset));
+                        emitInstruction("add " + reg + ", fp, " + reg);
+                        emitInstruction("lw " + reg + ", 0(" + reg + ")");
                     }
                 }
             }
@@ -814,101 +833,232 @@ int CodeGenerator::getRegisterStackOffset(const std::string& reg) {
 
 void CodeGenerator::analyzeUsedCalleeSavedRegs() {
     usedCalleeSavedRegs.clear();
-   
-   for(Register& reg : registers) {
-        if (reg.isCalleeSaved && reg.isUsed) {
-            usedCalleeSavedRegs.insert(reg.name);
+
+    // 只有寄存器分配器会用到 s 寄存器
+    for (const auto& [var, reg] : regAlloc) {
+        for (const Register& r : registers) {
+            if (r.name == reg && r.isCalleeSaved) {
+                usedCalleeSavedRegs.insert(reg);
+            }
         }
     }
 }
 
 int CodeGenerator::countUsedCalleeSavedRegs() {
-    int count = 0;
-
-    const std::vector<std::string> calleeSavedRegs = {
-        "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11"
-    };
+    return usedCalleeSavedRegs.size();
+}
 
-    for (const auto& instr : instructions) {
-        std::string s = instr->toString();
-        for (const auto& reg : calleeSavedRegs) {
-            if (s.find(reg) != std::string::npos) {
-                count++;
+CallClobbers::Mask CodeGenerator::functionClobbers() const {
+    // 临时寄存器随时会用到；s 寄存器在序言和后记里保存恢复，不算改写
+    CallClobbers::Mask mask = CallClobbers::bit("ra");
+    for (const auto& reg : tempRegs) {
+        mask |= CallClobbers::bit(reg);
+    }
+    for (const auto& [var, reg] : regAlloc) {
+        for (const Register& r : registers) {
+            if (r.name == reg && r.isCallerSaved) {
+                mask |= CallClobbers::bit(reg);
             }
         }
     }
-    return count;
+    if (currentFunctionReturnType != "void") {
+        mask |= CallClobbers::bit("a0");
+    }
+    for (const auto& instr : functionInstrs) {
+        if (auto call = std::dynamic_pointer_cast<CallInstr>(instr)) {
+            mask |= callClobbers->atCall(*call);
+        } else if (auto ret = std::dynamic_pointer_cast<ReturnInstr>(instr); ret && ret->value) {
+            mask |= CallClobbers::bit("a0");
+        }
+    }
+    return mask;
 }
 
-void CodeGenerator::analyzeUsedCallerSavedRegs() {
-    usedCallerSavedRegs.clear();
+// ==================== 寄存器分配策略 ====================
 
-    for(Register& reg : registers) {
-        if (reg.isCallerSaved && reg.isUsed) {
-            usedCallerSavedRegs.insert(reg.name);
-        }
-    }
+void CodeGenerator::allocateRegisters(RegisterAllocStrategy strategy) {
+    regAlloc = runAllocator(strategy, functionInstrs);
 }
 
-int CodeGenerator::countUsedCallerSavedRegs() {
-    int count = 0;
+std::map<std::string, std::string> CodeGenerator::runAllocator(
+    RegisterAllocStrategy strategy, std::vector<std::shared_ptr<IRInstr>>& instrs) const {
 
-    const std::vector<std::string> callerSavedRegs = {
-        "t0", "t1", "t2", "t3", "t4", "t5", "t6",
-        "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7",
-        "ra"
-    };
+    std::vector<Register> allocatableRegs;
+    for (const auto& reg : registers) {
+        if (reg.isAllocatable && !reg.isReserved) {
+            allocatableRegs.push_back(reg);
+        }
+    }
 
-    for (const auto& instr : instructions) {
-        std::string s = instr->toString();
-        for (const auto& reg : callerSavedRegs) {
-            if (s.find(reg) != std::string::npos) {
-                count++;
+    switch (strategy) {
+        case RegisterAllocStrategy::LINEAR_SCAN: {
+            LinearScanRegisterAllocator allocator;
+            allocator.setCallClobbers(callClobbers);
+            if (config.splitLiveRanges) {
+                return allocator.allocateWithSplitting(instrs, allocatableRegs);
             }
+            return allocator.allocate(instrs, allocatableRegs);
+        }
+        case RegisterAllocStrategy::GRAPH_COLOR: {
+            GraphColoringRegisterAllocator allocator;
+            allocator.setCallClobbers(callClobbers);
+            return allocator.allocate(instrs, allocatableRegs);
+        }
+        case RegisterAllocStrategy::SSA: {
+            SSARegisterAllocator allocator;
+            allocator.setCallClobbers(callClobbers);
+            return allocator.allocate(instrs, allocatableRegs);
         }
+        default:
+            return {};
     }
-    return count;
 }
 
-// ==================== 寄存器分配策略 ====================
+namespace {
 
-void CodeGenerator::allocateRegisters() {
-    switch (config.regAllocStrategy) {
-        case RegisterAllocStrategy::LINEAR_SCAN:
-            linearScanRegisterAllocation();
-            break;
-        case RegisterAllocStrategy::GRAPH_COLOR:
-            graphColoringRegisterAllocation();
-            break;
-        default:
-            break;
+const char* strategyName(RegisterAllocStrategy strategy) {
+    switch (strategy) {
+        case RegisterAllocStrategy::LINEAR_SCAN: return "linear";
+        case RegisterAllocStrategy::GRAPH_COLOR: return "graph";
+        case RegisterAllocStrategy::SSA: return "ssa";
+        default: return "naive";
     }
 }
 
-void CodeGenerator::linearScanRegisterAllocation() {
-    LinearScanRegisterAllocator allocator;
-    
-    std::vector<Register> allocatableRegs;
-    for (const auto& reg : registers) {
-        if (reg.isAllocatable && !reg.isReserved) {
-            allocatableRegs.push_back(reg);
+}  // namespace
+
+void CodeGenerator::autotuneRegisterAllocation(const std::string& funcName) {
+    // 每个候选在自己的指令副本上分配（切分和 SSA 会改写指令），互不影响，可以并行；
+    // 冲突图超出预算的函数不试图着色和 SSA
+    std::vector<RegisterAllocStrategy> strategies = {RegisterAllocStrategy::LINEAR_SCAN};
+    if (!config.graphColorBudget ||
+        FunctionSize::measure(functionInstrs).pairCost() <= config.graphColorBudget) {
+        strategies.push_back(RegisterAllocStrategy::GRAPH_COLOR);
+        strategies.push_back(RegisterAllocStrategy::SSA);
+    }
+    strategies.push_back(RegisterAllocStrategy::NAIVE);
+
+    struct Candidate {
+        std::vector<std::shared_ptr<IRInstr>> instrs;
+        std::map<std::string, std::string> allocation;
+        uint64_t cost = 0;
+    };
+    auto run = [this](RegisterAllocStrategy strategy, std::vector<std::shared_ptr<IRInstr>> instrs) {
+        Candidate candidate;
+        candidate.allocation = runAllocator(strategy, instrs);
+        candidate.cost = allocationCost(instrs, candidate.allocation);
+        candidate.instrs = std::move(instrs);
+        return candidate;
+    };
+
+    std::vector<Candidate> candidates(strategies.size());
+    if (std::thread::hardware_concurrency() > 1) {
+        std::vector<std::future<Candidate>> pending;
+        for (size_t i = 1; i < strategies.size(); ++i) {
+            pending.push_back(std::async(std::launch::async, run, strategies[i], functionInstrs));
+        }
+        candidates[0] = run(strategies[0], functionInstrs);
+        for (size_t i = 1; i < strategies.size(); ++i) {
+            candidates[i] = pending[i - 1].get();
+        }
+    } else {
+        for (size_t i = 0; i < strategies.size(); ++i) {
+            candidates[i] = run(strategies[i], functionInstrs);
         }
     }
-    
-    regAlloc = allocator.allocate(instructions, allocatableRegs);
+
+    // 代价相同时取排在前面的，简单的分配器优先
+    AllocatorChoice choice;
+    choice.function = funcName;
+    size_t best = 0;
+    for (size_t i = 0; i < strategies.size(); ++i) {
+        choice.costs.push_back({strategyName(strategies[i]), candidates[i].cost});
+        if (candidates[i].cost < candidates[best].cost) {
+            best = i;
+        }
+    }
+    choice.chosen = strategyName(strategies[best]);
+    allocatorChoices.push_back(std::move(choice));
+
+    functionInstrs = std::move(candidates[best].instrs);
+    regAlloc = std::move(candidates[best].allocation);
 }
 
-void CodeGenerator::graphColoringRegisterAllocation() {
-    GraphColoringRegisterAllocator allocator;
-    
-    std::vector<Register> allocatableRegs;
-    for (const auto& reg : registers) {
-        if (reg.isAllocatable && !reg.isReserved) {
-            allocatableRegs.push_back(reg);
+uint64_t CodeGenerator::allocationCost(const std::vector<std::shared_ptr<IRInstr>>& instrs,
+                                       const std::map<std::string, std::string>& allocation) {
+    // 访存记 2，寄存器间搬移记 1；循环里的指令按每层 8 倍加权，最多算 6 层
+    const uint64_t kMemory = 2;
+    const uint64_t kMove = 1;
+
+    std::map<std::string, int> labelIndex;
+    for (size_t i = 0; i < instrs.size(); ++i) {
+        if (auto label = std::dynamic_pointer_cast<LabelInstr>(instrs[i])) {
+            labelIndex[label->label] = static_cast<int>(i);
         }
     }
-    
-    regAlloc = allocator.allocate(instructions, allocatableRegs);
+    std::map<int, int> lastBackEdge;
+    for (size_t i = 0; i < instrs.size(); ++i) {
+        std::shared_ptr<Operand> target;
+        if (auto jump = std::dynamic_pointer_cast<GotoInstr>(instrs[i])) {
+            target = jump->target;
+        } else if (auto branch = std::dynamic_pointer_cast<IfGotoInstr>(instrs[i])) {
+            target = branch->target;
+        }
+        auto it = target ? labelIndex.find(target->name) : labelIndex.end();
+        if (it != labelIndex.end() && it->second <= static_cast<int>(i)) {
+            lastBackEdge[it->second] = std::max(lastBackEdge[it->second], static_cast<int>(i));
+        }
+    }
+    std::vector<int> depth(instrs.size() + 1, 0);
+    for (const auto& [first, last] : lastBackEdge) {
+        depth[first]++;
+        depth[last + 1]--;
+    }
+
+    auto inRegister = [&](const std::string& name) { return allocation.count(name) > 0; };
+    std::set<std::string> savedRegs;
+    for (const auto& [name, reg] : allocation) {
+        if (reg[0] == 's' && reg != "sp") {
+            savedRegs.insert(reg);
+        }
+    }
+    uint64_t cost = 2 * kMemory * savedRegs.size();
+
+    int level = 0;
+    for (size_t i = 0; i < instrs.size(); ++i) {
+        level += depth[i];
+        uint64_t weight = uint64_t(1) << (3 * std::min(level, 6));
+        const auto& instr = instrs[i];
+        if (auto begin = std::dynamic_pointer_cast<FunctionBeginInstr>(instr)) {
+            // 入口处把形参从 a<序号> 搬到分配的位置
+            for (size_t p = 0; p < begin->paramNames.size() && p < 8; ++p) {
+                auto it = allocation.find(begin->paramNames[p]);
+                if (it == allocation.end()) {
+                    cost += kMemory;
+                } else if (it->second != "a" + std::to_string(p)) {
+                    cost += kMove;
+                }
+            }
+            continue;
+        }
+        uint64_t local = 0;
+        for (const auto& var : IRAnalyzer::getUsedVariables(instr)) {
+            local += inRegister(var) ? 0 : kMemory;
+        }
+        for (const auto& var : IRAnalyzer::getDefinedVariables(instr)) {
+            local += inRegister(var) ? 0 : kMemory;
+        }
+        if (auto assign = std::dynamic_pointer_cast<AssignInstr>(instr)) {
+            auto target = allocation.find(assign->target->name);
+            auto source = assign->source->type == OperandType::CONSTANT
+                ? allocation.end() : allocation.find(assign->source->name);
+            if (target != allocation.end() && source != allocation.end() && target->second != source->second) {
+                local += kMove;
+            }
+        }
+        cost += weight * local;
+    }
+    return cost;
 }
 
 // ==================== 优化函数 ====================
@@ -956,35 +1106,38 @@ void CodeGenerator::optimizeStackLayout() {
     emitComment("栈布局优化结束，新栈大小: " + std::to_string(frameSize));
 }
 
-int CodeGenerator::analyzeTempVars() {
-    std::set<std::string> activeTemps;
-    int maxTempSize = 0;
-    
-    for (const auto& instr : instructions) {
-        auto defRegs = instr -> getDefRegisters();
-        auto useRegs = instr -> getUseRegisters();
-        
-        for (const auto& reg : defRegs) {
-            if (isTempReg(reg)) {
-                activeTemps.erase(reg);
-            }
+int CodeGenerator::analyzeLocalSlots() {
+    // 没分到寄存器的名字各占一个栈槽，栈上传入的形参用调用者的位置
+    std::set<std::string> names;
+    for (size_t i = 0; i < currentFunctionParams.size() && i < 8; i++) {
+        names.insert(currentFunctionParams[i]);
+    }
+    int outgoingSize = 0;
+    for (const auto& instr : functionInstrs) {
+        for (const auto& var : IRAnalyzer::getDefinedVariables(instr)) {
+            names.insert(var);
         }
-        
-        for (const auto& reg : useRegs) {
-            if (isTempReg(reg) && !isRegisterAllocated(reg)) {
-                activeTemps.insert(reg);
-            }
+        for (const auto& var : IRAnalyzer::getUsedVariables(instr)) {
+            names.insert(var);
+        }
+        // 第 9 个起的实参放在栈底，留出位置
+        if (auto call = std::dynamic_pointer_cast<CallInstr>(instr)) {
+            outgoingSize = std::max(outgoingSize, (call->paramCount - 8) * 4);
         }
-        
-        maxTempSize = std::max(maxTempSize, (int)activeTemps.size() * 4);
     }
-    
-    return maxTempSize;
+
+    int slots = 0;
+    for (const auto& name : names) {
+        if (!regAlloc.count(name) && !localVars.count(name)) {
+            slots++;
+        }
+    }
+    return slots * 4 + outgoingSize;
 }
 
 void CodeGenerator::analyzeVariableLifetimes(std::map<std::string, std::pair<int, int>>& varLifetimes) {
-    for (int i = 0; i < instructions.size(); i++) {
-        auto instr = instructions[i];
+    for (int i = 0; i < functionInstrs.size(); i++) {
+        auto instr = functionInstrs[i];
         
         auto defined = IRAnalyzer::getDefinedVariables(instr);
         for (const auto& var : defined) {
@@ -1175,7 +1328,7 @@ std::string CodeGenerator::getArgRegister(int paramIndex) const {
 // ==================== 寄存器分配器实现 ====================
 
 std::map<std::string, std::string> NaiveRegisterAllocator::allocate(
-    const std::vector<std::shared_ptr<IRInstr>>& instructions,
+    std::vector<std::shared_ptr<IRInstr>>& instructions,
     const std::vector<Register>& availableRegs) {
     std::map<std::string, std::string> allocation;
     
@@ -1221,285 +1374,364 @@ std::map<std::string, std::string> NaiveRegisterAllocator::allocate(
     return allocation;
 }
 
+namespace {
+
+// 名字可用的寄存器，按优先顺序排列：
+// 形参先试入口处所在的 a<序号>，其他名字先用不必保存的 a 寄存器，最后是 s1–s11；
+// 跨过调用的名字去掉这些调用会改写的寄存器，标准 ABI 下只剩 s 寄存器。
+// 形参不换到别的 a 寄存器，入口处的搬移因此不会互相覆盖
+std::vector<std::string> candidateRegisters(const LiveRange& range,
+                                            const std::vector<Register>& availableRegs) {
+    std::vector<std::string> argRegs;
+    std::vector<std::string> savedRegs;
+    for (const auto& reg : availableRegs) {
+        if (!reg.isAllocatable || reg.isReserved) {
+            continue;
+        }
+        if (reg.isCalleeSaved) {
+            savedRegs.push_back(reg.name);
+        } else if (reg.isCallerSaved) {
+            argRegs.push_back(reg.name);
+        }
+    }
+
+    std::vector<std::string> candidates;
+    auto add = [&](const std::string& reg) {
+        if (!(range.clobbered & CallClobbers::bit(reg))) {
+            candidates.push_back(reg);
+        }
+    };
+    if (range.paramIndex >= 0 && range.paramIndex < 8) {
+        add("a" + std::to_string(range.paramIndex));
+    } else {
+        std::for_each(argRegs.rbegin(), argRegs.rend(), add);
+    }
+    std::for_each(savedRegs.begin(), savedRegs.end(), add);
+    return candidates;
+}
+
+}  // namespace
+
 std::map<std::string, std::string> LinearScanRegisterAllocator::allocate(
-    const std::vector<std::shared_ptr<IRInstr>>& instructions,
+    std::vector<std::shared_ptr<IRInstr>>& instructions,
     const std::vector<Register>& availableRegs) {
     
     std::map<std::string, std::string> allocation;
     
-    std::vector<LiveInterval> intervals = computeLiveIntervals(instructions);
-    
-    // Prioritize variables that are likely loop counters/accumulators
-    auto isLoopVariable = [](const std::string& var) {
-        return var.find("i") == 0 || var.find("j") == 0 || var.find("k") == 0 || 
-               var.find("result") != std::string::npos || var.find("acc") != std::string::npos ||
-               var.find("t") == 0; // temp variables
-    };
-    
-    // Sort intervals, prioritizing loop variables
-    std::sort(intervals.begin(), intervals.end(), [&](const LiveInterval& a, const LiveInterval& b) {
-        bool aIsLoop = isLoopVariable(a.var);
-        bool bIsLoop = isLoopVariable(b.var);
-        if (aIsLoop != bIsLoop) return aIsLoop > bIsLoop;
-        return a.start < b.start;
-    });
-    
-    std::vector<std::string> freeRegs;
-    for (const auto& reg : availableRegs) {
-        if (reg.isCalleeSaved && reg.name != "fp" && reg.name != "s0") {
-            freeRegs.push_back(reg.name);
-        }
+    FunctionLiveness liveness(instructions, callClobbers);
+    const std::vector<LiveRange>& ranges = liveness.ranges();
+
+    // 按起点排序；同一起点上形参优先，保证它们先拿到入口处所在的寄存器
+    std::vector<int> order(ranges.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<int>(i);
     }
-    
-    std::map<std::string, std::pair<LiveInterval, std::string>> active;
-    
-    for (const auto& interval : intervals) {
-        std::vector<std::string> expired;
-        for (auto& [var, pair] : active) {
-            if (pair.first.end < interval.start) {
-                freeRegs.push_back(pair.second);
-                expired.push_back(var);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        if (ranges[a].start != ranges[b].start) return ranges[a].start < ranges[b].start;
+        if ((ranges[a].paramIndex >= 0) != (ranges[b].paramIndex >= 0)) return ranges[a].paramIndex >= 0;
+        return ranges[a].var < ranges[b].var;
+    });
+
+    std::map<std::string, int> owner;   // 寄存器 -> 当前占用它的区间
+    for (int current : order) {
+        const LiveRange& range = ranges[current];
+        for (auto it = owner.begin(); it != owner.end();) {
+            if (ranges[it->second].end < range.start) {
+                it = owner.erase(it);
+            } else {
+                ++it;
             }
         }
-        
-        for (const auto& var : expired) {
-            active.erase(var);
-        }
-        
-        if (freeRegs.empty()) {
-            // For loop variables, try harder to find a register
-            if (isLoopVariable(interval.var)) {
-                // Spill a non-loop variable if possible
-                std::string victimVar;
-                int latestEnd = -1;
-                
-                for (const auto& [var, pair] : active) {
-                    if (!isLoopVariable(var) && pair.first.end > latestEnd) {
-                        latestEnd = pair.first.end;
-                        victimVar = var;
-                    }
-                }
-                
-                if (!victimVar.empty()) {
-                    allocation[interval.var] = active[victimVar].second;
-                    freeRegs.push_back(active[victimVar].second);
-                    active.erase(victimVar);
-                    active[interval.var] = {interval, allocation[interval.var]};
-                    continue;
-                }
+
+        std::vector<std::string> candidates = candidateRegisters(range, availableRegs);
+        std::string chosen;
+        for (const auto& reg : candidates) {
+            if (!owner.count(reg)) {
+                chosen = reg;
+                break;
             }
-            
-            // Standard spilling
-            std::string victimVar;
-            int latestEnd = -1;
-            
-            for (const auto& [var, pair] : active) {
-                if (pair.first.end > latestEnd) {
-                    latestEnd = pair.first.end;
-                    victimVar = var;
+        }
+
+        if (chosen.empty()) {
+            // 没有空闲寄存器：在可用的寄存器里找结束最晚的区间，比当前区间晚就把它溢出
+            int victim = -1;
+            for (const auto& reg : candidates) {
+                int holder = owner[reg];
+                if (victim < 0 || ranges[holder].end > ranges[victim].end) {
+                    victim = holder;
                 }
             }
-            
-            if (latestEnd > interval.end && !victimVar.empty()) {
-                allocation[interval.var] = active[victimVar].second;
-                freeRegs.push_back(active[victimVar].second);
-                active.erase(victimVar);
-                
-                active[interval.var] = {interval, allocation[interval.var]};
+            if (victim < 0 || ranges[victim].end <= range.end) {
+                continue;
             }
-        } else {
-            std::string reg = freeRegs.back();
-            freeRegs.pop_back();
-            
-            allocation[interval.var] = reg;
-            active[interval.var] = {interval, reg};
+            chosen = allocation[ranges[victim].var];
+            allocation.erase(ranges[victim].var);
         }
+
+        allocation[range.var] = chosen;
+        owner[chosen] = current;
     }
     
     return allocation;
 }
 
-std::vector<LinearScanRegisterAllocator::LiveInterval> LinearScanRegisterAllocator::computeLiveIntervals(
-    const std::vector<std::shared_ptr<IRInstr>>& instructions) {
-    
-    std::map<std::string, LiveInterval> intervalMap;
-    
-    for (int i = 0; i < instructions.size(); i++) {
-        auto instr = instructions[i];
-        
-        auto defined = IRAnalyzer::getDefinedVariables(instr);
-        for (const auto& var : defined) {
-            if (intervalMap.find(var) == intervalMap.end()) {
-                intervalMap[var] = {var, i, i};
-            } else {
-                intervalMap[var].start = std::min(intervalMap[var].start, i);
-            }
-        }
-        
-        auto used = IRAnalyzer::getUsedVariables(instr);
-        for (const auto& var : used) {
-            if (intervalMap.find(var) == intervalMap.end()) {
-                intervalMap[var] = {var, i, i};
-            }
-            intervalMap[var].end = std::max(intervalMap[var].end, i);
+std::map<std::string, std::string> LinearScanRegisterAllocator::allocateWithSplitting(
+    std::vector<std::shared_ptr<IRInstr>>& instructions,
+    const std::vector<Register>& availableRegs) {
+
+    std::map<std::string, std::string> allocation = allocate(instructions, availableRegs);
+
+    FunctionLiveness liveness(instructions, callClobbers);
+    std::set<std::string> spilled;
+    for (const auto& range : liveness.ranges()) {
+        if (!allocation.count(range.var)) {
+            spilled.insert(range.var);
         }
     }
-    
-    std::vector<LiveInterval> intervals;
-    for (const auto& [var, interval] : intervalMap) {
-        intervals.push_back(interval);
+    if (spilled.empty()) {
+        return allocation;
     }
-    
-    return intervals;
+
+    LiveRangeSplitter splitter(instructions, liveness);
+    if (!splitter.split(spilled)) {
+        return allocation;
+    }
+    instructions = splitter.takeResult();
+    return allocate(instructions, availableRegs);
 }
 
 std::map<std::string, std::string> GraphColoringRegisterAllocator::allocate(
-    const std::vector<std::shared_ptr<IRInstr>>& instructions,
+    std::vector<std::shared_ptr<IRInstr>>& instructions,
     const std::vector<Register>& availableRegs) {
     
     std::map<std::string, std::string> allocation;
     
-    auto interferenceGraph = buildInterferenceGraph(instructions);
-    
-    if (interferenceGraph.empty()) {
-        return allocation;
-    }
-    
-    auto simplifiedOrder = simplify(interferenceGraph);
-    allocation = color(simplifiedOrder, interferenceGraph, availableRegs);
-    
-    return allocation;
-}
+    FunctionLiveness liveness(instructions, callClobbers);
+    const std::vector<LiveRange>& ranges = liveness.ranges();
+    std::vector<std::vector<int>> graph = liveness.interference();
 
-std::map<std::string, std::set<std::string>> GraphColoringRegisterAllocator::buildInterferenceGraph(
-    const std::vector<std::shared_ptr<IRInstr>>& instructions) {
-    
-    std::map<std::string, std::set<std::string>> graph;
-    
-    std::map<std::string, std::pair<int, int>> varLifetimes;
-    
-    for (int i = 0; i < instructions.size(); i++) {
-        auto instr = instructions[i];
-        
-        auto defined = IRAnalyzer::getDefinedVariables(instr);
-        for (const auto& var : defined) {
-            if (varLifetimes.find(var) == varLifetimes.end()) {
-                varLifetimes[var] = {i, i};
-            } else {
-                varLifetimes[var].first = std::min(varLifetimes[var].first, i);
+    // 逆序着色：先化简掉的名字最后着色，邻居已经着色的颜色不能再用
+    std::vector<int> order = simplify(graph);
+    std::vector<std::string> colors(ranges.size());
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        int node = *it;
+        std::set<std::string> usedColors;
+        for (int neighbor : graph[node]) {
+            if (!colors[neighbor].empty()) {
+                usedColors.insert(colors[neighbor]);
             }
         }
-        
-        auto used = IRAnalyzer::getUsedVariables(instr);
-        for (const auto& var : used) {
-            if (varLifetimes.find(var) == varLifetimes.end()) {
-                varLifetimes[var] = {i, i};
+        for (const auto& reg : candidateRegisters(ranges[node], availableRegs)) {
+            if (!usedColors.count(reg)) {
+                colors[node] = reg;
+                allocation[ranges[node].var] = reg;
+                break;
             }
-            varLifetimes[var].second = std::max(varLifetimes[var].second, i);
         }
     }
     
-    for (const auto& [var, _] : varLifetimes) {
-        graph[var] = std::set<std::string>();
-    }
-    
-    for (const auto& [var1, lifetime1] : varLifetimes) {
-        for (const auto& [var2, lifetime2] : varLifetimes) {
-            if (var1 != var2) {
-                int overlapStart = std::max(lifetime1.first, lifetime2.first);
-                int overlapEnd = std::min(lifetime1.second, lifetime2.second);
-                
-                if (overlapStart <= overlapEnd) {
-                    graph[var1].insert(var2);
-                    graph[var2].insert(var1);
-                }
+    return allocation;
+}
+
+std::vector<int> GraphColoringRegisterAllocator::simplify(
+    const std::vector<std::vector<int>>& graph) {
+    
+    std::vector<int> simplifiedOrder;
+    std::vector<int> degree(graph.size());
+    std::vector<bool> removed(graph.size(), false);
+    for (size_t i = 0; i < graph.size(); ++i) {
+        degree[i] = static_cast<int>(graph[i].size());
+    }
+
+    // 每次移走当前度数最小的节点
+    std::set<std::pair<int, int>> queue;
+    for (size_t i = 0; i < graph.size(); ++i) {
+        queue.insert({degree[i], static_cast<int>(i)});
+    }
+    while (!queue.empty()) {
+        int node = queue.begin()->second;
+        queue.erase(queue.begin());
+        removed[node] = true;
+        simplifiedOrder.push_back(node);
+        for (int neighbor : graph[node]) {
+            if (!removed[neighbor]) {
+                queue.erase({degree[neighbor], neighbor});
+                queue.insert({--degree[neighbor], neighbor});
             }
         }
     }
     
-    return graph;
+    return simplifiedOrder;
 }
 
-std::vector<std::string> GraphColoringRegisterAllocator::simplify(
-    std::map<std::string, std::set<std::string>>& graph) {
-    
-    std::vector<std::string> simplifiedOrder;
-    
-    auto workGraph = graph;
-    
-    while (!workGraph.empty()) {
-        std::string nodeToRemove;
-        int minDegree = std::numeric_limits<int>::max();
-        
-        for (const auto& [node, neighbors] : workGraph) {
-            if (neighbors.size() < minDegree) {
-                minDegree = neighbors.size();
-                nodeToRemove = node;
+std::map<std::string, std::string> SSARegisterAllocator::allocate(
+    std::vector<std::shared_ptr<IRInstr>>& instructions,
+    const std::vector<Register>& availableRegs) {
+
+    std::map<std::string, std::string> allocation;
+
+    SSAForm ssa(instructions);
+    instructions = ssa.takeResult();
+
+    FunctionLiveness liveness(instructions, callClobbers);
+    const std::vector<LiveRange>& ranges = liveness.ranges();
+    std::vector<bool> spilled = spill(instructions, liveness, availableRegs);
+    std::vector<std::vector<int>> graph = liveness.interference();
+
+    std::unordered_map<std::string, int> index;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        index[ranges[i].var] = static_cast<int>(i);
+    }
+
+    // 复制两端的名字，着色时优先用对方的寄存器
+    std::vector<std::vector<int>> partners(ranges.size());
+    for (const auto& instr : instructions) {
+        auto assign = std::dynamic_pointer_cast<AssignInstr>(instr);
+        if (!assign || assign->source->type == OperandType::CONSTANT) {
+            continue;
+        }
+        int target = index.at(assign->target->name);
+        int source = index.at(assign->source->name);
+        partners[target].push_back(source);
+        partners[source].push_back(target);
+    }
+
+    // 支配树先序的定义顺序；没有定义的名字（读到未定义的值）排在最后
+    std::vector<int> order;
+    std::vector<bool> queued(ranges.size(), false);
+    for (const auto& name : ssa.definitionOrder()) {
+        auto it = index.find(name);
+        if (it != index.end() && !queued[it->second]) {
+            queued[it->second] = true;
+            order.push_back(it->second);
+        }
+    }
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (!queued[i]) {
+            order.push_back(static_cast<int>(i));
+        }
+    }
+
+    std::vector<std::string> colors(ranges.size());
+    for (int node : order) {
+        if (spilled[node]) {
+            continue;
+        }
+        std::set<std::string> usedColors;
+        for (int neighbor : graph[node]) {
+            if (!colors[neighbor].empty()) {
+                usedColors.insert(colors[neighbor]);
             }
         }
-        
-        if (nodeToRemove.empty()) {
-            int maxDegree = -1;
-            for (const auto& [node, neighbors] : workGraph) {
-                if (neighbors.size() > maxDegree) {
-                    maxDegree = neighbors.size();
-                    nodeToRemove = node;
-                }
+        std::vector<std::string> candidates = candidateRegisters(ranges[node], availableRegs);
+        auto usable = [&](const std::string& reg) {
+            return !reg.empty() && !usedColors.count(reg) &&
+                   std::find(candidates.begin(), candidates.end(), reg) != candidates.end();
+        };
+        std::string chosen;
+        for (int partner : partners[node]) {
+            if (usable(colors[partner])) {
+                chosen = colors[partner];
+                break;
             }
         }
-        
-        for (auto& [_, neighbors] : workGraph) {
-            neighbors.erase(nodeToRemove);
+        for (size_t c = 0; chosen.empty() && c < candidates.size(); ++c) {
+            if (usable(candidates[c])) {
+                chosen = candidates[c];
+            }
+        }
+        if (!chosen.empty()) {
+            colors[node] = chosen;
+            allocation[ranges[node].var] = chosen;
         }
-        workGraph.erase(nodeToRemove);
-        
-        simplifiedOrder.push_back(nodeToRemove);
     }
-    
-    std::reverse(simplifiedOrder.begin(), simplifiedOrder.end());
-    return simplifiedOrder;
+
+    return allocation;
 }
 
-std::map<std::string, std::string> GraphColoringRegisterAllocator::color(
-    const std::vector<std::string>& simplifiedOrder,
-    const std::map<std::string, std::set<std::string>>& originalGraph,
+std::vector<bool> SSARegisterAllocator::spill(
+    const std::vector<std::shared_ptr<IRInstr>>& instructions,
+    const FunctionLiveness& liveness,
     const std::vector<Register>& availableRegs) {
-    
-    std::map<std::string, std::string> allocation;
-    
-    std::vector<std::string> regNames;
-    for (const auto& reg : availableRegs) {
-        if (reg.isAllocatable && !reg.isReserved) {
-            regNames.push_back(reg.name);
+
+    const std::vector<LiveRange>& ranges = liveness.ranges();
+    std::vector<bool> spilled(ranges.size(), false);
+    int n = static_cast<int>(instructions.size());
+
+    // 每个名字被读的指令下标
+    std::unordered_map<std::string, int> index;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        index[ranges[i].var] = static_cast<int>(i);
+    }
+    std::vector<std::vector<int>> uses(ranges.size());
+    for (int i = 0; i < n; ++i) {
+        for (const auto& var : IRAnalyzer::getUsedVariables(instructions[i])) {
+            uses[index.at(var)].push_back(i);
         }
     }
-    
-    for (const auto& var : simplifiedOrder) {
-        auto it = originalGraph.find(var);
-        if (it == originalGraph.end()) continue;
-        
-        const auto& neighbors = it->second;
-        
-        std::set<std::string> usedColors;
-        for (const auto& neighbor : neighbors) {
-            auto allocIt = allocation.find(neighbor);
-            if (allocIt != allocation.end()) {
-                usedColors.insert(allocIt->second);
+    // 第 i 条指令之后到下次读的距离；后面没有读时只可能经回边读到前面的，算作绕一圈
+    auto nextUse = [&](int name, int i) {
+        const auto& list = uses[name];
+        auto it = std::upper_bound(list.begin(), list.end(), i);
+        if (it != list.end()) {
+            return *it - i;
+        }
+        return list.empty() ? std::numeric_limits<int>::max() : n - i + list.front();
+    };
+
+    // 超出寄存器数的位置：定义处同时活跃的名字，以及跨过调用、需要调用不改写的寄存器的名字
+    struct Pressure {
+        int index;
+        std::vector<int> live;
+        size_t limit;
+    };
+    std::vector<Pressure> points;
+    size_t registerCount = candidateRegisters(LiveRange(), availableRegs).size();
+    liveness.forEachLiveAfter([&](int i, const std::vector<int>& live) {
+        const std::vector<int>& defs = liveness.definedAt(i);
+        std::vector<int> atDef = live;
+        for (int def : defs) {
+            if (std::find(live.begin(), live.end(), def) == live.end()) {
+                atDef.push_back(def);
             }
         }
-        
-        std::string selectedReg;
-        for (const auto& reg : regNames) {
-            if (usedColors.find(reg) == usedColors.end()) {
-                selectedReg = reg;
-                break;
+        if (atDef.size() > registerCount) {
+            points.push_back({i, atDef, registerCount});
+        }
+        if (instructions[i]->opcode == OpCode::CALL) {
+            LiveRange across;
+            across.clobbered = callClobbers ? callClobbers->atCall(static_cast<const CallInstr&>(*instructions[i]))
+                                            : CallClobbers::standard();
+            size_t limit = candidateRegisters(across, availableRegs).size();
+            std::vector<int> crossing;
+            for (int name : live) {
+                if (std::find(defs.begin(), defs.end(), name) == defs.end()) {
+                    crossing.push_back(name);
+                }
+            }
+            if (crossing.size() > limit) {
+                points.push_back({i, crossing, limit});
             }
         }
-        
-        if (!selectedReg.empty()) {
-            allocation[var] = selectedReg;
+    });
+
+    // 按程序顺序处理，每处溢出下次使用最远的名字，直到不超过寄存器数
+    std::sort(points.begin(), points.end(),
+              [](const Pressure& a, const Pressure& b) { return a.index < b.index; });
+    for (const Pressure& point : points) {
+        std::vector<int> held;
+        for (int name : point.live) {
+            if (!spilled[name]) {
+                held.push_back(name);
+            }
+        }
+        while (held.size() > point.limit) {
+            auto victim = std::max_element(held.begin(), held.end(), [&](int a, int b) {
+                return nextUse(a, point.index) < nextUse(b, point.index);
+            });
+            spilled[*victim] = true;
+            held.erase(victim);
         }
     }
-    
-    return allocation;
-}
\ No newline at end of file
+    return spilled;
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include "parser/ast.h"
 #include "ir/ir.h"
+#include "ir/budget.h"
+#include "codegen/liveness.h"
+#include "codegen/call_clobbers.h"
 #include <vector>
 #include <string>
 #include <map>
@@ -14,7 +17,9 @@
 enum class RegisterAllocStrategy {
     NAIVE,
     LINEAR_SCAN,
-    GRAPH_COLOR
+    GRAPH_COLOR,
+    SSA,
+    AUTO        // 每个函数试遍上面几种，取静态代价最小的
 };
 
 struct CodeGenConfig {
@@ -23,6 +28,18 @@ struct CodeGenConfig {
     bool enablePeepholeOptimizations = false;
     bool enableInlineAsm = false;
     RegisterAllocStrategy regAllocStrategy = RegisterAllocStrategy::NAIVE;
+    // 线性扫描溢出的名字在循环边界和调用处切开后重新分配
+    bool splitLiveRanges = false;
+    // 图着色和 SSA 分配冲突图的工作量预算（名字数²，见 ir/budget.h），0 表示不限；
+    // 超出时该函数改用线性扫描
+    uint64_t graphColorBudget = 4000000;
+};
+
+// -regalloc=auto 为一个函数选定的分配器，以及各候选分配结果的静态代价
+struct AllocatorChoice {
+    std::string function;
+    std::string chosen;
+    std::vector<std::pair<std::string, uint64_t>> costs;
 };
 
 struct Register {
@@ -40,9 +57,16 @@ struct Register {
 class RegisterAllocator {
 public:
     virtual ~RegisterAllocator() = default;
+    // 分配器可以改写 instructions（插入复制、重命名），代码按改写后的指令生成
     virtual std::map<std::string, std::string> allocate(
-        const std::vector<std::shared_ptr<IRInstr>>& instructions,
+        std::vector<std::shared_ptr<IRInstr>>& instructions,
         const std::vector<Register>& availableRegs) = 0;
+
+    // 调用处按被调函数的摘要避开寄存器；不设置时按标准 ABI
+    void setCallClobbers(const CallClobbers* table) { callClobbers = table; }
+
+protected:
+    const CallClobbers* callClobbers = nullptr;
 };
 
 // ==================== 简单寄存器分配器 ====================
@@ -50,52 +74,65 @@ public:
 class NaiveRegisterAllocator : public RegisterAllocator {
 public:
     std::map<std::string, std::string> allocate(
-        const std::vector<std::shared_ptr<IRInstr>>& instructions,
+        std::vector<std::shared_ptr<IRInstr>>& instructions,
         const std::vector<Register>& availableRegs) override;
 };
 
 // ==================== 线性扫描寄存器分配器 ====================
 
+/**
+ * 按活跃区间的起点扫描，区间结束后归还寄存器；没有空闲寄存器时溢出结束最晚的区间。
+ * 前 8 个形参预着色为 a<序号>，跨过调用的区间只能用这些调用不改写的寄存器。
+ */
 class LinearScanRegisterAllocator : public RegisterAllocator {
 public:
     std::map<std::string, std::string> allocate(
-        const std::vector<std::shared_ptr<IRInstr>>& instructions,
+        std::vector<std::shared_ptr<IRInstr>>& instructions,
         const std::vector<Register>& availableRegs) override;
-    
-private:
-    struct LiveInterval {
-        std::string var;
-        int start;
-        int end;
-        
-        bool operator<(const LiveInterval& other) const {
-            return start < other.start;
-        }
-    };
-    
-    std::vector<LiveInterval> computeLiveIntervals(
-        const std::vector<std::shared_ptr<IRInstr>>& instructions);
+
+    // 先整体分配，再把溢出、又在循环里用到的名字切开（见 range_split.h）重新分配一次；
+    // 切开时 instructions 换成插入了复制的指令
+    std::map<std::string, std::string> allocateWithSplitting(
+        std::vector<std::shared_ptr<IRInstr>>& instructions,
+        const std::vector<Register>& availableRegs);
 };
 
 // ==================== 图着色寄存器分配器 ====================
 
+/**
+ * 在精确的冲突图上按最小度数化简，再逆序乐观着色；着不上色的名字留在栈上。
+ * 可用寄存器的限制与线性扫描相同。
+ */
 class GraphColoringRegisterAllocator : public RegisterAllocator {
 public:
     std::map<std::string, std::string> allocate(
-        const std::vector<std::shared_ptr<IRInstr>>& instructions,
+        std::vector<std::shared_ptr<IRInstr>>& instructions,
         const std::vector<Register>& availableRegs) override;
     
 private:
-    std::map<std::string, std::set<std::string>> buildInterferenceGraph(
-        const std::vector<std::shared_ptr<IRInstr>>& instructions);
-    
-    std::vector<std::string> simplify(
-        std::map<std::string, std::set<std::string>>& graph);
-    
-    std::map<std::string, std::string> color(
-        const std::vector<std::string>& simplifiedOrder,
-        const std::map<std::string, std::set<std::string>>& originalGraph,
-        const std::vector<Register>& availableRegs);
+    std::vector<int> simplify(const std::vector<std::vector<int>>& graph);
+};
+
+// ==================== SSA 寄存器分配器 ====================
+
+/**
+ * 先把函数改写成 SSA 形式（见 ssa.h），φ 换成入边上的并行复制，再在改写后的指令上分配：
+ * 1. 溢出：在同时活跃的名字超过寄存器数的地方，按 Belady 的 MIN 规则溢出下次使用最远的名字，
+ *    直到各处同时活跃的名字（MaxLive）不超过 K；跨调用的名字另按调用不改写的寄存器数计。
+ * 2. 着色：按支配树先序的定义顺序（弦图的完美消去序的逆序）逐个挑邻居没用的寄存器，
+ *    优先用复制另一端的寄存器，两端相同时复制不产生指令。
+ * 可用寄存器的限制与线性扫描相同；个别名字因此着不上色时留在栈上。
+ */
+class SSARegisterAllocator : public RegisterAllocator {
+public:
+    std::map<std::string, std::string> allocate(
+        std::vector<std::shared_ptr<IRInstr>>& instructions,
+        const std::vector<Register>& availableRegs) override;
+
+private:
+    std::vector<bool> spill(const std::vector<std::shared_ptr<IRInstr>>& instructions,
+                            const FunctionLiveness& liveness,
+                            const std::vector<Register>& availableRegs);
 };
 
 // ==================== 代码生成器主类 ====================
@@ -104,6 +141,7 @@ class CodeGenerator {
 private:
     std::ostream& output;
     const std::vector<std::shared_ptr<IRInstr>>& instructions;
+    std::vector<std::shared_ptr<IRInstr>> functionInstrs;   // 当前正在生成的函数
     CodeGenConfig config;
     
     // 寄存器信息
@@ -118,19 +156,20 @@ private:
     std::set<std::string> activeVars;
     std::map<std::string, int> regOffsetMap;
     std::set<std::string> usedCalleeSavedRegs;
-    std::set<std::string> usedCallerSavedRegs;
+
+    // 已生成函数的调用摘要；默认只记录本生成器生成过的函数
+    CallClobbers ownClobbers;
+    CallClobbers* callClobbers = &ownClobbers;
     
     // 函数上下文
     std::string currentFunction;
     std::string currentFunctionReturnType;
     std::vector<std::string> currentFunctionParams;
-    std::vector<std::shared_ptr<Operand>> paramQueue;
     
     // 栈状态
     int frameSize = 0;
     int localVarsSize = 0;
     int calleeRegsSize = 0;
-    int callerRegsSize = 0;
     int paramStackSize = 0;
     int currentStackOffset = 0;
     bool frameInitialized = false;
@@ -143,6 +182,8 @@ private:
     
     // 优化
     std::map<std::string, std::function<bool(std::vector<std::string>&)>> peepholePatterns;
+    std::vector<BudgetEvent> budgetEvents;
+    std::vector<AllocatorChoice> allocatorChoices;
 
 public:
     CodeGenerator(std::ostream& outputStream,  
@@ -150,12 +191,26 @@ public:
                  const CodeGenConfig& config = CodeGenConfig());
     ~CodeGenerator();
     
+    // 文件头 + 全部函数
     void generate();
+    // 只输出函数部分；每个函数的汇编只取决于它自己的 IR 和被调函数的摘要，可以按函数缓存后拼接
+    void generateFunctions();
+    static void emitFileHeader(std::ostream& stream);
     void processInstructionToStream(const std::shared_ptr<IRInstr>& instr, std::ostream& stream);
     void addPeepholePattern(const std::string& pattern, 
                            std::function<bool(std::vector<std::string>&)> handler);
 
+    // 与其他生成器共用调用摘要：逐个函数各用一个生成器时，由调用方按源码顺序传入同一张表
+    void setCallClobbers(CallClobbers& table) { callClobbers = &table; }
+
+    // 取走此前生成的函数因超出预算而降级的记录
+    std::vector<BudgetEvent> takeBudgetEvents() { return std::move(budgetEvents); }
+    // 取走 -regalloc=auto 下各函数的选择
+    std::vector<AllocatorChoice> takeAllocatorChoices() { return std::move(allocatorChoices); }
+
 private:
+    void generateFunction();
+
     // 标签和输出
     std::string genLabel();
     void emitComment(const std::string& comment);
@@ -171,8 +226,8 @@ private:
     void processAssign(const std::shared_ptr<AssignInstr>& instr);
     void processGoto(const std::shared_ptr<GotoInstr>& instr);
     void processIfGoto(const std::shared_ptr<IfGotoInstr>& instr);
-    void processParam(const std::shared_ptr<ParamInstr>& instr);
     void processCall(const std::shared_ptr<CallInstr>& instr);
+    void emitArgumentMoves(const std::vector<std::shared_ptr<Operand>>& args);
     void processReturn(const std::shared_ptr<ReturnInstr>& instr);
     void processLabel(const std::shared_ptr<LabelInstr>& instr);
     void processFunctionBegin(const std::shared_ptr<FunctionBeginInstr>& instr);
@@ -186,21 +241,25 @@ private:
     void freeTempReg(const std::string& reg);
     
     // 寄存器保存和恢复
-    void saveCallerSavedRegs();
-    void restoreCallerSavedRegs();
     void saveCalleeSavedRegs();
     void restoreCalleeSavedRegs();
     
     // 寄存器管理
     void initializeRegisters();
     void resetStackOffset();
-    void allocateRegisters();
+    void allocateRegisters(RegisterAllocStrategy strategy);
+    void autotuneRegisterAllocation(const std::string& funcName);
+    // 按 strategy 分配 instrs，可能改写 instrs；只读生成器状态，可以并行调用
+    std::map<std::string, std::string> runAllocator(RegisterAllocStrategy strategy,
+                                                    std::vector<std::shared_ptr<IRInstr>>& instrs) const;
+    // 分配结果的静态代价：溢出的读写、寄存器间搬移和 s 寄存器的保存恢复，按循环深度加权
+    static uint64_t allocationCost(const std::vector<std::shared_ptr<IRInstr>>& instrs,
+                                   const std::map<std::string, std::string>& allocation);
     bool isValidRegister(const std::string& reg) const;
     std::string getArgRegister(int paramIndex) const;
     void analyzeUsedCalleeSavedRegs();
-    void analyzeUsedCallerSavedRegs();
-    int countUsedCallerSavedRegs();
     int countUsedCalleeSavedRegs();
+    CallClobbers::Mask functionClobbers() const;
     int getRegisterStackOffset(const std::string& reg);
     
     // 栈帧管理
@@ -208,7 +267,6 @@ private:
     void emitEpilogue(const std::string& funcName);
     
     // 大小计算
-    int getCallerSavedRegsSize() const { return usedCallerSavedRegs.size() * 4; }
     int getCalleeSavedRegsSize() const { return usedCalleeSavedRegs.size() * 4; }
     int getTotalFrameSize() const {
         int total = getCalleeSavedRegsSize() + localVarsSize + 8;
@@ -220,12 +278,10 @@ private:
     // 优化方法
     void optimizeStackLayout();
     void peepholeOptimize(std::vector<std::string>& instructions);
-    void linearScanRegisterAllocation();
-    void graphColoringRegisterAllocation();
     
     // 分析方法
     void analyzeVariableLifetimes(std::map<std::string, std::pair<int, int>>& varLifetimes);
-    int analyzeTempVars();
+    int analyzeLocalSlots();
     std::map<std::string, std::set<std::string>> buildInterferenceGraph();
     
     // 辅助方法
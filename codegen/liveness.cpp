@@ -0,0 +1,216 @@
+#include "liveness.h"
+#include <limits>
+
+// ==================== 活跃性分析 ====================
+
+FunctionLiveness::FunctionLiveness(const std::vector<std::shared_ptr<IRInstr>>& instructions,
+                                   const CallClobbers* clobbers)
+    : instructions(instructions), clobbers(clobbers) {
+    collectNames();
+    buildBlocks();
+    solve();
+    computeRanges();
+}
+
+int FunctionLiveness::indexOf(const std::string& name) {
+    auto [it, inserted] = nameIndex.emplace(name, static_cast<int>(liveRanges.size()));
+    if (inserted) {
+        LiveRange range;
+        range.var = name;
+        range.start = std::numeric_limits<int>::max();
+        range.end = -1;
+        liveRanges.push_back(range);
+    }
+    return it->second;
+}
+
+void FunctionLiveness::collectNames() {
+    uses.resize(instructions.size());
+    defs.resize(instructions.size());
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        const auto& instr = instructions[i];
+        if (auto begin = std::dynamic_pointer_cast<FunctionBeginInstr>(instr)) {
+            for (size_t p = 0; p < begin->paramNames.size(); ++p) {
+                int name = indexOf(begin->paramNames[p]);
+                liveRanges[name].paramIndex = static_cast<int>(p);
+                defs[i].push_back(name);
+            }
+            continue;
+        }
+        for (const auto& var : IRAnalyzer::getUsedVariables(instr)) {
+            uses[i].push_back(indexOf(var));
+        }
+        for (const auto& var : IRAnalyzer::getDefinedVariables(instr)) {
+            defs[i].push_back(indexOf(var));
+        }
+    }
+    words = (liveRanges.size() + 63) / 64;
+}
+
+void FunctionLiveness::buildBlocks() {
+    // 标签和跳转之后的指令开始新的基本块
+    std::unordered_map<std::string, int> labelBlock;
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        OpCode opcode = instructions[i]->opcode;
+        bool afterJump = i > 0 && (instructions[i - 1]->opcode == OpCode::GOTO ||
+                                   instructions[i - 1]->opcode == OpCode::IF_GOTO ||
+                                   instructions[i - 1]->opcode == OpCode::RETURN);
+        if (blocks.empty() || opcode == OpCode::LABEL || afterJump) {
+            Block block;
+            block.first = block.last = static_cast<int>(i);
+            blocks.push_back(block);
+        }
+        blocks.back().last = static_cast<int>(i);
+        if (opcode == OpCode::LABEL) {
+            labelBlock[std::static_pointer_cast<LabelInstr>(instructions[i])->label] =
+                static_cast<int>(blocks.size()) - 1;
+        }
+    }
+
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const auto& last = instructions[blocks[b].last];
+        std::shared_ptr<Operand> target;
+        bool fallsThrough = true;
+        if (last->opcode == OpCode::GOTO) {
+            target = std::static_pointer_cast<GotoInstr>(last)->target;
+            fallsThrough = false;
+        } else if (last->opcode == OpCode::IF_GOTO) {
+            target = std::static_pointer_cast<IfGotoInstr>(last)->target;
+        } else if (last->opcode == OpCode::RETURN || last->opcode == OpCode::FUNCTION_END) {
+            fallsThrough = false;
+        }
+        if (target) {
+            auto it = labelBlock.find(target->name);
+            if (it != labelBlock.end()) {
+                blocks[b].successors.push_back(it->second);
+            }
+        }
+        if (fallsThrough && b + 1 < blocks.size()) {
+            blocks[b].successors.push_back(static_cast<int>(b) + 1);
+        }
+    }
+}
+
+FunctionLiveness::Bits FunctionLiveness::liveOut(const Block& block) const {
+    Bits out(words, 0);
+    for (int succ : block.successors) {
+        const Bits& in = liveIn[succ];
+        for (size_t w = 0; w < words; ++w) {
+            out[w] |= in[w];
+        }
+    }
+    return out;
+}
+
+void FunctionLiveness::stepBackward(Bits& live, int index) const {
+    for (int name : defs[index]) {
+        live[name / 64] &= ~(uint64_t(1) << (name % 64));
+    }
+    for (int name : uses[index]) {
+        live[name / 64] |= uint64_t(1) << (name % 64);
+    }
+}
+
+void FunctionLiveness::solve() {
+    liveIn.assign(blocks.size(), Bits(words, 0));
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = blocks.size(); b-- > 0;) {
+            Bits live = liveOut(blocks[b]);
+            for (int i = blocks[b].last; i >= blocks[b].first; --i) {
+                stepBackward(live, i);
+            }
+            if (live != liveIn[b]) {
+                liveIn[b] = std::move(live);
+                changed = true;
+            }
+        }
+    }
+}
+
+void FunctionLiveness::computeRanges() {
+    // 区间端点只可能落在块边界或定义、使用处，不必逐条指令展开活跃集合
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        for (int name : uses[i]) {
+            mark(name, 2 * static_cast<int>(i));
+        }
+        for (int name : defs[i]) {
+            mark(name, 2 * static_cast<int>(i) + 1);
+        }
+    }
+
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const Block& block = blocks[b];
+        forEach(liveIn[b], [&](int name) { mark(name, 2 * block.first); });
+        Bits live = liveOut(block);
+        forEach(live, [&](int name) { mark(name, 2 * block.last + 1); });
+
+        // 调用之后仍然活跃的名字不能放在这次调用会改写的寄存器里。
+        // 只在调用处用作实参的名字不受影响，传参按并行赋值处理
+        for (int i = block.last; i >= block.first; --i) {
+            if (instructions[i]->opcode == OpCode::CALL) {
+                const auto& call = static_cast<const CallInstr&>(*instructions[i]);
+                CallClobbers::Mask mask = clobbers ? clobbers->atCall(call) : CallClobbers::standard();
+                forEach(live, [&](int name) {
+                    if (std::find(defs[i].begin(), defs[i].end(), name) == defs[i].end()) {
+                        liveRanges[name].clobbered |= mask;
+                        liveRanges[name].crossedCalls.push_back(i);
+                    }
+                });
+            }
+            stepBackward(live, i);
+        }
+    }
+
+    for (auto& range : liveRanges) {
+        if (range.end < range.start) {
+            range.start = range.end = 0;
+        }
+    }
+}
+
+bool FunctionLiveness::liveAtEntry(size_t block, const std::string& name) const {
+    auto it = nameIndex.find(name);
+    if (it == nameIndex.end()) {
+        return false;
+    }
+    return (liveIn[block][it->second / 64] >> (it->second % 64)) & 1;
+}
+
+void FunctionLiveness::forEachLiveAfter(
+    const std::function<void(int index, const std::vector<int>& live)>& fn) const {
+    std::vector<int> names;
+    for (const Block& block : blocks) {
+        Bits live = liveOut(block);
+        for (int i = block.last; i >= block.first; --i) {
+            names.clear();
+            forEach(live, [&](int name) { names.push_back(name); });
+            fn(i, names);
+            stepBackward(live, i);
+        }
+    }
+}
+
+std::vector<std::vector<int>> FunctionLiveness::interference() const {
+    std::vector<std::vector<int>> graph(liveRanges.size());
+    for (const Block& block : blocks) {
+        Bits live = liveOut(block);
+        for (int i = block.last; i >= block.first; --i) {
+            for (int def : defs[i]) {
+                forEach(live, [&](int name) {
+                    if (name != def) {
+                        graph[def].push_back(name);
+                        graph[name].push_back(def);
+                    }
+                });
+            }
+            stepBackward(live, i);
+        }
+    }
+    for (auto& neighbors : graph) {
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    }
+    return graph;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "ir/ir.h"
+#include "codegen/call_clobbers.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ==================== 活跃性分析 ====================
+
+/**
+ * 一个名字在函数内的活跃区间。
+ *
+ * 第 i 条指令占两个位置：2i 读操作数，2i+1 写结果。代码生成总是先把操作数读进临时寄存器
+ * 再写结果，所以某条指令最后一次读的名字和它定义的名字区间不相交，可以共用一个寄存器。
+ * 区间取所有活跃位置的包络，在循环回边上活跃的名字会覆盖整个循环。
+ */
+struct LiveRange {
+    std::string var;
+    int start = 0;
+    int end = 0;
+    CallClobbers::Mask clobbered = 0;   // 跨过的调用会改写的寄存器
+    std::vector<int> crossedCalls;      // 跨过的调用指令下标
+    int paramIndex = -1;        // 形参序号；前 8 个形参在入口处位于 a<序号>
+};
+
+/**
+ * 单个函数的活跃性：按基本块做后向数据流，活跃集合用位向量表示，只保存每个块入口的集合。
+ * 形参视为在 function begin 处定义，call 的实参在 call 处使用。
+ * 线性扫描用 ranges()，图着色再用 interference() 取得精确的冲突关系。
+ * 调用改写哪些寄存器查 clobbers；不给时每个调用都按标准 ABI 处理。
+ */
+class FunctionLiveness {
+public:
+    // 基本块：从标签或跳转之后开始，successors 是块下标
+    struct Block {
+        int first = 0;
+        int last = 0;
+        std::vector<int> successors;
+    };
+
+    explicit FunctionLiveness(const std::vector<std::shared_ptr<IRInstr>>& instructions,
+                              const CallClobbers* clobbers = nullptr);
+
+    const std::vector<LiveRange>& ranges() const { return liveRanges; }
+    const LiveRange* find(const std::string& name) const {
+        auto it = nameIndex.find(name);
+        return it == nameIndex.end() ? nullptr : &liveRanges[it->second];
+    }
+
+    // 定义点上与被定义名字同时活跃的名字互相冲突；下标与 ranges() 对应
+    std::vector<std::vector<int>> interference() const;
+
+    const std::vector<Block>& blockList() const { return blocks; }
+    bool liveAtEntry(size_t block, const std::string& name) const;
+    const std::vector<int>& definedAt(int index) const { return defs[index]; }
+    // 对每条指令给出它执行之后仍然活跃的名字（下标与 ranges() 对应），块内从后往前
+    void forEachLiveAfter(const std::function<void(int index, const std::vector<int>& live)>& fn) const;
+
+private:
+    using Bits = std::vector<uint64_t>;
+
+    const std::vector<std::shared_ptr<IRInstr>>& instructions;
+    const CallClobbers* clobbers;
+    std::unordered_map<std::string, int> nameIndex;
+    std::vector<LiveRange> liveRanges;
+    std::vector<std::vector<int>> uses;
+    std::vector<std::vector<int>> defs;
+    std::vector<Block> blocks;
+    std::vector<Bits> liveIn;
+    size_t words = 0;
+
+    int indexOf(const std::string& name);
+    void collectNames();
+    void buildBlocks();
+    void solve();
+    void computeRanges();
+
+    Bits liveOut(const Block& block) const;
+    void stepBackward(Bits& live, int index) const;
+
+    void mark(int name, int position) {
+        LiveRange& range = liveRanges[name];
+        range.start = std::min(range.start, position);
+        range.end = std::max(range.end, position);
+    }
+
+    // 依次对集合里的每个名字调用 fn
+    template <typename Fn>
+    static void forEach(const Bits& bits, Fn fn) {
+        for (size_t w = 0; w < bits.size(); ++w) {
+            uint64_t word = bits[w];
+            while (word) {
+                fn(static_cast<int>(w * 64 + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+};
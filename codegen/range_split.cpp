@@ -0,0 +1,216 @@
+#include "range_split.h"
+#include <algorithm>
+
+namespace {
+
+// 复制一条指令并换掉其中的名字；指令与别处共享，不能原地修改
+std::shared_ptr<IRInstr> renameInstr(const std::shared_ptr<IRInstr>& instr,
+                                     const std::map<std::string, std::string>& names) {
+    if (names.empty()) {
+        return instr;
+    }
+    return IRAnalyzer::rewriteOperands(instr, [&](const std::shared_ptr<Operand>& op, bool) {
+        auto it = names.find(op->name);
+        return it == names.end() ? op : std::make_shared<Operand>(op->type, it->second);
+    });
+}
+
+// 指令里出现的变量和临时变量操作数
+std::vector<std::shared_ptr<Operand>> operandsOf(const std::shared_ptr<IRInstr>& instr) {
+    if (auto bin = std::dynamic_pointer_cast<BinaryOpInstr>(instr)) {
+        return {bin->result, bin->left, bin->right};
+    }
+    if (auto unary = std::dynamic_pointer_cast<UnaryOpInstr>(instr)) {
+        return {unary->result, unary->operand};
+    }
+    if (auto assign = std::dynamic_pointer_cast<AssignInstr>(instr)) {
+        return {assign->target, assign->source};
+    }
+    if (auto ifGoto = std::dynamic_pointer_cast<IfGotoInstr>(instr)) {
+        return {ifGoto->condition};
+    }
+    if (auto call = std::dynamic_pointer_cast<CallInstr>(instr)) {
+        std::vector<std::shared_ptr<Operand>> operands = call->params;
+        operands.push_back(call->result);
+        return operands;
+    }
+    if (auto ret = std::dynamic_pointer_cast<ReturnInstr>(instr)) {
+        return {ret->value};
+    }
+    return {};
+}
+
+}  // namespace
+
+LiveRangeSplitter::LiveRangeSplitter(const std::vector<std::shared_ptr<IRInstr>>& instructions,
+                                     const FunctionLiveness& liveness)
+    : instructions(instructions), liveness(liveness) {
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        if (auto label = std::dynamic_pointer_cast<LabelInstr>(instructions[i])) {
+            labelIndex[label->label] = static_cast<int>(i);
+        }
+        for (const auto& op : operandsOf(instructions[i])) {
+            if (op && (op->type == OperandType::VARIABLE || op->type == OperandType::TEMP)) {
+                types.emplace(op->name, op->type);
+            }
+        }
+    }
+    findLoops();
+}
+
+int LiveRangeSplitter::jumpTarget(int index) const {
+    std::shared_ptr<Operand> target;
+    if (auto jump = std::dynamic_pointer_cast<GotoInstr>(instructions[index])) {
+        target = jump->target;
+    } else if (auto branch = std::dynamic_pointer_cast<IfGotoInstr>(instructions[index])) {
+        target = branch->target;
+    }
+    if (!target) {
+        return -1;
+    }
+    auto it = labelIndex.find(target->name);
+    return it == labelIndex.end() ? -1 : it->second;
+}
+
+void LiveRangeSplitter::findLoops() {
+    // 每个循环头取最远的回边
+    std::map<int, int> lastBackEdge;
+    std::vector<int> callsBefore(instructions.size() + 1, 0);
+    for (int j = 0; j < static_cast<int>(instructions.size()); ++j) {
+        callsBefore[j + 1] = callsBefore[j] + (instructions[j]->opcode == OpCode::CALL);
+        int target = jumpTarget(j);
+        if (target < 0) {
+            continue;
+        }
+        jumps.push_back({j, target});
+        if (target <= j) {
+            int& last = lastBackEdge[target];
+            last = std::max(last, j);
+        }
+    }
+
+    for (const auto& [first, last] : lastBackEdge) {
+        Loop loop;
+        loop.first = first;
+        loop.last = last;
+        loop.hasCall = callsBefore[last + 1] > callsBefore[first];
+        for (const auto& [from, target] : jumps) {
+            // 条件跳转进出循环时，复制只能放在新开的边上，这里不处理
+            if (loop.contains(from) != loop.contains(target) &&
+                instructions[from]->opcode == OpCode::IF_GOTO) {
+                loop.splittable = false;
+            }
+        }
+        loops.push_back(loop);
+    }
+}
+
+std::string LiveRangeSplitter::freshName(const std::string& name) {
+    // 源码中的名字不含点，不会与切出的名字冲突
+    std::string fresh = name + "." + std::to_string(nextSuffix[name]++);
+    types[fresh] = types.at(name);
+    return fresh;
+}
+
+std::shared_ptr<IRInstr> LiveRangeSplitter::copy(const std::string& to, const std::string& from) const {
+    OperandType type = types.at(from);
+    return std::make_shared<AssignInstr>(std::make_shared<Operand>(type, to),
+                                         std::make_shared<Operand>(type, from));
+}
+
+bool LiveRangeSplitter::split(const std::set<std::string>& names) {
+    renames.assign(instructions.size(), {});
+    before.assign(instructions.size(), {});
+    after.assign(instructions.size(), {});
+
+    // 每个名字出现在哪些指令里
+    std::map<std::string, std::vector<int>> references;
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        for (const auto& op : operandsOf(instructions[i])) {
+            if (op && names.count(op->name)) {
+                references[op->name].push_back(static_cast<int>(i));
+            }
+        }
+    }
+
+    bool changed = false;
+    for (const auto& [name, indices] : references) {
+        const LiveRange* range = liveness.find(name);
+        if (!range) {
+            continue;
+        }
+        // 优先切出最大的、没有调用的循环；区间本来就在循环里的不用切
+        const Loop* best = nullptr;
+        bool hot = false;
+        for (const Loop& loop : loops) {
+            bool used = std::any_of(indices.begin(), indices.end(),
+                                    [&](int i) { return loop.contains(i); });
+            if (!used) {
+                continue;
+            }
+            hot = true;
+            bool escapes = range->start < 2 * loop.first || range->end > 2 * loop.last + 1;
+            if (!loop.hasCall && loop.splittable && escapes &&
+                (!best || loop.last - loop.first > best->last - best->first)) {
+                best = &loop;
+            }
+        }
+        if (best) {
+            splitAtLoop(name, *best);
+            changed = true;
+        } else if (hot && !range->crossedCalls.empty()) {
+            splitAroundCalls(*range);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        rewrite();
+    }
+    return changed;
+}
+
+void LiveRangeSplitter::splitAtLoop(const std::string& name, const Loop& loop) {
+    std::string inner = freshName(name);
+    for (int i = loop.first; i <= loop.last; ++i) {
+        renames[i][name] = inner;
+    }
+
+    // 进入：从前一条指令顺序落入循环头，或从循环外无条件跳进来
+    OpCode previous = loop.first > 0 ? instructions[loop.first - 1]->opcode : OpCode::GOTO;
+    if (previous != OpCode::GOTO && previous != OpCode::RETURN) {
+        before[loop.first].push_back(copy(inner, name));
+    }
+    for (const auto& [from, target] : jumps) {
+        if (!loop.contains(from) && loop.contains(target)) {
+            before[from].push_back(copy(inner, name));
+        } else if (loop.contains(from) && !loop.contains(target)) {
+            before[from].push_back(copy(name, inner));
+        }
+    }
+
+    // 离开：最后一条回边不跳转时顺序落到循环后面
+    OpCode last = instructions[loop.last]->opcode;
+    if (last != OpCode::GOTO && last != OpCode::RETURN) {
+        after[loop.last].push_back(copy(name, inner));
+    }
+}
+
+void LiveRangeSplitter::splitAroundCalls(const LiveRange& range) {
+    // 每个调用各用一个新名字，避免跨调用的几小段又连成一整段
+    for (int call : range.crossedCalls) {
+        std::string saved = freshName(range.var);
+        before[call].push_back(copy(saved, range.var));
+        after[call].push_back(copy(range.var, saved));
+    }
+}
+
+void LiveRangeSplitter::rewrite() {
+    result.clear();
+    result.reserve(instructions.size());
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        result.insert(result.end(), before[i].begin(), before[i].end());
+        result.push_back(renameInstr(instructions[i], renames[i]));
+        result.insert(result.end(), after[i].begin(), after[i].end());
+    }
+}
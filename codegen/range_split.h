@@ -0,0 +1,65 @@
+#pragma once
+#include "ir/ir.h"
+#include "codegen/liveness.h"
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// ==================== 活跃区间切分 ====================
+
+/**
+ * 把名字的活跃区间切成几段，让每段单独分配位置。
+ *
+ * 切分在 IR 上完成：一段代码里的出现改成新名字，在进出这段代码的边上插入复制。
+ * 在调用不多的循环里频繁使用、在循环外又跨过调用的名字，整体上容易溢出；
+ * 把循环里的一段改名后，这段区间短且不跨调用，可以单独分到寄存器，复制只发生在进出循环时。
+ * 用在有调用的循环里的名字，改在它跨过的每个调用前后各切一刀，
+ * 只有跨调用的那一小段留在栈上或 s 寄存器里，其余部分可以放进 a 寄存器。
+ *
+ * 循环取 IR 中的回边：跳到前面标签的跳转和该标签之间的一段连续代码。
+ * 只切进出边都能直接放下复制的循环（顺序落入或无条件跳转）；有条件跳转进出的循环不切。
+ */
+class LiveRangeSplitter {
+public:
+    LiveRangeSplitter(const std::vector<std::shared_ptr<IRInstr>>& instructions,
+                      const FunctionLiveness& liveness);
+
+    // 切开 names 中能切的名字；没有改写时返回 false
+    bool split(const std::set<std::string>& names);
+    std::vector<std::shared_ptr<IRInstr>> takeResult() { return std::move(result); }
+
+private:
+    struct Loop {
+        int first = 0;   // 循环头标签
+        int last = 0;    // 最后一条回边
+        bool hasCall = false;
+        bool splittable = true;
+
+        bool contains(int index) const { return index >= first && index <= last; }
+    };
+
+    const std::vector<std::shared_ptr<IRInstr>>& instructions;
+    const FunctionLiveness& liveness;
+    std::vector<Loop> loops;
+    std::map<std::string, int> labelIndex;
+    std::vector<std::pair<int, int>> jumps;   // 跳转指令下标和目标标签下标
+    std::map<std::string, OperandType> types;
+
+    // 改写计划：每条指令里要换掉的名字，以及插在它前后的复制
+    std::vector<std::map<std::string, std::string>> renames;
+    std::vector<std::vector<std::shared_ptr<IRInstr>>> before;
+    std::vector<std::vector<std::shared_ptr<IRInstr>>> after;
+    std::map<std::string, int> nextSuffix;
+    std::vector<std::shared_ptr<IRInstr>> result;
+
+    void findLoops();
+    int jumpTarget(int index) const;
+    std::string freshName(const std::string& name);
+    std::shared_ptr<IRInstr> copy(const std::string& to, const std::string& from) const;
+
+    void splitAtLoop(const std::string& name, const Loop& loop);
+    void splitAroundCalls(const LiveRange& range);
+    void rewrite();
+};
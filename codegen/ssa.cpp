@@ -0,0 +1,386 @@
+#include "ssa.h"
+#include <algorithm>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+// ==================== SSA 形式 ====================
+
+SSAForm::SSAForm(const std::vector<std::shared_ptr<IRInstr>>& instructions)
+    : instructions(instructions), liveness(instructions), blocks(liveness.blockList()) {
+    for (const auto& instr : instructions) {
+        if (auto begin = std::dynamic_pointer_cast<FunctionBeginInstr>(instr)) {
+            funcName = begin->funcName;
+            for (const auto& param : begin->paramNames) {
+                types.emplace(param, OperandType::VARIABLE);
+            }
+        }
+        // 只为记下各名字的操作数类型，复制出的指令不用
+        IRAnalyzer::rewriteOperands(instr, [&](const std::shared_ptr<Operand>& op, bool) {
+            types.emplace(op->name, op->type);
+            return op;
+        });
+    }
+    buildEdges();
+    computeDominators();
+    placePhis();
+    rename();
+    emit();
+}
+
+void SSAForm::buildEdges() {
+    std::unordered_map<std::string, int> labelBlock;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (auto label = std::dynamic_pointer_cast<LabelInstr>(instructions[blocks[b].first])) {
+            labelBlock[label->label] = static_cast<int>(b);
+        }
+    }
+
+    outEdges.assign(blocks.size(), {});
+    preds.assign(blocks.size(), {});
+    auto addEdge = [&](int from, int to, bool branch) {
+        outEdges[from].push_back(static_cast<int>(edges.size()));
+        preds[to].push_back(static_cast<int>(edges.size()));
+        edges.push_back({from, to, branch});
+    };
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const auto& last = instructions[blocks[b].last];
+        std::shared_ptr<Operand> target;
+        bool fallsThrough = true;
+        if (auto jump = std::dynamic_pointer_cast<GotoInstr>(last)) {
+            target = jump->target;
+            fallsThrough = false;
+        } else if (auto branch = std::dynamic_pointer_cast<IfGotoInstr>(last)) {
+            target = branch->target;
+        } else if (last->opcode == OpCode::RETURN || last->opcode == OpCode::FUNCTION_END) {
+            fallsThrough = false;
+        }
+        if (target) {
+            auto it = labelBlock.find(target->name);
+            if (it != labelBlock.end()) {
+                addEdge(static_cast<int>(b), it->second, true);
+            }
+        }
+        if (fallsThrough && b + 1 < blocks.size()) {
+            addEdge(static_cast<int>(b), static_cast<int>(b) + 1, false);
+        }
+    }
+}
+
+void SSAForm::computeDominators() {
+    // 逆后序编号，再按 Cooper–Harvey–Kennedy 迭代求直接支配者
+    std::vector<int> postorder;
+    rpoNumber.assign(blocks.size(), -1);
+    std::vector<bool> visited(blocks.size(), false);
+    std::vector<std::pair<int, size_t>> stack = {{0, 0}};
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        if (next < outEdges[block].size()) {
+            int succ = edges[outEdges[block][next++]].to;
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.push_back({succ, 0});
+            }
+        } else {
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+    }
+    std::vector<int> rpo(postorder.rbegin(), postorder.rend());
+    for (size_t i = 0; i < rpo.size(); ++i) {
+        rpoNumber[rpo[i]] = static_cast<int>(i);
+    }
+
+    idom.assign(blocks.size(), -1);
+    idom[0] = 0;
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (rpoNumber[a] > rpoNumber[b]) a = idom[a];
+            while (rpoNumber[b] > rpoNumber[a]) b = idom[b];
+        }
+        return a;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); ++i) {
+            int block = rpo[i];
+            int dom = -1;
+            for (int e : preds[block]) {
+                int pred = edges[e].from;
+                if (idom[pred] >= 0) {
+                    dom = dom < 0 ? pred : intersect(pred, dom);
+                }
+            }
+            if (dom != idom[block]) {
+                idom[block] = dom;
+                changed = true;
+            }
+        }
+    }
+
+    domChildren.assign(blocks.size(), {});
+    for (int block : rpo) {
+        if (block != 0) {
+            domChildren[idom[block]].push_back(block);
+        }
+    }
+}
+
+void SSAForm::placePhis() {
+    // 支配边界：汇合块的每个前驱沿支配树向上，直到汇合块的直接支配者
+    std::vector<std::set<int>> frontier(blocks.size());
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (rpoNumber[b] < 0) {
+            continue;
+        }
+        std::vector<int> reachablePreds;
+        for (int e : preds[b]) {
+            if (rpoNumber[edges[e].from] >= 0) {
+                reachablePreds.push_back(edges[e].from);
+            }
+        }
+        if (reachablePreds.size() < 2) {
+            continue;
+        }
+        for (int runner : reachablePreds) {
+            while (runner != idom[b]) {
+                frontier[runner].insert(static_cast<int>(b));
+                runner = idom[runner];
+            }
+        }
+    }
+
+    std::map<std::string, std::vector<int>> defBlocks;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (rpoNumber[b] < 0) {
+            continue;
+        }
+        for (int i = blocks[b].first; i <= blocks[b].last; ++i) {
+            std::vector<std::string> defined;
+            if (auto begin = std::dynamic_pointer_cast<FunctionBeginInstr>(instructions[i])) {
+                defined = begin->paramNames;
+            } else {
+                defined = IRAnalyzer::getDefinedVariables(instructions[i]);
+            }
+            for (const auto& var : defined) {
+                auto& list = defBlocks[var];
+                if (list.empty() || list.back() != static_cast<int>(b)) {
+                    list.push_back(static_cast<int>(b));
+                }
+            }
+        }
+    }
+
+    phis.assign(blocks.size(), {});
+    for (const auto& [var, sites] : defBlocks) {
+        std::vector<int> work = sites;
+        std::set<int> placed;
+        while (!work.empty()) {
+            int block = work.back();
+            work.pop_back();
+            for (int join : frontier[block]) {
+                if (placed.count(join) || !liveness.liveAtEntry(join, var)) {
+                    continue;
+                }
+                placed.insert(join);
+                Phi phi;
+                phi.var = var;
+                phi.args.assign(preds[join].size(), "");
+                phis[join].push_back(phi);
+                work.push_back(join);
+            }
+        }
+    }
+}
+
+std::string SSAForm::freshName(const std::string& var) {
+    // 源码中的名字不含点，不会与新名字冲突
+    std::string fresh = var + "." + std::to_string(nextSuffix[var]++);
+    types[fresh] = types[var];
+    order.push_back(fresh);
+    return fresh;
+}
+
+std::shared_ptr<Operand> SSAForm::operand(const std::string& name) const {
+    auto it = types.find(name);
+    return std::make_shared<Operand>(it != types.end() ? it->second : OperandType::VARIABLE, name);
+}
+
+void SSAForm::rename() {
+    renamed = instructions;
+    std::map<std::string, std::vector<std::string>> current;
+
+    // 沿支配树深度优先；离开一个块时弹出它压入的版本
+    struct Frame {
+        int block;
+        bool leaving;
+    };
+    std::vector<Frame> stack = {{0, false}};
+    std::vector<std::vector<std::string>> pushedBy(blocks.size());
+    while (!stack.empty()) {
+        Frame frame = stack.back();
+        stack.pop_back();
+        int block = frame.block;
+        if (frame.leaving) {
+            for (const auto& var : pushedBy[block]) {
+                current[var].pop_back();
+            }
+            continue;
+        }
+
+        auto& pushed = pushedBy[block];
+        for (Phi& phi : phis[block]) {
+            phi.result = freshName(phi.var);
+            current[phi.var].push_back(phi.result);
+            pushed.push_back(phi.var);
+        }
+        for (int i = blocks[block].first; i <= blocks[block].last; ++i) {
+            if (auto begin = std::dynamic_pointer_cast<FunctionBeginInstr>(instructions[i])) {
+                for (const auto& param : begin->paramNames) {
+                    order.push_back(param);
+                    current[param].push_back(param);
+                    pushed.push_back(param);
+                }
+                continue;
+            }
+            renamed[i] = IRAnalyzer::rewriteOperands(instructions[i],
+                [&](const std::shared_ptr<Operand>& op, bool isDef) {
+                    auto& versions = current[op->name];
+                    if (isDef) {
+                        versions.push_back(freshName(op->name));
+                        pushed.push_back(op->name);
+                        return operand(versions.back());
+                    }
+                    // 没有到达的定义时沿用原名，与改写前一样读到未定义的值
+                    return versions.empty() ? op : operand(versions.back());
+                });
+        }
+        for (int e : outEdges[block]) {
+            int succ = edges[e].to;
+            size_t slot = std::find(preds[succ].begin(), preds[succ].end(), e) - preds[succ].begin();
+            for (Phi& phi : phis[succ]) {
+                const auto& versions = current[phi.var];
+                phi.args[slot] = versions.empty() ? "" : versions.back();
+            }
+        }
+
+        stack.push_back({block, true});
+        for (auto it = domChildren[block].rbegin(); it != domChildren[block].rend(); ++it) {
+            stack.push_back({*it, false});
+        }
+    }
+}
+
+std::vector<std::shared_ptr<IRInstr>> SSAForm::edgeCopies(int edge) {
+    const Edge& e = edges[edge];
+    size_t slot = std::find(preds[e.to].begin(), preds[e.to].end(), edge) - preds[e.to].begin();
+
+    // 待做的复制：（变量，结果，来源）
+    std::vector<std::tuple<std::string, std::string, std::string>> moves;
+    for (const Phi& phi : phis[e.to]) {
+        if (!phi.args[slot].empty() && phi.args[slot] != phi.result) {
+            moves.emplace_back(phi.var, phi.result, phi.args[slot]);
+        }
+    }
+
+    std::vector<std::shared_ptr<IRInstr>> copies;
+    auto copy = [&](const std::string& to, const std::string& from) {
+        copies.push_back(std::make_shared<AssignInstr>(operand(to), operand(from)));
+    };
+    while (!moves.empty()) {
+        // 先做结果不再被其他复制读取的那条
+        auto ready = std::find_if(moves.begin(), moves.end(), [&](const auto& move) {
+            return std::none_of(moves.begin(), moves.end(), [&](const auto& other) {
+                return std::get<2>(other) == std::get<1>(move);
+            });
+        });
+        if (ready != moves.end()) {
+            copy(std::get<1>(*ready), std::get<2>(*ready));
+            moves.erase(ready);
+            continue;
+        }
+        // 剩下的都在环上：把一个结果的旧值先挪到新名字里，环就断开了
+        const auto [var, to, from] = moves.front();
+        std::string saved = freshName(var);
+        copy(saved, to);
+        for (auto& move : moves) {
+            if (std::get<2>(move) == to) {
+                std::get<2>(move) = saved;
+            }
+        }
+    }
+    return copies;
+}
+
+std::string SSAForm::newLabel() {
+    // 与 IR 生成的 .L<函数名>.<n> 错开
+    return ".L" + funcName + ".ssa" + std::to_string(splitCount++);
+}
+
+void SSAForm::emit() {
+    result.clear();
+    result.reserve(instructions.size());
+    std::vector<std::shared_ptr<IRInstr>> splitBlocks;
+
+    auto append = [&](std::vector<std::shared_ptr<IRInstr>> copies) {
+        result.insert(result.end(), copies.begin(), copies.end());
+    };
+    auto labelOperand = [](const std::string& name) {
+        return std::make_shared<Operand>(OperandType::LABEL, name);
+    };
+
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        int last = blocks[b].last;
+        for (int i = blocks[b].first; i < last; ++i) {
+            result.push_back(renamed[i]);
+        }
+
+        int branchEdge = -1;
+        int fallEdge = -1;
+        for (int e : outEdges[b]) {
+            if (phis[edges[e].to].empty() || rpoNumber[b] < 0) {
+                continue;
+            }
+            (edges[e].branch ? branchEdge : fallEdge) = e;
+        }
+
+        const auto& instr = renamed[last];
+        if (instr->opcode == OpCode::FUNCTION_END && !splitBlocks.empty()) {
+            // 新开的块放在函数末尾；前面能顺序落下来时先跳过它们
+            OpCode previous = result.empty() ? OpCode::GOTO : result.back()->opcode;
+            std::string end = newLabel();
+            if (previous != OpCode::GOTO && previous != OpCode::RETURN) {
+                result.push_back(std::make_shared<GotoInstr>(labelOperand(end)));
+            }
+            append(splitBlocks);
+            result.push_back(std::make_shared<LabelInstr>(end));
+            result.push_back(instr);
+        } else if (instr->opcode == OpCode::GOTO) {
+            if (branchEdge >= 0) {
+                append(edgeCopies(branchEdge));
+            }
+            result.push_back(instr);
+        } else if (auto branch = std::dynamic_pointer_cast<IfGotoInstr>(instr)) {
+            if (branchEdge >= 0) {
+                std::string label = newLabel();
+                splitBlocks.push_back(std::make_shared<LabelInstr>(label));
+                auto copies = edgeCopies(branchEdge);
+                splitBlocks.insert(splitBlocks.end(), copies.begin(), copies.end());
+                splitBlocks.push_back(std::make_shared<GotoInstr>(branch->target));
+                result.push_back(std::make_shared<IfGotoInstr>(branch->condition, labelOperand(label)));
+            } else {
+                result.push_back(instr);
+            }
+            if (fallEdge >= 0) {
+                append(edgeCopies(fallEdge));
+            }
+        } else {
+            result.push_back(instr);
+            if (fallEdge >= 0) {
+                append(edgeCopies(fallEdge));
+            }
+        }
+    }
+}
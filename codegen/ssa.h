@@ -0,0 +1,76 @@
+#pragma once
+#include "ir/ir.h"
+#include "codegen/liveness.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ==================== SSA 形式 ====================
+
+/**
+ * 把一个函数的 IR 改写成 SSA 形式，再把 φ 换成入边上的复制，得到可以直接生成代码的 IR。
+ *
+ * 每次定义换一个新名字（名字.N）；形参的第一个版本保留原名，入口处的搬移不受影响。
+ * φ 按支配边界放置，只放在变量在块入口活跃的地方（剪枝 SSA）。
+ * 一个块的所有 φ 在每条入边上构成一组并行复制，按读写依赖排好顺序逐条生成，成环时借一个新名字。
+ * 复制放在前驱块末尾；条件跳转到带 φ 的块时（关键边），跳转改到函数末尾新开的块里做复制再跳回，
+ * 条件不成立顺序落入的边直接把复制放在条件跳转之后。
+ *
+ * 改写后除 φ 复制外每个名字只定义一次，定义支配所有使用，冲突图（几乎）是弦图：
+ * 按支配树先序的定义顺序贪心着色，用到的颜色数等于同时活跃名字数的最大值。
+ */
+class SSAForm {
+public:
+    explicit SSAForm(const std::vector<std::shared_ptr<IRInstr>>& instructions);
+
+    std::vector<std::shared_ptr<IRInstr>> takeResult() { return std::move(result); }
+    // 改写后的名字按定义在支配树先序中出现的顺序排列：形参，然后每个块的 φ 和块内定义
+    const std::vector<std::string>& definitionOrder() const { return order; }
+
+private:
+    struct Edge {
+        int from = 0;
+        int to = 0;
+        bool branch = false;   // 跳转边；false 为顺序落入
+    };
+
+    struct Phi {
+        std::string var;
+        std::string result;
+        std::vector<std::string> args;   // 与 preds[块] 一一对应；空串表示这条边上没有定义
+    };
+
+    const std::vector<std::shared_ptr<IRInstr>>& instructions;
+    FunctionLiveness liveness;
+    const std::vector<FunctionLiveness::Block>& blocks;
+    std::string funcName;
+
+    std::vector<Edge> edges;
+    std::vector<std::vector<int>> outEdges;   // 块 -> 出边下标
+    std::vector<std::vector<int>> preds;      // 块 -> 入边下标
+    std::vector<int> rpoNumber;               // 不可达的块为 -1
+    std::vector<int> idom;
+    std::vector<std::vector<int>> domChildren;
+
+    std::map<std::string, OperandType> types;
+    std::map<std::string, int> nextSuffix;
+    std::vector<std::vector<Phi>> phis;
+    std::vector<std::shared_ptr<IRInstr>> renamed;   // 与 instructions 对应
+    std::vector<std::string> order;
+    std::vector<std::shared_ptr<IRInstr>> result;
+    int splitCount = 0;
+
+    void buildEdges();
+    void computeDominators();
+    void placePhis();
+    void rename();
+    void emit();
+
+    std::string freshName(const std::string& var);
+    std::shared_ptr<Operand> operand(const std::string& name) const;
+    // 一条入边上 φ 的并行复制（结果，来源）排成顺序执行的赋值
+    std::vector<std::shared_ptr<IRInstr>> edgeCopies(int edge);
+    std::string newLabel();
+};
@@ -0,0 +1,369 @@
+#include "disk_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef TOYC_VERSION
+#define TOYC_VERSION "unknown"
+#endif
+
+static constexpr char kIndexMagic[8] = {'T', 'O', 'Y', 'C', 'I', 'D', 'X', '1'};
+static constexpr char kEntryMagic[8] = {'T', 'O', 'Y', 'C', 'E', 'N', 'T', '1'};
+static constexpr uint32_t kSlotCount = 8192;
+
+// 空槽与墓碑的键；真实键的 hi 不会为 0（见 normalize）
+static constexpr uint64_t kTombstoneLo = 1;
+
+struct DiskCache::IndexHeader {
+    char magic[8];
+    uint32_t slotCount;
+    uint32_t tombstones;
+    uint64_t totalBytes;
+    uint64_t clock;
+};
+
+struct DiskCache::IndexSlot {
+    uint64_t hi;
+    uint64_t lo;
+    uint64_t bytes;
+    uint64_t lastUse;
+};
+
+static DiskCache::Key normalize(DiskCache::Key key) {
+    if (key.hi == 0) key.hi = 1;
+    return key;
+}
+
+bool DiskCache::isEmpty(const IndexSlot& slot) { return slot.hi == 0 && slot.lo == 0; }
+bool DiskCache::isTombstone(const IndexSlot& slot) { return slot.hi == 0 && slot.lo == kTombstoneLo; }
+
+// 同一进程内用互斥量、跨进程用 flock 保护 index 的结构性修改
+class IndexLock {
+private:
+    std::lock_guard<std::mutex> guard;
+    int fd;
+
+public:
+    IndexLock(std::mutex& mutex, int fd) : guard(mutex), fd(fd) { ::flock(fd, LOCK_EX); }
+    ~IndexLock() { ::flock(fd, LOCK_UN); }
+};
+
+// ==================== 打开与关闭 ====================
+
+static bool makeDirectory(const std::string& path) {
+    return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+std::unique_ptr<DiskCache> DiskCache::open(const std::string& directory, uint64_t capacityBytes,
+                                           std::ostream& diag) {
+    if (!makeDirectory(directory) || !makeDirectory(directory + "/objects") ||
+        !makeDirectory(directory + "/tmp")) {
+        diag << "Warning: Cannot create cache directory " << directory << ": " << std::strerror(errno)
+             << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr<DiskCache> cache(new DiskCache(directory, capacityBytes));
+    std::string indexPath = directory + "/index";
+    cache->indexFd = ::open(indexPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (cache->indexFd < 0) {
+        diag << "Warning: Cannot open cache index " << indexPath << std::endl;
+        return nullptr;
+    }
+
+    cache->mappingSize = sizeof(IndexHeader) + sizeof(IndexSlot) * kSlotCount;
+    {
+        IndexLock lock(cache->processMutex, cache->indexFd);
+        struct stat info;
+        if (::fstat(cache->indexFd, &info) != 0) {
+            return nullptr;
+        }
+        if (static_cast<size_t>(info.st_size) != cache->mappingSize) {
+            // 新建或格式不符：按当前格式重新分配
+            if (::ftruncate(cache->indexFd, 0) != 0 ||
+                ::ftruncate(cache->indexFd, static_cast<off_t>(cache->mappingSize)) != 0) {
+                diag << "Warning: Cannot size cache index " << indexPath << std::endl;
+                return nullptr;
+            }
+        }
+        cache->mapping = ::mmap(nullptr, cache->mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                cache->indexFd, 0);
+        if (cache->mapping == MAP_FAILED) {
+            cache->mapping = nullptr;
+            diag << "Warning: Cannot map cache index " << indexPath << std::endl;
+            return nullptr;
+        }
+        IndexHeader& head = cache->header();
+        if (std::memcmp(head.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || head.slotCount != kSlotCount) {
+            std::memset(cache->mapping, 0, cache->mappingSize);
+            std::memcpy(head.magic, kIndexMagic, sizeof(kIndexMagic));
+            head.slotCount = kSlotCount;
+        }
+    }
+    return cache;
+}
+
+DiskCache::~DiskCache() {
+    if (mapping) {
+        ::munmap(mapping, mappingSize);
+    }
+    if (indexFd >= 0) {
+        ::close(indexFd);
+    }
+}
+
+DiskCache::IndexHeader& DiskCache::header() const {
+    return *static_cast<IndexHeader*>(mapping);
+}
+
+DiskCache::IndexSlot* DiskCache::slots() const {
+    return reinterpret_cast<IndexSlot*>(static_cast<char*>(mapping) + sizeof(IndexHeader));
+}
+
+std::string DiskCache::objectPath(const Key& key) const {
+    std::string hex = key.hex();
+    return directory + "/objects/" + hex.substr(0, 2) + "/" + hex;
+}
+
+// ==================== 编译器身份 ====================
+
+const DiskCache::Key& DiskCache::compilerIdentity() {
+    static const Key identity = [] {
+        ContentHasher hasher;
+        hasher.update(std::string_view(TOYC_VERSION));
+        // 同一版本号下重新构建的编译器也必须使旧结果失效
+        std::ifstream self("/proc/self/exe", std::ios::binary);
+        char buffer[64 * 1024];
+        while (self.read(buffer, sizeof(buffer)) || self.gcount() > 0) {
+            hasher.update(buffer, static_cast<size_t>(self.gcount()));
+        }
+        return hasher.digest();
+    }();
+    return identity;
+}
+
+// ==================== 索引 ====================
+
+DiskCache::IndexSlot* DiskCache::findSlot(const Key& key) const {
+    IndexSlot* table = slots();
+    for (uint32_t probe = 0; probe < kSlotCount; ++probe) {
+        IndexSlot& slot = table[(key.lo + probe) % kSlotCount];
+        if (isEmpty(slot)) {
+            return nullptr;
+        }
+        if (slot.hi == key.hi && slot.lo == key.lo) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t DiskCache::nextClock() {
+    // 查找路径不加锁，时钟统一用原子操作推进
+    return std::atomic_ref<uint64_t>(header().clock).fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void DiskCache::touch(const Key& key) {
+    // 无锁刷新：并发重建时可能刷新失败，只影响淘汰顺序，不影响正确性
+    IndexSlot* slot = findSlot(key);
+    if (!slot) {
+        return;
+    }
+    std::atomic_ref<uint64_t>(slot->lastUse).store(nextClock(), std::memory_order_relaxed);
+}
+
+void DiskCache::recordLocked(const Key& key, uint64_t bytes) {
+    IndexHeader& head = header();
+    if (head.tombstones > kSlotCount / 4) {
+        rebuildLocked();
+    }
+
+    IndexSlot* table = slots();
+    IndexSlot* target = nullptr;
+    for (uint32_t probe = 0; probe < kSlotCount; ++probe) {
+        IndexSlot& slot = table[(key.lo + probe) % kSlotCount];
+        if (slot.hi == key.hi && slot.lo == key.lo) {
+            // 已有条目（另一个进程刚写入同一结果）：只更新大小
+            head.totalBytes = head.totalBytes - slot.bytes + bytes;
+            slot.bytes = bytes;
+            slot.lastUse = nextClock();
+            return;
+        }
+        if (!target && (isEmpty(slot) || isTombstone(slot))) {
+            target = &slot;
+        }
+        if (isEmpty(slot)) {
+            break;
+        }
+    }
+
+    if (!target) {
+        // 表满：淘汰最旧的条目腾出位置
+        if (evictOldestLocked()) {
+            recordLocked(key, bytes);
+        }
+        return;
+    }
+
+    if (isTombstone(*target)) {
+        head.tombstones--;
+    }
+    target->hi = key.hi;
+    target->lo = key.lo;
+    target->bytes = bytes;
+    target->lastUse = nextClock();
+    head.totalBytes += bytes;
+    evictLocked();
+}
+
+void DiskCache::evictLocked() {
+    while (header().totalBytes > capacityBytes && evictOldestLocked()) {
+    }
+}
+
+bool DiskCache::evictOldestLocked() {
+    IndexHeader& head = header();
+    IndexSlot* table = slots();
+    IndexSlot* oldest = nullptr;
+    for (uint32_t i = 0; i < kSlotCount; ++i) {
+        IndexSlot& slot = table[i];
+        if (isEmpty(slot) || isTombstone(slot)) continue;
+        if (!oldest || slot.lastUse < oldest->lastUse) {
+            oldest = &slot;
+        }
+    }
+    if (!oldest) {
+        head.totalBytes = 0;
+        return false;
+    }
+
+    ::unlink(objectPath({oldest->hi, oldest->lo}).c_str());
+    head.totalBytes -= std::min(head.totalBytes, oldest->bytes);
+    oldest->hi = 0;
+    oldest->lo = kTombstoneLo;
+    oldest->bytes = 0;
+    oldest->lastUse = 0;
+    head.tombstones++;
+    return true;
+}
+
+void DiskCache::rebuildLocked() {
+    IndexSlot* table = slots();
+    std::vector<IndexSlot> live;
+    for (uint32_t i = 0; i < kSlotCount; ++i) {
+        if (!isEmpty(table[i]) && !isTombstone(table[i])) {
+            live.push_back(table[i]);
+        }
+    }
+    std::memset(table, 0, sizeof(IndexSlot) * kSlotCount);
+    for (const IndexSlot& entry : live) {
+        for (uint32_t probe = 0; probe < kSlotCount; ++probe) {
+            IndexSlot& slot = table[(entry.lo + probe) % kSlotCount];
+            if (isEmpty(slot)) {
+                slot = entry;
+                break;
+            }
+        }
+    }
+    header().tombstones = 0;
+}
+
+// ==================== 查找与插入 ====================
+
+static bool readExact(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = ::read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool DiskCache::lookup(const Key& rawKey, std::string& assembly, std::string& diagnostics) {
+    Key key = normalize(rawKey);
+    int fd = ::open(objectPath(key).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    char magic[8];
+    uint64_t storedHi, storedLo, assemblySize, diagnosticsSize;
+    bool ok = readExact(fd, magic, sizeof(magic)) &&
+              std::memcmp(magic, kEntryMagic, sizeof(magic)) == 0 &&
+              readExact(fd, &storedHi, sizeof(storedHi)) && readExact(fd, &storedLo, sizeof(storedLo)) &&
+              storedHi == key.hi && storedLo == key.lo &&
+              readExact(fd, &assemblySize, sizeof(assemblySize)) &&
+              readExact(fd, &diagnosticsSize, sizeof(diagnosticsSize));
+    if (ok) {
+        assembly.resize(assemblySize);
+        diagnostics.resize(diagnosticsSize);
+        ok = readExact(fd, assembly.data(), assemblySize) && readExact(fd, diagnostics.data(), diagnosticsSize);
+    }
+    ::close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    if (findSlot(key)) {
+        touch(key);
+    } else {
+        // 条目存在但索引里没有（例如写入者在登记前退出），补登记
+        IndexLock lock(processMutex, indexFd);
+        recordLocked(key, sizeof(kEntryMagic) + 32 + assemblySize + diagnosticsSize);
+    }
+    return true;
+}
+
+void DiskCache::insert(const Key& rawKey, const std::string& assembly, const std::string& diagnostics) {
+    Key key = normalize(rawKey);
+    std::string hex = key.hex();
+    std::ostringstream tempName;
+    tempName << directory << "/tmp/" << hex << "." << ::getpid() << "."
+             << std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string tempPath = tempName.str();
+
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return;
+        }
+        uint64_t assemblySize = assembly.size();
+        uint64_t diagnosticsSize = diagnostics.size();
+        out.write(kEntryMagic, sizeof(kEntryMagic));
+        out.write(reinterpret_cast<const char*>(&key.hi), sizeof(key.hi));
+        out.write(reinterpret_cast<const char*>(&key.lo), sizeof(key.lo));
+        out.write(reinterpret_cast<const char*>(&assemblySize), sizeof(assemblySize));
+        out.write(reinterpret_cast<const char*>(&diagnosticsSize), sizeof(diagnosticsSize));
+        out.write(assembly.data(), static_cast<std::streamsize>(assembly.size()));
+        out.write(diagnostics.data(), static_cast<std::streamsize>(diagnostics.size()));
+        if (!out) {
+            out.close();
+            ::unlink(tempPath.c_str());
+            return;
+        }
+    }
+
+    std::string finalPath = objectPath(key);
+    makeDirectory(directory + "/objects/" + hex.substr(0, 2));
+    // rename 是原子的：并发写入同一键时后到者覆盖，内容相同
+    if (::rename(tempPath.c_str(), finalPath.c_str()) != 0) {
+        ::unlink(tempPath.c_str());
+        return;
+    }
+
+    IndexLock lock(processMutex, indexFd);
+    recordLocked(key, sizeof(kEntryMagic) + 32 + assembly.size() + diagnostics.size());
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "hash.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+// ==================== 磁盘结果缓存 ====================
+
+/**
+ * 以内容哈希为键的本地磁盘缓存，每个条目保存两段文本：
+ * 整份文件的输出（汇编 + 诊断），或单个函数的结果（汇编 + 优化后的 IR）。
+ *
+ * 目录结构：
+ *   index              mmap 的定长哈希表，记录每个条目的大小与最近使用时间
+ *   objects/xx/<key>   条目文件，先写入 tmp/ 再 rename，读者永远看不到半个文件
+ *   tmp/               写入中的临时文件
+ *
+ * 查找只读条目文件并无锁地刷新使用时间；插入与淘汰在 index 上加 flock，
+ * 多个批量编译进程、多个线程可以同时使用同一个缓存目录。
+ * 总大小超过上限时按最近最少使用淘汰。
+ */
+class DiskCache {
+public:
+    using Key = ContentHasher::Digest;
+
+    // 打开（必要时创建）缓存目录；失败时返回 nullptr 并写诊断
+    static std::unique_ptr<DiskCache> open(const std::string& directory, uint64_t capacityBytes,
+                                           std::ostream& diag);
+    ~DiskCache();
+
+    DiskCache(const DiskCache&) = delete;
+    DiskCache& operator=(const DiskCache&) = delete;
+
+    bool lookup(const Key& key, std::string& assembly, std::string& diagnostics);
+    void insert(const Key& key, const std::string& assembly, const std::string& diagnostics);
+
+    // 编译器身份：版本号 + 可执行文件内容哈希，编译器一变缓存即失效
+    static const Key& compilerIdentity();
+
+private:
+    struct IndexHeader;
+    struct IndexSlot;
+
+    static bool isEmpty(const IndexSlot& slot);
+    static bool isTombstone(const IndexSlot& slot);
+
+    std::string directory;
+    uint64_t capacityBytes;
+    int indexFd = -1;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::mutex processMutex;   // flock 不区分同一进程内的线程
+
+    DiskCache(std::string directory, uint64_t capacityBytes)
+        : directory(std::move(directory)), capacityBytes(capacityBytes) {}
+
+    IndexHeader& header() const;
+    IndexSlot* slots() const;
+
+    std::string objectPath(const Key& key) const;
+    IndexSlot* findSlot(const Key& key) const;
+    uint64_t nextClock();
+    void touch(const Key& key);
+    void recordLocked(const Key& key, uint64_t bytes);
+    void evictLocked();
+    bool evictOldestLocked();
+    void rebuildLocked();
+};
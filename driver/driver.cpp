@@ -0,0 +1,943 @@
+#include "driver.h"
+#include "disk_cache.h"
+#include "function_hash.h"
+#include "spsc_queue.h"
+#include "thread_pool.h"
+#include "semantic/semantic.h"
+#include "semantic/simplify.h"
+#include "ir/ir.h"
+#include "ir/irgen.h"
+#include "ir/ir_binary.h"
+#include "ir/ir_reader.h"
+#include "codegen/codegen.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+
+// ==================== 编译配置 ====================
+
+IRGenConfig makeIRGenConfig(const CompileOptions& options) {
+    IRGenConfig irConfig;
+    switch (options.optLevel) {
+        case OptLevel::O0:
+            break;
+        case OptLevel::O1:
+        case OptLevel::O2:
+        case OptLevel::O3:
+            irConfig.enableOptimizations = true;
+            break;
+        case OptLevel::Os:
+            // 默认序列去掉强度削减：乘法拆成移位和加法会增加指令数
+            irConfig.enableOptimizations = true;
+            irConfig.passes = {"constfold", "algebraic", "constprop", "copyprop",
+                               "constfold", "algebraic", "dce"};
+            break;
+    }
+    if (options.customPasses) {
+        irConfig.enableOptimizations = !options.passes.empty();
+        irConfig.passes = options.passes;
+    }
+    return irConfig;
+}
+
+CodeGenConfig makeCodeGenConfig(const CompileOptions& options) {
+    CodeGenConfig config;
+    switch (options.optLevel) {
+        case OptLevel::O0:
+            break;
+        case OptLevel::O1:
+            break;
+        case OptLevel::O2:
+        case OptLevel::Os:
+        case OptLevel::O3:
+            config.regAllocStrategy = options.optLevel == OptLevel::O3
+                ? RegisterAllocStrategy::GRAPH_COLOR : RegisterAllocStrategy::LINEAR_SCAN;
+            config.splitLiveRanges = true;
+            break;
+    }
+    if (options.customRegAlloc) {
+        config.regAllocStrategy = options.regAlloc;
+    }
+    return config;
+}
+
+// ==================== 命令行选项 ====================
+
+static const std::pair<const char*, OptLevel> kOptLevelNames[] = {
+    {"-O0", OptLevel::O0}, {"-O1", OptLevel::O1}, {"-O2", OptLevel::O2},
+    {"-O3", OptLevel::O3}, {"-Os", OptLevel::Os},
+};
+
+static const std::pair<const char*, RegisterAllocStrategy> kRegAllocNames[] = {
+    {"naive", RegisterAllocStrategy::NAIVE},
+    {"linear", RegisterAllocStrategy::LINEAR_SCAN},
+    {"graph", RegisterAllocStrategy::GRAPH_COLOR},
+    {"ssa", RegisterAllocStrategy::SSA},
+    {"auto", RegisterAllocStrategy::AUTO},
+};
+
+OptionParse parseCompileOption(const std::string& arg, CompileOptions& options, std::ostream& diag) {
+    if (arg == "-opt") {
+        options.optLevel = OptLevel::O2;
+        return OptionParse::ACCEPTED;
+    }
+    if (arg == "-print-ir") {
+        options.printIR = true;
+        return OptionParse::ACCEPTED;
+    }
+    if (arg == "-stats") {
+        options.stats = true;
+        return OptionParse::ACCEPTED;
+    }
+    for (const auto& [name, level] : kOptLevelNames) {
+        if (arg == name) {
+            options.optLevel = level;
+            return OptionParse::ACCEPTED;
+        }
+    }
+    if (arg.size() > 2 && arg.rfind("-O", 0) == 0) {
+        diag << "Error: Unknown optimization level '" << arg << "' (expected -O0, -O1, -O2, -O3 or -Os)"
+             << std::endl;
+        return OptionParse::INVALID;
+    }
+
+    if (arg.rfind("-passes=", 0) == 0) {
+        std::vector<std::string> known = IRGenerator::passNames();
+        std::vector<std::string> passes;
+        std::stringstream list(arg.substr(8));
+        std::string name;
+        while (std::getline(list, name, ',')) {
+            if (name.empty()) {
+                continue;
+            }
+            if (std::find(known.begin(), known.end(), name) == known.end()) {
+                diag << "Error: Unknown pass '" << name << "'; available passes:";
+                for (const auto& pass : known) {
+                    diag << " " << pass;
+                }
+                diag << std::endl;
+                return OptionParse::INVALID;
+            }
+            passes.push_back(name);
+        }
+        options.customPasses = true;
+        options.passes = std::move(passes);
+        return OptionParse::ACCEPTED;
+    }
+
+    if (arg.rfind("-regalloc=", 0) == 0) {
+        std::string value = arg.substr(10);
+        for (const auto& [name, strategy] : kRegAllocNames) {
+            if (value == name) {
+                options.customRegAlloc = true;
+                options.regAlloc = strategy;
+                return OptionParse::ACCEPTED;
+            }
+        }
+        diag << "Error: Unknown register allocator '" << value << "' (expected naive, linear, graph, ssa or auto)"
+             << std::endl;
+        return OptionParse::INVALID;
+    }
+    return OptionParse::NOT_OPTION;
+}
+
+std::string compileOptionArguments(const CompileOptions& options) {
+    std::ostringstream out;
+    for (const auto& [name, level] : kOptLevelNames) {
+        if (level == options.optLevel) {
+            out << name;
+        }
+    }
+    if (options.customPasses) {
+        out << " -passes=";
+        for (size_t i = 0; i < options.passes.size(); ++i) {
+            out << (i ? "," : "") << options.passes[i];
+        }
+    }
+    if (options.customRegAlloc) {
+        for (const auto& [name, strategy] : kRegAllocNames) {
+            if (strategy == options.regAlloc) {
+                out << " -regalloc=" << name;
+            }
+        }
+    }
+    if (options.printIR) {
+        out << " -print-ir";
+    }
+    if (options.stats) {
+        out << " -stats";
+    }
+    return out.str();
+}
+
+std::string configFingerprint(const IRGenConfig& irConfig, const CodeGenConfig& codeGenConfig) {
+    std::ostringstream out;
+    out << "ir:" << irConfig.enableOptimizations << irConfig.generateDebugInfo
+        << irConfig.inlineSmallFunctions;
+    for (const auto& pass : irConfig.passes) {
+        out << "," << pass;
+    }
+    out << ";budget:" << irConfig.passBudget << "," << irConfig.functionBudget;
+    out << ";cg:" << codeGenConfig.optimizeStackLayout << codeGenConfig.eliminateDeadStores
+        << codeGenConfig.enablePeepholeOptimizations << codeGenConfig.enableInlineAsm
+        << static_cast<int>(codeGenConfig.regAllocStrategy) << codeGenConfig.splitLiveRanges << ","
+        << codeGenConfig.graphColorBudget;
+    return out.str();
+}
+
+// ==================== 单函数编译 ====================
+
+// -stats 中一个函数的一行：规模、各阶段耗时和预算降级
+struct FunctionStats {
+    std::string name;
+    bool cached = false;
+    size_t irInstrs = 0;
+    double optimizeMs = 0;
+    double codegenMs = 0;
+    std::vector<BudgetEvent> budget;
+    std::vector<AllocatorChoice> allocators;
+};
+
+struct FunctionUnit {
+    std::string assembly;
+    std::string ir;
+    FunctionStats stats;
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 降级记录写成 "函数: 步骤 -> 替代 (cost 估算 > 预算)"；
+// -regalloc=auto 的选择写成 "函数: 选中的分配器 (各候选的静态代价)"
+static void printStats(const std::vector<FunctionStats>& functions, std::ostream& diag) {
+    size_t cached = 0;
+    size_t irInstrs = 0;
+    size_t downgrades = 0;
+    double optimizeMs = 0;
+    double codegenMs = 0;
+    std::ostringstream text;
+    std::ostringstream budget;
+    std::ostringstream regalloc;
+    text << std::fixed << std::setprecision(2);
+
+    text << "# Compile statistics\n";
+    for (const auto& function : functions) {
+        if (function.cached) {
+            text << function.name << ": cached\n";
+            cached++;
+            continue;
+        }
+        text << function.name << ": " << function.irInstrs << " IR instrs, optimize "
+             << function.optimizeMs << " ms, codegen " << function.codegenMs << " ms\n";
+        irInstrs += function.irInstrs;
+        optimizeMs += function.optimizeMs;
+        codegenMs += function.codegenMs;
+        for (const auto& event : function.budget) {
+            budget << "budget: " << event.function << ": " << event.step << " -> "
+                   << (event.fallback.empty() ? "skipped" : event.fallback)
+                   << " (cost " << event.cost << " > " << event.budget << ")\n";
+            downgrades++;
+        }
+        for (const auto& choice : function.allocators) {
+            regalloc << "regalloc: " << choice.function << ": " << choice.chosen << " (";
+            for (size_t i = 0; i < choice.costs.size(); ++i) {
+                regalloc << (i ? ", " : "") << choice.costs[i].first << " " << choice.costs[i].second;
+            }
+            regalloc << ")\n";
+        }
+    }
+    text << budget.str() << regalloc.str();
+    text << "total: " << functions.size() << " functions (" << cached << " cached), " << irInstrs
+         << " IR instrs, optimize " << optimizeMs << " ms, codegen " << codegenMs << " ms, "
+         << downgrades << " budget downgrades\n";
+    diag << text.str() << std::flush;
+}
+
+// 编译器身份 + 配置 + 函数结构哈希（含被调函数签名）；结构哈希同时登记为该函数的摘要
+static DiskCache::Key functionCacheKey(FunctionDef& funcDef,
+                                       std::map<std::string, FunctionSignature>& signatures,
+                                       const std::string& fingerprint) {
+    ContentHasher hasher;
+    const DiskCache::Key& identity = DiskCache::compilerIdentity();
+    hasher.update(identity.hi).update(identity.lo);
+    hasher.update(std::string_view("function"));
+    hasher.update(fingerprint);
+    DiskCache::Key structure = FunctionHasher::hash(funcDef, signatures);
+    hasher.update(structure.hi).update(structure.lo);
+    signatures[funcDef.name].summary = structure;
+    return hasher.digest();
+}
+
+static std::string functionIRText(const std::vector<std::shared_ptr<IRInstr>>& instructions) {
+    std::ostringstream irStream;
+    for (const auto& instr : instructions) {
+        irStream << instr->toString() << "\n";
+    }
+    return irStream.str();
+}
+
+// clobbers 按源码顺序在各函数间传递：先登记被调函数的摘要，再生成调用它的函数
+static std::string emitFunction(const std::vector<std::shared_ptr<IRInstr>>& instructions,
+                                const CodeGenConfig& codeGenConfig, CallClobbers& clobbers,
+                                FunctionStats* stats = nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    std::ostringstream assemblyStream;
+    CodeGenerator generator(assemblyStream, instructions, codeGenConfig);
+    generator.setCallClobbers(clobbers);
+    generator.generateFunctions();
+    if (stats) {
+        for (const auto& instr : instructions) {
+            if (auto begin = std::dynamic_pointer_cast<FunctionBeginInstr>(instr)) {
+                stats->name = begin->funcName;
+            }
+        }
+        stats->irInstrs = instructions.size();
+        stats->codegenMs = elapsedMs(start);
+        for (auto& event : generator.takeBudgetEvents()) {
+            stats->budget.push_back(std::move(event));
+        }
+        stats->allocators = generator.takeAllocatorChoices();
+    }
+    return assemblyStream.str();
+}
+
+// 优化一个函数的 IR，耗时与降级记录计入 stats
+static void timedOptimize(IRGenerator& optimizer, std::vector<std::shared_ptr<IRInstr>>& instructions,
+                          FunctionStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    optimizer.optimizeFunction(instructions);
+    stats.optimizeMs = elapsedMs(start);
+    for (auto& event : optimizer.takeBudgetEvents()) {
+        stats.budget.push_back(std::move(event));
+    }
+}
+
+/**
+ * 生成一个函数的优化后 IR 与汇编。
+ *
+ * 每个函数的结果只取决于它自身的结构和被调函数的签名与摘要，启用缓存时以
+ * 编译器身份 + 配置 + 函数结构哈希为键，命中则整个跳过 IR 生成、优化和代码生成，
+ * 它的调用摘要从缓存的汇编中找回。
+ * 无论是否命中，拼接出的整份输出都与不带缓存的编译完全相同。
+ */
+static FunctionUnit compileFunction(FunctionDef& funcDef,
+                                    std::map<std::string, FunctionSignature>& signatures,
+                                    IRGenerator& irGenerator, const CodeGenConfig& codeGenConfig,
+                                    CallClobbers& clobbers, const std::string& fingerprint,
+                                    const CompileOptions& options) {
+    FunctionUnit unit;
+    unit.stats.name = funcDef.name;
+    DiskCache::Key key;
+    if (options.cache) {
+        key = functionCacheKey(funcDef, signatures, fingerprint);
+        if (options.cache->lookup(key, unit.assembly, unit.ir)) {
+            unit.stats.cached = true;
+            clobbers.recordFromAssembly(unit.assembly);
+            return unit;
+        }
+    }
+
+    // 即 irGenerator.generateFunction()，拆开以便分别计时
+    std::vector<std::shared_ptr<IRInstr>> instructions = irGenerator.lowerFunction(funcDef);
+    if (irGenerator.getConfig().enableOptimizations) {
+        timedOptimize(irGenerator, instructions, unit.stats);
+    }
+    unit.ir = functionIRText(instructions);
+    unit.assembly = emitFunction(instructions, codeGenConfig, clobbers, &unit.stats);
+
+    if (options.cache) {
+        // 条目的第二段存放该函数优化后的 IR 文本
+        options.cache->insert(key, unit.assembly, unit.ir);
+    }
+    return unit;
+}
+
+// ==================== 单文件编译 ====================
+
+// 解析并对整个文件做语义分析；失败时写诊断并返回空
+static std::shared_ptr<CompUnit> analyzeSource(ParseContext& context, const std::string& source,
+                                               std::ostream& diag) {
+    context.setDiagnostics(diag);
+    bool parsed = context.parseString(source);
+
+    std::shared_ptr<CompUnit> root = context.getRoot();
+    if (!parsed && context.getErrorCount() > 0) {
+        diag << "Error: Parsing failed." << std::endl;
+        return nullptr;
+    }
+
+    if (!root) {
+        diag << "Error: Parsing failed (no AST generated)." << std::endl;
+        return nullptr;
+    }
+
+    // 语义分析需要全局的函数表和调用关系（如未使用函数的警告），仍对整个文件进行
+    SemanticAnalyzer semanticAnalyzer;
+    semanticAnalyzer.setDiagnostics(diag);
+    if (!semanticAnalyzer.analyze(root)) {
+        diag << "Error: Semantic analysis failed." << std::endl;
+        return nullptr;
+    }
+    // 诊断都已报告，之后的阶段只看化简后的 AST
+    ASTSimplifier simplifier;
+    for (const auto& func : root->functions) {
+        simplifier.simplify(*func);
+    }
+    return root;
+}
+
+static bool runPipeline(ParseContext& context, const std::string& source,
+                        const CompileOptions& options, std::ostream& out, std::ostream& diag) {
+    std::shared_ptr<CompUnit> root = analyzeSource(context, source, diag);
+    if (!root) {
+        return false;
+    }
+
+    IRGenConfig irConfig = makeIRGenConfig(options);
+    CodeGenConfig codeGenConfig = makeCodeGenConfig(options);
+    std::string fingerprint = configFingerprint(irConfig, codeGenConfig);
+    IRGenerator irGenerator(irConfig);
+
+    std::map<std::string, FunctionSignature> signatures;
+    for (const auto& func : root->functions) {
+        signatures[func->name] = {func->returnType, func->params.size(), {}};
+    }
+
+    std::ostringstream outputStream;
+    std::ostringstream irStream;
+    std::vector<FunctionStats> stats;
+    CallClobbers clobbers;
+    CodeGenerator::emitFileHeader(outputStream);
+    for (const auto& func : root->functions) {
+        FunctionUnit unit = compileFunction(*func, signatures, irGenerator, codeGenConfig,
+                                            clobbers, fingerprint, options);
+        outputStream << unit.assembly;
+        irStream << unit.ir;
+        stats.push_back(std::move(unit.stats));
+    }
+
+    if (options.printIR) {
+        diag << "# Intermediate Representation\n" << irStream.str();
+    }
+    if (options.stats) {
+        printStats(stats, diag);
+    }
+
+    out << outputStream.str();
+    return true;
+}
+
+bool compileSource(ParseContext& context, const std::string& source,
+                   const CompileOptions& options, std::ostream& out, std::ostream& diag) {
+    // 打印 IR 和统计需要真正跑一遍流水线，不走整份文件的缓存
+    if (!options.cache || options.printIR || options.stats) {
+        return runPipeline(context, source, options, out, diag);
+    }
+
+    ContentHasher hasher;
+    const DiskCache::Key& identity = DiskCache::compilerIdentity();
+    hasher.update(identity.hi).update(identity.lo);
+    hasher.update(configFingerprint(makeIRGenConfig(options), makeCodeGenConfig(options)));
+    hasher.update(source);
+    DiskCache::Key key = hasher.digest();
+
+    std::string assembly;
+    std::string diagnostics;
+    if (options.cache->lookup(key, assembly, diagnostics)) {
+        diag << diagnostics;
+        out << assembly;
+        return true;
+    }
+
+    std::ostringstream assemblyStream;
+    std::ostringstream diagnosticStream;
+    bool ok = runPipeline(context, source, options, assemblyStream, diagnosticStream);
+    diag << diagnosticStream.str();
+    if (!ok) {
+        return false;
+    }
+    options.cache->insert(key, assemblyStream.str(), diagnosticStream.str());
+    out << assemblyStream.str();
+    return true;
+}
+
+// ==================== IR 输入输出 ====================
+
+// 前端 + IR 生成与优化，得到整个文件的 IR；失败时返回 false
+static bool generateModuleIR(ParseContext& context, const std::string& source,
+                             const CompileOptions& options,
+                             std::vector<std::shared_ptr<IRInstr>>& instructions, std::ostream& diag) {
+    std::shared_ptr<CompUnit> root = analyzeSource(context, source, diag);
+    if (!root) {
+        return false;
+    }
+
+    IRGenerator irGenerator(makeIRGenConfig(options));
+    std::vector<FunctionStats> stats;
+    for (const auto& func : root->functions) {
+        FunctionStats functionStats;
+        functionStats.name = func->name;
+        std::vector<std::shared_ptr<IRInstr>> funcInstrs = irGenerator.lowerFunction(*func);
+        if (irGenerator.getConfig().enableOptimizations) {
+            timedOptimize(irGenerator, funcInstrs, functionStats);
+        }
+        functionStats.irInstrs = funcInstrs.size();
+        instructions.insert(instructions.end(), funcInstrs.begin(), funcInstrs.end());
+        stats.push_back(std::move(functionStats));
+    }
+    if (options.printIR) {
+        diag << "# Intermediate Representation\n" << functionIRText(instructions);
+    }
+    if (options.stats) {
+        printStats(stats, diag);
+    }
+    return true;
+}
+
+bool emitIRText(ParseContext& context, const std::string& source,
+                const CompileOptions& options, std::ostream& out, std::ostream& diag) {
+    std::vector<std::shared_ptr<IRInstr>> instructions;
+    if (!generateModuleIR(context, source, options, instructions, diag)) {
+        return false;
+    }
+    IRPrinter::print(instructions, out);
+    return true;
+}
+
+bool emitIRBinary(ParseContext& context, const std::string& source,
+                  const CompileOptions& options, std::ostream& out, std::ostream& diag) {
+    std::vector<std::shared_ptr<IRInstr>> instructions;
+    if (!generateModuleIR(context, source, options, instructions, diag)) {
+        return false;
+    }
+    out << IRBinaryWriter::serialize(instructions);
+    return true;
+}
+
+bool compileIRText(const std::string& text, const CompileOptions& options,
+                   std::ostream& out, std::ostream& diag) {
+    std::vector<std::shared_ptr<IRInstr>> instructions;
+    if (!IRReader::parse(text, instructions, diag)) {
+        return false;
+    }
+    // 与整体编译一致，每个函数用一个新的代码生成器
+    CodeGenConfig codeGenConfig = makeCodeGenConfig(options);
+    std::vector<FunctionStats> stats;
+    CallClobbers clobbers;
+    CodeGenerator::emitFileHeader(out);
+    for (const auto& function : IRReader::splitFunctions(instructions)) {
+        stats.emplace_back();
+        out << emitFunction(function, codeGenConfig, clobbers, &stats.back());
+    }
+    if (options.stats) {
+        printStats(stats, diag);
+    }
+    return true;
+}
+
+bool compileIRBinary(const std::string& path, const CompileOptions& options,
+                     std::ostream& out, std::ostream& diag) {
+    std::unique_ptr<IRBinaryModule> module = IRBinaryModule::open(path, diag);
+    if (!module) {
+        return false;
+    }
+
+    CodeGenConfig codeGenConfig = makeCodeGenConfig(options);
+    std::ostringstream outputStream;
+    std::ostringstream irStream;
+    std::vector<FunctionStats> stats;
+    CallClobbers clobbers;
+    CodeGenerator::emitFileHeader(outputStream);
+    for (size_t i = 0; i < module->functionCount(); ++i) {
+        std::vector<std::shared_ptr<IRInstr>> instructions = module->materialize(i);
+        if (options.printIR) {
+            irStream << functionIRText(instructions);
+        }
+        stats.emplace_back();
+        outputStream << emitFunction(instructions, codeGenConfig, clobbers, &stats.back());
+    }
+
+    if (options.printIR) {
+        diag << "# Intermediate Representation\n" << irStream.str();
+    }
+    if (options.stats) {
+        printStats(stats, diag);
+    }
+    out << outputStream.str();
+    return true;
+}
+
+// ==================== 流式编译 ====================
+
+bool compileStreaming(ParseContext& context, const std::string& source,
+                      const CompileOptions& options, std::ostream& out, std::ostream& diag) {
+    IRGenConfig irConfig = makeIRGenConfig(options);
+    CodeGenConfig codeGenConfig = makeCodeGenConfig(options);
+    std::string fingerprint = configFingerprint(irConfig, codeGenConfig);
+    IRGenerator irGenerator(irConfig);
+
+    SemanticAnalyzer semanticAnalyzer;
+    semanticAnalyzer.setDiagnostics(diag);
+    semanticAnalyzer.begin();
+
+    // 函数先定义后调用，处理到某个函数时它的被调函数都已登记
+    std::map<std::string, FunctionSignature> signatures;
+    bool hasMain = false;
+    bool emitting = true;   // 出现语义错误后只继续检查，不再生成代码
+    std::vector<FunctionStats> stats;
+    CallClobbers clobbers;
+    std::string irText;
+
+    CodeGenerator::emitFileHeader(out);
+
+    context.setDiagnostics(diag);
+    context.setFunctionSink([&](std::shared_ptr<FunctionDef> func) {
+        hasMain = hasMain || func->name == "main";
+        signatures[func->name] = {func->returnType, func->params.size(), {}};
+        if (!semanticAnalyzer.analyzeFunction(*func)) {
+            emitting = false;
+        }
+        if (!emitting) {
+            return;
+        }
+        ASTSimplifier().simplify(*func);
+        FunctionUnit unit = compileFunction(*func, signatures, irGenerator, codeGenConfig,
+                                            clobbers, fingerprint, options);
+        if (options.printIR) {
+            irText += unit.ir;
+        }
+        out << unit.assembly;
+        stats.push_back(std::move(unit.stats));
+    });
+    bool parsed = context.parseString(source);
+    context.setFunctionSink(nullptr);
+
+    if (!parsed && context.getErrorCount() > 0) {
+        diag << "Error: Parsing failed." << std::endl;
+        return false;
+    }
+
+    if (!context.getRoot()) {
+        diag << "Error: Parsing failed (no AST generated)." << std::endl;
+        return false;
+    }
+
+    if (!semanticAnalyzer.finish(hasMain)) {
+        diag << "Error: Semantic analysis failed." << std::endl;
+        return false;
+    }
+    // 与整体编译一致：IR 打印在语义诊断之后
+    if (options.printIR) {
+        diag << "# Intermediate Representation\n" << irText;
+    }
+    if (options.stats) {
+        printStats(stats, diag);
+    }
+    return true;
+}
+
+// ==================== 流水线编译 ====================
+
+namespace {
+
+// 在相邻阶段之间传递的一个函数，或者（end 为 true 时）输入结束标记
+struct PipelineItem {
+    std::shared_ptr<FunctionDef> func;
+    DiskCache::Key key;
+    bool cached = false;
+    std::vector<std::shared_ptr<IRInstr>> instructions;
+    FunctionUnit unit;
+    std::string error;         // 本函数在某个阶段抛出的异常
+
+    bool end = false;
+    bool ok = true;            // 结束标记：解析与语义分析是否成功
+    std::string diagnostics;   // 结束标记：解析与语义分析的全部诊断
+};
+
+// 每个队列最多缓冲的函数数，决定了流水线中同时存活的 AST/IR 上限
+constexpr size_t kPipelineDepth = 8;
+
+}  // namespace
+
+bool compilePipelined(ParseContext& context, const std::string& source,
+                      const CompileOptions& options, std::ostream& out, std::ostream& diag) {
+    IRGenConfig irConfig = makeIRGenConfig(options);
+    CodeGenConfig codeGenConfig = makeCodeGenConfig(options);
+    std::string fingerprint = configFingerprint(irConfig, codeGenConfig);
+
+    SpscQueue<PipelineItem> toSemantic(kPipelineDepth);
+    SpscQueue<PipelineItem> toLower(kPipelineDepth);
+    SpscQueue<PipelineItem> toOptimize(kPipelineDepth);
+    SpscQueue<PipelineItem> toEmit(kPipelineDepth);
+    SpscQueue<PipelineItem> toWriter(kPipelineDepth);
+
+    // 解析：每归约出一个函数就送入流水线；节点改在堆上分配，由后续阶段释放
+    std::thread parseStage([&] {
+        std::ostringstream parseDiag;
+        // parseDiag 随线程结束销毁，返回前把上下文的诊断流换回调用方原来的
+        std::ostream& callerDiag = context.getDiagnostics();
+        PipelineItem end;
+        end.end = true;
+        try {
+            context.setDiagnostics(parseDiag);
+            context.setFunctionSink([&](std::shared_ptr<FunctionDef> func) {
+                PipelineItem item;
+                item.func = std::move(func);
+                toSemantic.push(std::move(item));
+            }, true);
+            bool parsed = context.parseString(source);
+            if (!parsed && context.getErrorCount() > 0) {
+                parseDiag << "Error: Parsing failed." << std::endl;
+                end.ok = false;
+            } else if (!context.getRoot()) {
+                parseDiag << "Error: Parsing failed (no AST generated)." << std::endl;
+                end.ok = false;
+            }
+        } catch (const std::exception& e) {
+            parseDiag << "Error: " << e.what() << std::endl;
+            end.ok = false;
+        }
+        context.setFunctionSink(nullptr);
+        context.setDiagnostics(callerDiag);
+        end.diagnostics = parseDiag.str();
+        toSemantic.push(std::move(end));
+    });
+
+    // 语义分析：按源码顺序逐个检查，同时登记签名并计算缓存键
+    std::thread semanticStage([&] {
+        std::ostringstream semanticDiag;
+        SemanticAnalyzer semanticAnalyzer;
+        semanticAnalyzer.setDiagnostics(semanticDiag);
+        semanticAnalyzer.begin();
+        std::map<std::string, FunctionSignature> signatures;
+        bool hasMain = false;
+        bool emitting = true;   // 出现语义错误后只继续检查，不再往下游送函数
+
+        while (true) {
+            PipelineItem item = toSemantic.pop();
+            if (item.end) {
+                if (item.ok) {
+                    if (!semanticAnalyzer.finish(hasMain)) {
+                        semanticDiag << "Error: Semantic analysis failed." << std::endl;
+                        item.ok = false;
+                    }
+                    item.diagnostics += semanticDiag.str();
+                }
+                toLower.push(std::move(item));
+                break;
+            }
+
+            try {
+                hasMain = hasMain || item.func->name == "main";
+                signatures[item.func->name] = {item.func->returnType, item.func->params.size(), {}};
+                if (!semanticAnalyzer.analyzeFunction(*item.func)) {
+                    emitting = false;
+                }
+                if (!emitting) {
+                    continue;
+                }
+                // 先化简再算缓存键，键只取决于真正要生成代码的 AST
+                ASTSimplifier().simplify(*item.func);
+                if (options.cache) {
+                    item.key = functionCacheKey(*item.func, signatures, fingerprint);
+                }
+            } catch (const std::exception& e) {
+                item.error = e.what();
+                emitting = false;
+            }
+            toLower.push(std::move(item));
+        }
+    });
+
+    // IR 生成：缓存命中的函数直接带着结果往下走；AST 到此用完即释放
+    std::thread lowerStage([&] {
+        IRGenerator irGenerator(irConfig);
+        while (true) {
+            PipelineItem item = toLower.pop();
+            if (item.end) {
+                toOptimize.push(std::move(item));
+                break;
+            }
+            if (item.error.empty()) {
+                try {
+                    item.unit.stats.name = item.func->name;
+                    if (options.cache && options.cache->lookup(item.key, item.unit.assembly, item.unit.ir)) {
+                        item.cached = true;
+                        item.unit.stats.cached = true;
+                    } else {
+                        item.instructions = irGenerator.lowerFunction(*item.func);
+                    }
+                } catch (const std::exception& e) {
+                    item.error = e.what();
+                }
+            }
+            item.func.reset();
+            toOptimize.push(std::move(item));
+        }
+    });
+
+    std::thread optimizeStage([&] {
+        IRGenerator optimizer(irConfig);
+        while (true) {
+            PipelineItem item = toOptimize.pop();
+            if (item.end) {
+                toEmit.push(std::move(item));
+                break;
+            }
+            if (item.error.empty() && !item.cached && irConfig.enableOptimizations) {
+                try {
+                    timedOptimize(optimizer, item.instructions, item.unit.stats);
+                } catch (const std::exception& e) {
+                    item.error = e.what();
+                }
+            }
+            toEmit.push(std::move(item));
+        }
+    });
+
+    // 寄存器分配与汇编输出；IR 到此用完即释放。函数按源码顺序到达，调用摘要在这一阶段里累积
+    std::thread emitStage([&] {
+        CallClobbers clobbers;
+        while (true) {
+            PipelineItem item = toEmit.pop();
+            if (item.end) {
+                toWriter.push(std::move(item));
+                break;
+            }
+            if (item.cached) {
+                clobbers.recordFromAssembly(item.unit.assembly);
+            }
+            if (item.error.empty() && !item.cached) {
+                try {
+                    item.unit.ir = functionIRText(item.instructions);
+                    item.unit.assembly = emitFunction(item.instructions, codeGenConfig, clobbers,
+                                                      &item.unit.stats);
+                    if (options.cache) {
+                        options.cache->insert(item.key, item.unit.assembly, item.unit.ir);
+                    }
+                } catch (const std::exception& e) {
+                    item.error = e.what();
+                }
+            }
+            item.instructions.clear();
+            toWriter.push(std::move(item));
+        }
+    });
+
+    // 当前线程按函数顺序写出；队列先进先出，顺序天然与源码一致
+    bool ok = true;
+    std::string irText;
+    std::vector<FunctionStats> stats;
+    std::ostringstream stageErrors;
+    CodeGenerator::emitFileHeader(out);
+    while (true) {
+        PipelineItem item = toWriter.pop();
+        if (item.end) {
+            diag << item.diagnostics;
+            ok = ok && item.ok;
+            break;
+        }
+        if (!item.error.empty()) {
+            stageErrors << "Error: " << item.error << std::endl;
+            ok = false;
+            continue;
+        }
+        if (options.printIR) {
+            irText += item.unit.ir;
+        }
+        out << item.unit.assembly;
+        stats.push_back(std::move(item.unit.stats));
+    }
+
+    parseStage.join();
+    semanticStage.join();
+    lowerStage.join();
+    optimizeStage.join();
+    emitStage.join();
+
+    diag << stageErrors.str();
+    // 与整体编译一致：IR 打印在语义诊断之后
+    if (options.printIR && ok) {
+        diag << "# Intermediate Representation\n" << irText;
+    }
+    if (options.stats && ok) {
+        printStats(stats, diag);
+    }
+    return ok;
+}
+
+// ==================== 批量编译 ====================
+
+std::string batchOutputPath(const std::string& inputPath, const std::string& outputDir) {
+    std::filesystem::path output(outputDir);
+    output /= std::filesystem::path(inputPath).stem();
+    output += ".s";
+    return output.string();
+}
+
+static bool compileJob(const BatchJob& job, const CompileOptions& options, std::ostream& diag) {
+    // 每个工作线程持有一个解析上下文，arena 在同一线程编译的文件之间复用
+    thread_local ParseContext context;
+
+    std::ifstream input(job.inputPath, std::ios::binary);
+    if (!input) {
+        diag << "Error: Cannot open file " << job.inputPath << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+
+    std::stringstream assembly;
+    bool ok = compileSource(context, buffer.str(), options, assembly, diag);
+    // 结果用完即回收 AST，不让节点跨文件存活
+    context.reset();
+    if (!ok) {
+        return false;
+    }
+
+    std::ofstream output(job.outputPath, std::ios::binary);
+    if (!output) {
+        diag << "Error: Cannot open file " << job.outputPath << " for writing" << std::endl;
+        return false;
+    }
+    output << assembly.str();
+    return static_cast<bool>(output);
+}
+
+int compileBatch(const std::vector<BatchJob>& jobs, const CompileOptions& options,
+                 unsigned threadCount, std::ostream& diag) {
+    std::vector<std::ostringstream> diagnostics(jobs.size());
+    std::vector<char> succeeded(jobs.size(), 0);
+
+    {
+        WorkStealingPool pool(threadCount);
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            pool.submit([&, i] {
+                try {
+                    succeeded[i] = compileJob(jobs[i], options, diagnostics[i]);
+                } catch (const std::exception& e) {
+                    diagnostics[i] << "Error: " << e.what() << std::endl;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        std::string text = diagnostics[i].str();
+        if (!text.empty()) {
+            diag << jobs[i].inputPath << ":" << std::endl << text;
+        }
+        if (!succeeded[i]) {
+            failures++;
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include "parser/parse_context.h"
+#include "ir/irgen.h"
+#include "codegen/codegen.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ==================== 编译驱动 ====================
+
+class DiskCache;
+
+/**
+ * 优化级别预设：
+ *   O0  不优化，朴素寄存器分配（默认）
+ *   O1  IR 默认优化序列，仍用朴素分配，编译最快的优化档
+ *   O2  O1 + 线性扫描分配（即原来的 -opt）
+ *   O3  O2，但改用图着色分配
+ *   Os  同 O2，但 IR 优化序列去掉会增加指令数的强度削减
+ */
+enum class OptLevel { O0, O1, O2, O3, Os };
+
+struct CompileOptions {
+    OptLevel optLevel = OptLevel::O0;   // -O0/-O1/-O2/-O3/-Os，-opt 等同 -O2
+    bool customPasses = false;          // 给了 -passes= 时用 passes 代替预设的 IR 优化序列
+    std::vector<std::string> passes;
+    bool customRegAlloc = false;        // 给了 -regalloc= 时用 regAlloc 代替预设的分配策略
+    RegisterAllocStrategy regAlloc = RegisterAllocStrategy::NAIVE;
+    bool printIR = false;    // -print-ir：把 IR 打印到诊断流
+    bool stats = false;      // -stats：把每个函数的规模、各阶段耗时和预算降级写到诊断流
+    DiskCache* cache = nullptr;  // 非空时先查整份文件的缓存，再按函数复用未改动函数的结果
+};
+
+IRGenConfig makeIRGenConfig(const CompileOptions& options);
+CodeGenConfig makeCodeGenConfig(const CompileOptions& options);
+
+enum class OptionParse { NOT_OPTION, ACCEPTED, INVALID };
+
+/**
+ * 解析一个编译选项参数：-O0..-O3、-Os、-opt、-passes=a,b,...、
+ * -regalloc=naive|linear|graph|ssa|auto、-print-ir、-stats。
+ * 不是这类参数时返回 NOT_OPTION；取值非法（如未知的遍）时写诊断并返回 INVALID。
+ */
+OptionParse parseCompileOption(const std::string& arg, CompileOptions& options, std::ostream& diag);
+
+// 把上述选项写回规范的参数形式（以空格分隔），可再由 parseCompileOption 逐个解析；
+// 向编译服务器传递选项时使用
+std::string compileOptionArguments(const CompileOptions& options);
+
+// 把影响输出的全部配置序列化，作为缓存键的一部分；配置增加字段时必须同步
+std::string configFingerprint(const IRGenConfig& irConfig, const CodeGenConfig& codeGenConfig);
+
+/**
+ * 编译一份源码。
+ *
+ * 汇编写入 out，所有诊断写入 diag；context 会被 reset 后复用，
+ * 因此同一线程可以用同一个上下文依次编译多个文件。
+ * 启用缓存时，成功的结果（汇编与诊断）按源码、配置和编译器身份写入缓存；
+ * 整份未命中时逐个函数按结构哈希查找，只重新编译改动过的函数。
+ *
+ * @return 编译成功返回 true
+ */
+bool compileSource(ParseContext& context, const std::string& source,
+                   const CompileOptions& options, std::ostream& out, std::ostream& diag);
+
+/**
+ * 编译一份源码到文本 IR（IRPrinter::print 的格式），写入 out。
+ *
+ * 输出可以被 IRReader 读回，供 toyc_opt 单独运行优化遍、toyc_llc 单独运行后端。
+ *
+ * @return 编译成功返回 true
+ */
+bool emitIRText(ParseContext& context, const std::string& source,
+                const CompileOptions& options, std::ostream& out, std::ostream& diag);
+
+/**
+ * 编译一份源码到二进制 IR（见 ir/ir_binary.h），写入 out。
+ *
+ * 与 compileSource() 走同样的前端和 IR 优化，只是不做代码生成；
+ * 之后可以用 compileIRBinary() 跳过前端直接生成汇编，
+ * 便于单独试验后端、或复用同一份优化后的 IR。
+ *
+ * @return 编译成功返回 true
+ */
+bool emitIRBinary(ParseContext& context, const std::string& source,
+                  const CompileOptions& options, std::ostream& out, std::ostream& diag);
+
+/**
+ * 从二进制 IR 文件生成汇编，只运行后端。
+ *
+ * 文件被只读映射，版本不符或已损坏时拒绝加载。IR 优化已在生成文件时完成，
+ * options 中只有代码生成相关的部分生效。
+ *
+ * @return 成功返回 true
+ */
+bool compileIRBinary(const std::string& path, const CompileOptions& options,
+                     std::ostream& out, std::ostream& diag);
+
+/**
+ * 从文本 IR 生成汇编，只运行后端。options 中只有代码生成相关的部分生效。
+ *
+ * @return 成功返回 true；IR 无法解析时写出出错行
+ */
+bool compileIRText(const std::string& text, const CompileOptions& options,
+                   std::ostream& out, std::ostream& diag);
+
+/**
+ * 流式编译一份源码。
+ *
+ * 语法分析每归约出一个函数，就立即做语义检查、生成 IR、优化并把汇编写入 out，
+ * 随后释放该函数的 AST 与 IR；峰值内存取决于最大的函数而不是整个文件。
+ * 成功时输出与 compileSource() 逐字节相同；失败时 out 中可能已有部分汇编，
+ * 由调用方丢弃。不查整份文件的缓存，但按函数的缓存照常生效。
+ *
+ * @return 编译成功返回 true
+ */
+bool compileStreaming(ParseContext& context, const std::string& source,
+                      const CompileOptions& options, std::ostream& out, std::ostream& diag);
+
+/**
+ * 流水线编译一份源码。
+ *
+ * 解析、语义分析、IR 生成、优化、寄存器分配与输出各占一个线程，
+ * 相邻阶段之间用单生产者单消费者队列连接：解析第 N+1 个函数的同时
+ * 优化第 N 个、输出第 N-1 个。队列定长，下游跟不上时上游阻塞，
+ * 同时在途的函数数有上限。当前线程按源码顺序写出，结果与 compileStreaming() 相同。
+ *
+ * @return 编译成功返回 true
+ */
+bool compilePipelined(ParseContext& context, const std::string& source,
+                      const CompileOptions& options, std::ostream& out, std::ostream& diag);
+
+struct BatchJob {
+    std::string inputPath;
+    std::string outputPath;
+};
+
+/**
+ * 在工作窃取线程池上编译一批文件。
+ *
+ * 每个文件的诊断单独收集，全部完成后按输入顺序写入 diag，
+ * 输出结果与线程数无关。
+ *
+ * @return 编译失败的文件数
+ */
+int compileBatch(const std::vector<BatchJob>& jobs, const CompileOptions& options,
+                 unsigned threadCount, std::ostream& diag);
+
+// 由输入路径和输出目录生成输出文件路径：outdir/<stem>.s
+std::string batchOutputPath(const std::string& inputPath, const std::string& outputDir);
@@ -0,0 +1,134 @@
+#include "function_hash.h"
+
+ContentHasher::Digest FunctionHasher::hash(FunctionDef& funcDef,
+                                           const std::map<std::string, FunctionSignature>& signatures) {
+    FunctionHasher visitor;
+    funcDef.accept(visitor);
+
+    // callees 是有序集合，签名按名字顺序写入
+    for (const auto& callee : visitor.callees) {
+        visitor.hasher.update(std::string_view(callee));
+        auto it = signatures.find(callee);
+        if (it == signatures.end()) {
+            visitor.hasher.update(static_cast<uint64_t>(NONE));
+            continue;
+        }
+        visitor.hasher.update(std::string_view(it->second.returnType));
+        visitor.hasher.update(static_cast<uint64_t>(it->second.paramCount));
+        visitor.hasher.update(it->second.summary.hi).update(it->second.summary.lo);
+    }
+    return visitor.hasher.digest();
+}
+
+void FunctionHasher::child(ASTNode* node) {
+    if (node) {
+        node->accept(*this);
+    } else {
+        hasher.update(static_cast<uint64_t>(NONE));
+    }
+}
+
+// ====== 表达式 ======
+
+void FunctionHasher::visit(NumberExpr& expr) {
+    hasher.update(static_cast<uint64_t>(NUMBER));
+    hasher.update(static_cast<uint64_t>(static_cast<int64_t>(expr.value)));
+}
+
+void FunctionHasher::visit(VariableExpr& expr) {
+    hasher.update(static_cast<uint64_t>(VARIABLE));
+    hasher.update(std::string_view(expr.name));
+}
+
+void FunctionHasher::visit(BinaryExpr& expr) {
+    hasher.update(static_cast<uint64_t>(BINARY));
+    hasher.update(std::string_view(expr.op));
+    child(expr.left.get());
+    child(expr.right.get());
+}
+
+void FunctionHasher::visit(UnaryExpr& expr) {
+    hasher.update(static_cast<uint64_t>(UNARY));
+    hasher.update(std::string_view(expr.op));
+    child(expr.operand.get());
+}
+
+void FunctionHasher::visit(CallExpr& expr) {
+    hasher.update(static_cast<uint64_t>(CALL));
+    hasher.update(std::string_view(expr.callee));
+    hasher.update(static_cast<uint64_t>(expr.arguments.size()));
+    for (const auto& arg : expr.arguments) {
+        child(arg.get());
+    }
+    callees.insert(expr.callee);
+}
+
+// ====== 语句 ======
+
+void FunctionHasher::visit(ExprStmt& stmt) {
+    hasher.update(static_cast<uint64_t>(EXPR_STMT));
+    child(stmt.expression.get());
+}
+
+void FunctionHasher::visit(VarDeclStmt& stmt) {
+    hasher.update(static_cast<uint64_t>(VAR_DECL));
+    hasher.update(std::string_view(stmt.name));
+    child(stmt.initializer.get());
+}
+
+void FunctionHasher::visit(AssignStmt& stmt) {
+    hasher.update(static_cast<uint64_t>(ASSIGN));
+    hasher.update(std::string_view(stmt.name));
+    child(stmt.value.get());
+}
+
+void FunctionHasher::visit(BlockStmt& stmt) {
+    hasher.update(static_cast<uint64_t>(BLOCK));
+    hasher.update(static_cast<uint64_t>(stmt.statements.size()));
+    for (const auto& s : stmt.statements) {
+        child(s.get());
+    }
+}
+
+void FunctionHasher::visit(IfStmt& stmt) {
+    hasher.update(static_cast<uint64_t>(IF));
+    child(stmt.condition.get());
+    child(stmt.thenBranch.get());
+    child(stmt.elseBranch.get());
+}
+
+void FunctionHasher::visit(WhileStmt& stmt) {
+    hasher.update(static_cast<uint64_t>(WHILE));
+    child(stmt.condition.get());
+    child(stmt.body.get());
+}
+
+void FunctionHasher::visit(BreakStmt&) {
+    hasher.update(static_cast<uint64_t>(BREAK));
+}
+
+void FunctionHasher::visit(ContinueStmt&) {
+    hasher.update(static_cast<uint64_t>(CONTINUE));
+}
+
+void FunctionHasher::visit(ReturnStmt& stmt) {
+    hasher.update(static_cast<uint64_t>(RETURN));
+    child(stmt.value.get());
+}
+
+// ====== 函数 ======
+
+void FunctionHasher::visit(FunctionDef& funcDef) {
+    hasher.update(static_cast<uint64_t>(FUNCTION));
+    hasher.update(std::string_view(funcDef.returnType));
+    hasher.update(std::string_view(funcDef.name));
+    hasher.update(static_cast<uint64_t>(funcDef.params.size()));
+    for (const auto& param : funcDef.params) {
+        hasher.update(std::string_view(param.name));
+    }
+    child(funcDef.body.get());
+}
+
+void FunctionHasher::visit(CompUnit&) {
+    // 只对单个函数求哈希，不会访问到编译单元
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "hash.h"
+#include "parser/ast.h"
+#include <map>
+#include <set>
+#include <string>
+
+// ==================== 函数结构哈希 ====================
+
+// 被调函数的签名；流式编译时函数定义处理完即释放，因此按值保存
+struct FunctionSignature {
+    std::string returnType;
+    size_t paramCount = 0;
+    // 该函数自己的结构哈希，计算缓存键时登记；调用者生成的汇编取决于它改写哪些寄存器
+    ContentHasher::Digest summary;
+};
+
+/**
+ * 对单个函数定义做结构哈希，作为按函数缓存的键。
+ *
+ * 只吸收影响代码生成的内容：节点种类、运算符、名字、常量值和树形结构，
+ * 不包含行号列号，因此在别处增删代码导致的行号变化不会让函数失效。
+ * 函数体调用到的每个被调函数，其签名（返回类型、参数个数）和结构哈希也一并计入：
+ * 调用处会避开被调函数改写的寄存器，而被调函数的结构哈希又包含了它的被调函数，
+ * 合起来足以决定该函数的 IR 和汇编。
+ */
+class FunctionHasher : public ASTVisitor {
+public:
+    // signatures：已知函数名到签名的映射，用于查找被调函数签名
+    static ContentHasher::Digest hash(FunctionDef& funcDef,
+                                      const std::map<std::string, FunctionSignature>& signatures);
+
+    void visit(NumberExpr& expr) override;
+    void visit(VariableExpr& expr) override;
+    void visit(BinaryExpr& expr) override;
+    void visit(UnaryExpr& expr) override;
+    void visit(CallExpr& expr) override;
+
+    void visit(ExprStmt& stmt) override;
+    void visit(VarDeclStmt& stmt) override;
+    void visit(AssignStmt& stmt) override;
+    void visit(BlockStmt& stmt) override;
+    void visit(IfStmt& stmt) override;
+    void visit(WhileStmt& stmt) override;
+    void visit(BreakStmt& stmt) override;
+    void visit(ContinueStmt& stmt) override;
+    void visit(ReturnStmt& stmt) override;
+
+    void visit(FunctionDef& funcDef) override;
+    void visit(CompUnit& compUnit) override;
+
+private:
+    // 节点标记，保证不同结构不会拼出相同的字节序列
+    enum Tag : uint64_t {
+        NUMBER = 1, VARIABLE, BINARY, UNARY, CALL,
+        EXPR_STMT, VAR_DECL, ASSIGN, BLOCK, IF, WHILE, BREAK, CONTINUE, RETURN,
+        FUNCTION, NONE
+    };
+
+    ContentHasher hasher;
+    std::set<std::string> callees;
+
+    void child(ASTNode* node);
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// ==================== 内容哈希 ====================
+
+/**
+ * 128 位内容哈希，用作缓存键。
+ *
+ * 两条 64 位通道以不同种子并行吸收 8 字节块，每块经乘法-移位混合，
+ * 结束时做 splitmix64 终混。不是密码学哈希，但对缓存键而言碰撞概率
+ * 可以忽略。支持分多次 update，结果与一次性输入相同。
+ */
+class ContentHasher {
+private:
+    uint64_t lane0 = 0x9E3779B97F4A7C15ull;
+    uint64_t lane1 = 0xC2B2AE3D27D4EB4Full;
+    uint64_t length = 0;
+    unsigned char pending[8];
+    size_t pendingSize = 0;
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    void absorb(uint64_t block) {
+        lane0 = (lane0 ^ mix(block)) * 0x100000001B3ull + 0x2545F4914F6CDD1Dull;
+        lane1 = (lane1 + mix(block ^ 0xA0761D6478BD642Full)) * 0x9FB21C651E98DF25ull;
+        lane1 ^= lane1 >> 29;
+    }
+
+public:
+    ContentHasher& update(const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        length += size;
+        while (size > 0) {
+            size_t take = std::min(size, sizeof(pending) - pendingSize);
+            std::memcpy(pending + pendingSize, p, take);
+            pendingSize += take;
+            p += take;
+            size -= take;
+            if (pendingSize == sizeof(pending)) {
+                uint64_t block;
+                std::memcpy(&block, pending, sizeof(block));
+                absorb(block);
+                pendingSize = 0;
+            }
+        }
+        return *this;
+    }
+
+    ContentHasher& update(std::string_view text) {
+        // 先写入长度，避免 "ab"+"c" 与 "a"+"bc" 得到相同结果
+        uint64_t size = text.size();
+        update(&size, sizeof(size));
+        return update(text.data(), text.size());
+    }
+
+    ContentHasher& update(uint64_t value) { return update(&value, sizeof(value)); }
+
+    struct Digest {
+        uint64_t hi = 0;
+        uint64_t lo = 0;
+
+        bool operator==(const Digest& other) const { return hi == other.hi && lo == other.lo; }
+        bool operator!=(const Digest& other) const { return !(*this == other); }
+
+        std::string hex() const {
+            char buffer[33];
+            std::snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+                          static_cast<unsigned long long>(hi), static_cast<unsigned long long>(lo));
+            return buffer;
+        }
+    };
+
+    Digest digest() const {
+        uint64_t a = lane0;
+        uint64_t b = lane1;
+        uint64_t tail = 0;
+        std::memcpy(&tail, pending, pendingSize);
+        a = (a ^ mix(tail ^ length)) * 0x100000001B3ull;
+        b = (b + mix(tail + (length << 1))) * 0x9FB21C651E98DF25ull;
+        return {mix(a ^ (b >> 17)), mix(b + a)};
+    }
+};
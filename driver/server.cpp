@@ -0,0 +1,421 @@
+#include "server.h"
+#include "disk_cache.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// 协议版本，报文格式变化时递增
+static constexpr uint32_t kProtocolVersion = 3;
+static constexpr char kMagic[4] = {'T', 'O', 'Y', 'C'};
+
+enum class RequestType : uint32_t {
+    COMPILE = 0,
+    SHUTDOWN = 1,
+};
+
+enum class ReplyStatus : uint32_t {
+    OK = 0,
+    COMPILE_FAILED = 1,
+    BAD_REQUEST = 2,
+};
+
+// 单个请求源码的上限，防止异常客户端耗尽内存
+static constexpr uint32_t kMaxSourceBytes = 256u * 1024 * 1024;
+static constexpr uint32_t kMaxOptionBytes = 64u * 1024;
+
+// ==================== 套接字读写 ====================
+
+static bool writeAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = ::recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool writeU32(int fd, uint32_t value) {
+    unsigned char bytes[4] = {
+        static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+        static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)};
+    return writeAll(fd, bytes, sizeof(bytes));
+}
+
+static bool readU32(int fd, uint32_t& value) {
+    unsigned char bytes[4];
+    if (!readAll(fd, bytes, sizeof(bytes))) return false;
+    value = static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+            (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    return true;
+}
+
+static bool writeU64(int fd, uint64_t value) {
+    return writeU32(fd, static_cast<uint32_t>(value)) && writeU32(fd, static_cast<uint32_t>(value >> 32));
+}
+
+static bool readU64(int fd, uint64_t& value) {
+    uint32_t low, high;
+    if (!readU32(fd, low) || !readU32(fd, high)) return false;
+    value = static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+    return true;
+}
+
+static bool writeBlob(int fd, const std::string& blob) {
+    return writeU32(fd, static_cast<uint32_t>(blob.size())) && writeAll(fd, blob.data(), blob.size());
+}
+
+static bool readBlob(int fd, std::string& blob, uint32_t limit) {
+    uint32_t size;
+    if (!readU32(fd, size) || size > limit) return false;
+    blob.resize(size);
+    return readAll(fd, blob.data(), size);
+}
+
+static bool fillAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// 连接另一端的进程是否属于当前用户；汇编要直接当作输出，别人的进程不可信
+static bool peerIsSameUser(int fd) {
+#ifdef SO_PEERCRED
+    ucred cred;
+    socklen_t length = sizeof(cred);
+    if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) != 0 || length != sizeof(cred)) {
+        return false;
+    }
+    return cred.uid == ::getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    return ::getpeereid(fd, &uid, &gid) == 0 && uid == ::getuid();
+#endif
+}
+
+// 只连接当前用户自己的服务器；路径上是别人的进程时当作没有服务器
+static int connectTo(const std::string& path) {
+    sockaddr_un addr;
+    if (!fillAddress(path, addr)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || !peerIsSameUser(fd)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 没有 XDG_RUNTIME_DIR 时套接字放在 /tmp 下的私有目录里
+static std::string privateSocketDirectory() {
+    return "/tmp/toyc-" + std::to_string(::getuid());
+}
+
+// 创建（或确认）只有当前用户能访问的目录：必须是本人所有、不是符号链接、组和其他人无任何权限
+static bool preparePrivateDirectory(const std::string& dir) {
+    if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    struct stat info;
+    return ::lstat(dir.c_str(), &info) == 0 && S_ISDIR(info.st_mode) && info.st_uid == ::getuid() &&
+           (info.st_mode & 077) == 0;
+}
+
+std::string defaultServerSocketPath() {
+    if (const char* env = std::getenv("TOYC_SERVER_SOCKET")) {
+        if (*env) return env;
+    }
+    if (const char* runtime = std::getenv("XDG_RUNTIME_DIR")) {
+        if (*runtime) return std::string(runtime) + "/toyc.sock";
+    }
+    return privateSocketDirectory() + "/server.sock";
+}
+
+// ==================== 结果缓存 ====================
+
+/**
+ * 以（编译选项, 源码）为键的 LRU 结果缓存。
+ * 编辑器保存时常常重复提交未改动的文件，命中后无需再走一遍流水线。
+ */
+class ResultCache {
+private:
+    struct Entry {
+        std::string key;
+        ServerReply reply;
+    };
+
+    std::mutex mutex;
+    std::list<Entry> entries;  // 表头为最近使用
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    size_t bytes = 0;
+    size_t capacityBytes;
+
+    static size_t entryBytes(const Entry& entry) {
+        return entry.key.size() + entry.reply.assembly.size() + entry.reply.diagnostics.size();
+    }
+
+public:
+    explicit ResultCache(size_t capacityBytes) : capacityBytes(capacityBytes) {}
+
+    static std::string makeKey(const std::string& arguments, const std::string& source) {
+        std::string key = arguments;
+        key += '\0';
+        key += source;
+        return key;
+    }
+
+    bool lookup(const std::string& key, ServerReply& reply) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) return false;
+        entries.splice(entries.begin(), entries, it->second);
+        reply = it->second->reply;
+        return true;
+    }
+
+    void insert(std::string key, const ServerReply& reply) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (index.count(key)) return;
+        entries.push_front({std::move(key), reply});
+        index.emplace(entries.front().key, entries.begin());
+        bytes += entryBytes(entries.front());
+        while (bytes > capacityBytes && entries.size() > 1) {
+            Entry& victim = entries.back();
+            bytes -= entryBytes(victim);
+            index.erase(victim.key);
+            entries.pop_back();
+        }
+    }
+};
+
+// ==================== 服务端 ====================
+
+static void serveCompile(int fd, const std::string& arguments, const std::string& source,
+                         ResultCache& cache, DiskCache* diskCache) {
+    // 选项按客户端的规范形式逐个解析，与命令行走同一套规则
+    CompileOptions options;
+    std::ostringstream optionErrors;
+    std::istringstream argumentStream(arguments);
+    std::string argument;
+    while (argumentStream >> argument) {
+        if (parseCompileOption(argument, options, optionErrors) != OptionParse::ACCEPTED) {
+            writeU32(fd, static_cast<uint32_t>(ReplyStatus::BAD_REQUEST));
+            return;
+        }
+    }
+
+    // -stats 报告的是这一次编译的耗时，不从结果缓存回答
+    std::string key = ResultCache::makeKey(arguments, source);
+    ServerReply reply;
+    if (options.stats || !cache.lookup(key, reply)) {
+        // 每个工作线程一个常驻上下文，arena 在请求之间保持温热
+        thread_local ParseContext context;
+
+        options.cache = diskCache;
+        std::ostringstream assembly;
+        std::ostringstream diagnostics;
+        bool threw = false;
+        try {
+            reply.ok = compileSource(context, source, options, assembly, diagnostics);
+        } catch (const std::exception& e) {
+            // 与批量编译相同：异常只让这一次请求失败，服务器继续运行
+            diagnostics << "Error: " << e.what() << std::endl;
+            reply.ok = false;
+            threw = true;
+        }
+        context.reset();
+        reply.assembly = threw ? std::string() : assembly.str();
+        reply.diagnostics = diagnostics.str();
+        if (!options.stats && !threw) {
+            cache.insert(std::move(key), reply);
+        }
+    }
+
+    ReplyStatus status = reply.ok ? ReplyStatus::OK : ReplyStatus::COMPILE_FAILED;
+    writeU32(fd, static_cast<uint32_t>(status)) && writeBlob(fd, reply.assembly) &&
+        writeBlob(fd, reply.diagnostics);
+}
+
+static void handleConnection(int fd, int listener, ResultCache& cache, DiskCache* diskCache,
+                             std::atomic<bool>& stopping) {
+    char magic[4];
+    uint32_t version, type, flags;
+    if (!readAll(fd, magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(magic)) != 0 ||
+        !readU32(fd, version)) {
+        return;
+    }
+    if (version != kProtocolVersion) {
+        writeU32(fd, static_cast<uint32_t>(ReplyStatus::BAD_REQUEST));
+        return;
+    }
+    DiskCache::Key identity;
+    if (!readU32(fd, type) || !readU32(fd, flags) || !readU64(fd, identity.hi) || !readU64(fd, identity.lo)) {
+        return;
+    }
+
+    if (type == static_cast<uint32_t>(RequestType::SHUTDOWN)) {
+        stopping = true;
+        // 让阻塞在 accept 上的主循环返回
+        ::shutdown(listener, SHUT_RDWR);
+        writeU32(fd, static_cast<uint32_t>(ReplyStatus::OK));
+        return;
+    }
+
+    // 客户端是重新构建过的编译器时，这里的结果已经过时，让它自己在本地编译
+    if (!(identity == DiskCache::compilerIdentity())) {
+        writeU32(fd, static_cast<uint32_t>(ReplyStatus::BAD_REQUEST));
+        return;
+    }
+
+    std::string arguments;
+    std::string source;
+    if (type == static_cast<uint32_t>(RequestType::COMPILE) && readBlob(fd, arguments, kMaxOptionBytes) &&
+        readBlob(fd, source, kMaxSourceBytes)) {
+        serveCompile(fd, arguments, source, cache, diskCache);
+    } else {
+        writeU32(fd, static_cast<uint32_t>(ReplyStatus::BAD_REQUEST));
+    }
+}
+
+int runServer(const std::string& socketPath, unsigned threadCount, DiskCache* diskCache) {
+    sockaddr_un addr;
+    if (!fillAddress(socketPath, addr)) {
+        std::cerr << "Error: Socket path too long: " << socketPath << std::endl;
+        return 1;
+    }
+
+    // 默认的私有目录可能被别人抢先建好，不是自己的就不能在里面监听
+    std::string privateDir = privateSocketDirectory();
+    if (socketPath.compare(0, privateDir.size() + 1, privateDir + "/") == 0 &&
+        !preparePrivateDirectory(privateDir)) {
+        std::cerr << "Error: Socket directory " << privateDir
+                  << " is not a private directory owned by the current user" << std::endl;
+        return 1;
+    }
+
+    // 已有服务器在运行则拒绝启动；连不上说明是残留的套接字文件
+    int probe = connectTo(socketPath);
+    if (probe >= 0) {
+        ::close(probe);
+        std::cerr << "Error: A server is already listening on " << socketPath << std::endl;
+        return 1;
+    }
+    ::unlink(socketPath.c_str());
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 ||
+        ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listener, 64) != 0) {
+        std::cerr << "Error: Cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (listener >= 0) ::close(listener);
+        return 1;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::cerr << "toyc server listening on " << socketPath << std::endl;
+
+    ResultCache cache(64u * 1024 * 1024);
+    std::atomic<bool> stopping{false};
+    {
+        WorkStealingPool pool(threadCount);
+        while (!stopping.load()) {
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (stopping.load()) {
+                ::close(fd);
+                break;
+            }
+            // 其他用户的请求（包括停止请求）一律不处理
+            if (!peerIsSameUser(fd)) {
+                ::close(fd);
+                continue;
+            }
+
+            // 报文读取与编译都交给线程池，慢客户端不会阻塞 accept
+            pool.submit([fd, listener, &cache, diskCache, &stopping] {
+                try {
+                    handleConnection(fd, listener, cache, diskCache, stopping);
+                } catch (const std::exception& e) {
+                    // 编译以外的异常（如内存不足）只断开这个连接
+                    std::cerr << "Error: " << e.what() << std::endl;
+                }
+                ::close(fd);
+            });
+        }
+        pool.wait();
+    }
+
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    return 0;
+}
+
+// ==================== 客户端 ====================
+
+static bool sendHeader(int fd, RequestType type, uint32_t flags) {
+    const DiskCache::Key& identity = DiskCache::compilerIdentity();
+    return writeAll(fd, kMagic, sizeof(kMagic)) && writeU32(fd, kProtocolVersion) &&
+           writeU32(fd, static_cast<uint32_t>(type)) && writeU32(fd, flags) &&
+           writeU64(fd, identity.hi) && writeU64(fd, identity.lo);
+}
+
+bool compileViaServer(const std::string& socketPath, const std::string& source,
+                      const CompileOptions& options, ServerReply& reply) {
+    int fd = connectTo(socketPath);
+    if (fd < 0) return false;
+
+    uint32_t status;
+    bool ok = sendHeader(fd, RequestType::COMPILE, 0) &&
+              writeBlob(fd, compileOptionArguments(options)) && writeBlob(fd, source) &&
+              readU32(fd, status) && status != static_cast<uint32_t>(ReplyStatus::BAD_REQUEST) &&
+              readBlob(fd, reply.assembly, UINT32_MAX) && readBlob(fd, reply.diagnostics, UINT32_MAX);
+    ::close(fd);
+    if (!ok) return false;
+
+    reply.ok = status == static_cast<uint32_t>(ReplyStatus::OK);
+    return true;
+}
+
+bool stopServer(const std::string& socketPath) {
+    int fd = connectTo(socketPath);
+    if (fd < 0) return false;
+    uint32_t status = 0;
+    bool ok = sendHeader(fd, RequestType::SHUTDOWN, 0) && readU32(fd, status);
+    ::close(fd);
+    return ok && status == static_cast<uint32_t>(ReplyStatus::OK);
+}
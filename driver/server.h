@@ -0,0 +1,37 @@
+#pragma once
+#include "driver.h"
+#include <string>
+
+// ==================== 编译服务器 ====================
+//
+// toyc_compiler --server 在 Unix 域套接字上常驻，接受编译请求并返回汇编与
+// 诊断。工作线程各自保留解析上下文（arena 常热），相同输入直接命中结果缓存。
+// 单文件模式下客户端会先尝试连接服务器，连接不上再在本地编译。
+//
+// 报文格式（整数均为小端 uint32）：
+//   请求: "TOYC" 版本 类型 标志(保留为 0) 编译器身份(两个 uint64) 选项长度 选项 源码长度 源码
+//         编译器身份是 DiskCache::compilerIdentity()；与服务器不同（编译器重新构建过）时
+//         编译请求回答 BAD_REQUEST，客户端改在本地编译；停止请求不检查身份，旧服务器仍能停掉
+//         选项是 compileOptionArguments() 的输出，服务器用 parseCompileOption() 还原
+//   响应: 状态 汇编长度 汇编 诊断长度 诊断
+
+// 套接字路径：环境变量 TOYC_SERVER_SOCKET，否则 $XDG_RUNTIME_DIR/toyc.sock，
+// 都没有时为 /tmp/toyc-<uid>/server.sock（目录权限 0700，由服务器创建并检查归属）。
+// 客户端和服务器都用 SO_PEERCRED 确认对端是同一用户，不是则当作没有服务器
+std::string defaultServerSocketPath();
+
+// 前台运行服务器，直到收到停止请求；返回进程退出码。cache 非空时未命中内存缓存的请求再查磁盘缓存
+int runServer(const std::string& socketPath, unsigned threadCount, DiskCache* cache = nullptr);
+
+struct ServerReply {
+    bool ok = false;
+    std::string assembly;
+    std::string diagnostics;
+};
+
+// 通过服务器编译；没有可用服务器（或协议版本、编译器身份不符）时返回 false，调用方应本地编译
+bool compileViaServer(const std::string& socketPath, const std::string& source,
+                      const CompileOptions& options, ServerReply& reply);
+
+// 请求服务器退出；服务器不存在时返回 false
+bool stopServer(const std::string& socketPath);
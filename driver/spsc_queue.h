@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// ==================== 单生产者单消费者队列 ====================
+
+/**
+ * 定长环形缓冲，恰好一个线程 push、一个线程 pop。
+ *
+ * 读写位置各自只由一方修改，入队出队只需一次 acquire 读和一次 release 写，
+ * 不加锁。队列满时 push 阻塞（背压），空时 pop 阻塞；阻塞用 C++20 的
+ * atomic wait/notify，不忙等，线程数多于核数时也不会空转。
+ * T 需可默认构造和移动赋值。
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : capacity(capacity), slots(new T[capacity]) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    void push(T value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        while (t - h == capacity) {
+            head.wait(h, std::memory_order_acquire);
+            h = head.load(std::memory_order_acquire);
+        }
+        slots[t % capacity] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        tail.notify_one();
+    }
+
+    T pop() {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        while (t == h) {
+            tail.wait(t, std::memory_order_acquire);
+            t = tail.load(std::memory_order_acquire);
+        }
+        // 移出后槽位留下空对象，不让已消费的数据继续占用内存
+        T value = std::move(slots[h % capacity]);
+        slots[h % capacity] = T();
+        head.store(h + 1, std::memory_order_release);
+        head.notify_one();
+        return value;
+    }
+
+private:
+    // 两个位置放在不同缓存行，避免生产者和消费者互相使对方的缓存行失效
+    static constexpr size_t kCacheLine = 64;
+
+    const size_t capacity;
+    std::unique_ptr<T[]> slots;
+    alignas(kCacheLine) std::atomic<size_t> head{0};   // 下一个读取位置，只由消费者修改
+    alignas(kCacheLine) std::atomic<size_t> tail{0};   // 下一个写入位置，只由生产者修改
+};
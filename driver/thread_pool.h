@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ==================== 工作窃取线程池 ====================
+
+/**
+ * 每个工作线程有自己的任务队列：提交时轮流分配到各队列，线程优先从
+ * 自己队列的尾部取任务，队列空了再从其他线程队列的头部窃取。
+ * 编译单个文件的耗时差异很大，窃取保证大文件不会拖住整批任务。
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(unsigned threadCount);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task);
+
+    // 阻塞直到已提交的任务全部执行完毕
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t queued = 0;      // 尚未被取走的任务数
+    size_t unfinished = 0;  // 尚未执行完的任务数
+    size_t nextWorker = 0;
+    bool stopping = false;
+
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t index, Task& task);
+    void run(size_t index);
+};
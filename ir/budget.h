@@ -0,0 +1,61 @@
+#pragma once
+#include "ir.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// ==================== 编译预算 ====================
+
+/**
+ * 单个函数的规模，在运行开销大的步骤之前估算它的工作量。
+ *
+ * 全局数据流遍在每个基本块上维护一份以名字为键的集合，工作量约为 块数 × 名字数；
+ * 图着色按名字两两比较建冲突图，约为 名字数²。估算只看 IR 本身而不计时，
+ * 同一个函数每次都得到同样的决定，输出因此仍然可以按函数缓存。
+ */
+struct FunctionSize {
+    size_t instrs = 0;
+    size_t blocks = 0;
+    size_t names = 0;   // 不同的变量和临时变量
+
+    uint64_t dataflowCost() const { return static_cast<uint64_t>(blocks) * names; }
+    uint64_t pairCost() const { return static_cast<uint64_t>(names) * names; }
+
+    static FunctionSize measure(const std::vector<std::shared_ptr<IRInstr>>& instructions) {
+        FunctionSize size;
+        size.instrs = instructions.size();
+        size.blocks = 1;
+        std::unordered_set<std::string> names;
+        bool afterJump = false;
+        for (const auto& instr : instructions) {
+            // 标签和跳转之后的指令开始新的基本块
+            if (instr->opcode == OpCode::LABEL || afterJump) {
+                size.blocks++;
+            }
+            afterJump = instr->opcode == OpCode::GOTO || instr->opcode == OpCode::IF_GOTO ||
+                        instr->opcode == OpCode::RETURN;
+            for (const auto& name : IRAnalyzer::getDefinedVariables(instr)) {
+                names.insert(name);
+            }
+            for (const auto& name : IRAnalyzer::getUsedVariables(instr)) {
+                names.insert(name);
+            }
+        }
+        size.names = names.size();
+        return size;
+    }
+};
+
+/**
+ * 一次预算降级：某个函数上开销大的步骤因估算的工作量超出预算，
+ * 换成了便宜的替代（fallback 为空表示直接跳过）。由 -stats 汇总输出。
+ */
+struct BudgetEvent {
+    std::string function;
+    std::string step;
+    std::string fallback;
+    uint64_t cost = 0;
+    uint64_t budget = 0;
+};
@@ -4,6 +4,7 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <functional>
 
 // ==================== 枚举和结构体定义 ====================
 
@@ -22,7 +23,7 @@ enum class OpCode {
     SHL, SHR,  // 左移和右移
     ASSIGN,
     GOTO, IF_GOTO,
-    PARAM, CALL, RETURN,
+    CALL, RETURN,
     LABEL,
     FUNCTION_BEGIN, FUNCTION_END
 };
@@ -168,24 +169,6 @@ public:
     }
 };
 
-class ParamInstr : public IRInstr {
-public:
-    std::shared_ptr<Operand> param;
-    
-    ParamInstr(std::shared_ptr<Operand> param)
-        : IRInstr(OpCode::PARAM), param(param) {}
-    
-    std::string toString() const override;
-
-    std::vector<std::string> getDefRegisters() override {
-        return {};
-    }
-            
-    std::vector<std::string> getUseRegisters() override {
-        return extractReg(param);
-    }
-};
-
 class CallInstr : public IRInstr {
 public:
     std::shared_ptr<Operand> result;
@@ -316,4 +299,10 @@ public:
 
     static void replaceUsedVariable(std::shared_ptr<IRInstr>& instr, 
                             const std::string& oldVar, const std::shared_ptr<Operand>& newOp);
+
+    // 复制一条指令，变量和临时变量操作数换成 rename(操作数, 是否为结果) 的返回值。
+    // 先依次处理读的操作数，最后处理结果；原指令可能与别处共享，不做修改
+    using OperandRenamer = std::function<std::shared_ptr<Operand>(const std::shared_ptr<Operand>&, bool)>;
+    static std::shared_ptr<IRInstr> rewriteOperands(const std::shared_ptr<IRInstr>& instr,
+                                                    const OperandRenamer& rename);
 };
\ No newline at end of file
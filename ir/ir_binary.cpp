@@ -0,0 +1,577 @@
+#include "ir_binary.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace irbin;
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'C', 'I', 'R'};
+
+// 二元运算、一元运算在 IR 中共用操作码区间，按操作码即可确定指令类
+bool isBinaryOp(OpCode op) {
+    switch (op) {
+        case OpCode::ADD: case OpCode::SUB: case OpCode::MUL: case OpCode::DIV: case OpCode::MOD:
+        case OpCode::LT: case OpCode::GT: case OpCode::LE: case OpCode::GE: case OpCode::EQ: case OpCode::NE:
+        case OpCode::AND: case OpCode::OR: case OpCode::SHL: case OpCode::SHR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isUnaryOp(OpCode op) {
+    return op == OpCode::NEG || op == OpCode::NOT;
+}
+
+uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+// 各段先在内存中构建，最后一次性拼成文件
+class ModuleBuilder {
+public:
+    std::vector<StringRecord> strings;
+    std::string stringData;
+    std::vector<FunctionRecord> functions;
+    std::vector<InstrRecord> instrs;
+    std::vector<OperandRecord> operands;
+    std::vector<BlockRecord> blocks;
+    std::vector<uint32_t> edges;
+    std::vector<VregRecord> vregs;
+
+    uint32_t intern(const std::string& text) {
+        auto it = stringIndex.find(text);
+        if (it != stringIndex.end()) {
+            return it->second;
+        }
+        uint32_t index = static_cast<uint32_t>(strings.size());
+        strings.push_back({static_cast<uint32_t>(stringData.size()), static_cast<uint32_t>(text.size())});
+        stringData += text;
+        stringIndex.emplace(text, index);
+        return index;
+    }
+
+    void addOperand(const std::shared_ptr<Operand>& op) {
+        OperandRecord record{};
+        record.name = kNoString;
+        if (!op) {
+            record.type = kNullOperand;
+        } else {
+            record.type = static_cast<uint8_t>(op->type);
+            if (op->type != OperandType::CONSTANT) {
+                record.name = intern(op->name);
+            }
+            record.value = op->value;
+        }
+        operands.push_back(record);
+    }
+
+    void addFunction(const std::vector<std::shared_ptr<IRInstr>>& instructions, size_t begin, size_t end);
+
+private:
+    std::unordered_map<std::string, uint32_t> stringIndex;
+
+    void addInstr(const std::shared_ptr<IRInstr>& instr);
+    void addBlocks(size_t firstInstr, size_t instrCount);
+    void addVregs(const std::vector<std::shared_ptr<IRInstr>>& instructions, size_t begin, size_t end,
+                  uint32_t firstInstr);
+};
+
+void ModuleBuilder::addInstr(const std::shared_ptr<IRInstr>& instr) {
+    InstrRecord record{};
+    record.opcode = static_cast<uint8_t>(instr->opcode);
+    record.symbol = kNoString;
+    record.firstOperand = static_cast<uint32_t>(operands.size());
+
+    OpCode op = instr->opcode;
+    if (isBinaryOp(op)) {
+        auto bin = std::static_pointer_cast<BinaryOpInstr>(instr);
+        addOperand(bin->result);
+        addOperand(bin->left);
+        addOperand(bin->right);
+    } else if (isUnaryOp(op)) {
+        auto unary = std::static_pointer_cast<UnaryOpInstr>(instr);
+        addOperand(unary->result);
+        addOperand(unary->operand);
+    } else {
+        switch (op) {
+            case OpCode::ASSIGN: {
+                auto assign = std::static_pointer_cast<AssignInstr>(instr);
+                addOperand(assign->target);
+                addOperand(assign->source);
+                break;
+            }
+            case OpCode::GOTO:
+                addOperand(std::static_pointer_cast<GotoInstr>(instr)->target);
+                break;
+            case OpCode::IF_GOTO: {
+                auto ifGoto = std::static_pointer_cast<IfGotoInstr>(instr);
+                addOperand(ifGoto->condition);
+                addOperand(ifGoto->target);
+                break;
+            }
+            case OpCode::CALL: {
+                auto call = std::static_pointer_cast<CallInstr>(instr);
+                record.symbol = intern(call->funcName);
+                record.count = call->paramCount;
+                addOperand(call->result);
+                for (const auto& param : call->params) {
+                    addOperand(param);
+                }
+                break;
+            }
+            case OpCode::RETURN:
+                addOperand(std::static_pointer_cast<ReturnInstr>(instr)->value);
+                break;
+            case OpCode::LABEL:
+                record.symbol = intern(std::static_pointer_cast<LabelInstr>(instr)->label);
+                break;
+            case OpCode::FUNCTION_BEGIN: {
+                auto begin = std::static_pointer_cast<FunctionBeginInstr>(instr);
+                record.symbol = intern(begin->funcName);
+                for (const auto& param : begin->paramNames) {
+                    addOperand(std::make_shared<Operand>(OperandType::VARIABLE, param));
+                }
+                break;
+            }
+            case OpCode::FUNCTION_END:
+                record.symbol = intern(std::static_pointer_cast<FunctionEndInstr>(instr)->funcName);
+                break;
+            default:
+                break;
+        }
+    }
+    record.operandCount = static_cast<uint32_t>(operands.size()) - record.firstOperand;
+    instrs.push_back(record);
+}
+
+// 在标签处和跳转、返回之后切分基本块，再按块尾指令连边
+void ModuleBuilder::addBlocks(size_t firstInstr, size_t instrCount) {
+    size_t firstBlock = blocks.size();
+    std::unordered_map<uint32_t, uint32_t> labelBlocks;   // 标签名下标 -> 块下标
+    for (size_t i = firstInstr; i < firstInstr + instrCount; ++i) {
+        const InstrRecord& record = instrs[i];
+        bool leader = i == firstInstr || record.opcode == static_cast<uint8_t>(OpCode::LABEL);
+        if (i > firstInstr) {
+            OpCode prev = static_cast<OpCode>(instrs[i - 1].opcode);
+            leader = leader || prev == OpCode::GOTO || prev == OpCode::IF_GOTO || prev == OpCode::RETURN;
+        }
+        if (leader) {
+            blocks.push_back({static_cast<uint32_t>(i), 0, 0, 0});
+        }
+        blocks.back().instrCount++;
+        if (record.opcode == static_cast<uint8_t>(OpCode::LABEL)) {
+            labelBlocks[record.symbol] = static_cast<uint32_t>(blocks.size() - 1);
+        }
+    }
+
+    for (size_t b = firstBlock; b < blocks.size(); ++b) {
+        BlockRecord& block = blocks[b];
+        block.firstEdge = static_cast<uint32_t>(edges.size());
+        const InstrRecord& last = instrs[block.firstInstr + block.instrCount - 1];
+        OpCode op = static_cast<OpCode>(last.opcode);
+        if (op == OpCode::GOTO || op == OpCode::IF_GOTO) {
+            const OperandRecord& target = operands[last.firstOperand + last.operandCount - 1];
+            auto it = labelBlocks.find(target.name);
+            if (it != labelBlocks.end()) {
+                edges.push_back(it->second);
+            }
+        }
+        if (op != OpCode::GOTO && op != OpCode::RETURN && b + 1 < blocks.size()) {
+            edges.push_back(static_cast<uint32_t>(b + 1));
+        }
+        block.edgeCount = static_cast<uint32_t>(edges.size()) - block.firstEdge;
+    }
+}
+
+void ModuleBuilder::addVregs(const std::vector<std::shared_ptr<IRInstr>>& instructions,
+                             size_t begin, size_t end, uint32_t firstInstr) {
+    std::unordered_map<std::string, size_t> slots;
+    auto slotFor = [&](const std::string& name, uint32_t position) -> VregRecord& {
+        auto it = slots.find(name);
+        if (it == slots.end()) {
+            it = slots.emplace(name, vregs.size()).first;
+            VregRecord record{};
+            record.name = intern(name);
+            record.kind = VregKind::VARIABLE;
+            record.firstRef = position;
+            vregs.push_back(record);
+        }
+        VregRecord& record = vregs[it->second];
+        record.lastRef = position;
+        return record;
+    };
+
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t position = firstInstr + static_cast<uint32_t>(i - begin);
+        const InstrRecord& record = instrs[position];
+        for (uint32_t k = 0; k < record.operandCount; ++k) {
+            const OperandRecord& op = operands[record.firstOperand + k];
+            if (op.type == static_cast<uint8_t>(OperandType::TEMP)) {
+                slotFor(std::string(stringData, strings[op.name].offset, strings[op.name].length), position)
+                    .kind = VregKind::TEMP;
+            }
+        }
+        for (const auto& name : instructions[i]->getDefRegisters()) {
+            slotFor(name, position).defCount++;
+        }
+        for (const auto& name : instructions[i]->getUseRegisters()) {
+            slotFor(name, position).useCount++;
+        }
+    }
+}
+
+void ModuleBuilder::addFunction(const std::vector<std::shared_ptr<IRInstr>>& instructions,
+                                size_t begin, size_t end) {
+    FunctionRecord record{};
+    for (size_t i = begin; i < end; ++i) {
+        if (instructions[i]->opcode == OpCode::FUNCTION_BEGIN) {
+            auto funcBegin = std::static_pointer_cast<FunctionBeginInstr>(instructions[i]);
+            record.name = intern(funcBegin->funcName);
+            record.returnType = intern(funcBegin->returnType);
+            break;
+        }
+    }
+    record.firstInstr = static_cast<uint32_t>(instrs.size());
+    record.instrCount = static_cast<uint32_t>(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        addInstr(instructions[i]);
+    }
+
+    record.firstBlock = static_cast<uint32_t>(blocks.size());
+    addBlocks(record.firstInstr, record.instrCount);
+    record.blockCount = static_cast<uint32_t>(blocks.size()) - record.firstBlock;
+
+    record.firstVreg = static_cast<uint32_t>(vregs.size());
+    addVregs(instructions, begin, end, record.firstInstr);
+    record.vregCount = static_cast<uint32_t>(vregs.size()) - record.firstVreg;
+    functions.push_back(record);
+}
+
+template <typename T>
+void appendSection(std::string& out, const std::vector<T>& records, uint64_t& offset) {
+    out.resize(align8(out.size()), '\0');
+    offset = out.size();
+    out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+}
+
+}  // namespace
+
+// ==================== 写出 ====================
+
+std::string IRBinaryWriter::serialize(const std::vector<std::shared_ptr<IRInstr>>& instructions) {
+    // 一个函数是到 function end 为止的一段指令；优化后块标签可能排在 function begin 之前
+    ModuleBuilder builder;
+    size_t begin = 0;
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        if (instructions[i]->opcode == OpCode::FUNCTION_END) {
+            builder.addFunction(instructions, begin, i + 1);
+            begin = i + 1;
+        }
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.stringCount = static_cast<uint32_t>(builder.strings.size());
+    header.functionCount = static_cast<uint32_t>(builder.functions.size());
+    header.instrCount = static_cast<uint32_t>(builder.instrs.size());
+    header.operandCount = static_cast<uint32_t>(builder.operands.size());
+    header.blockCount = static_cast<uint32_t>(builder.blocks.size());
+    header.edgeCount = static_cast<uint32_t>(builder.edges.size());
+    header.vregCount = static_cast<uint32_t>(builder.vregs.size());
+
+    std::string out(sizeof(FileHeader), '\0');
+    appendSection(out, builder.strings, header.stringIndexOffset);
+    out.resize(align8(out.size()), '\0');
+    header.stringDataOffset = out.size();
+    out += builder.stringData;
+    appendSection(out, builder.functions, header.functionOffset);
+    appendSection(out, builder.instrs, header.instrOffset);
+    appendSection(out, builder.operands, header.operandOffset);
+    appendSection(out, builder.blocks, header.blockOffset);
+    appendSection(out, builder.edges, header.edgeOffset);
+    appendSection(out, builder.vregs, header.vregOffset);
+    header.fileSize = out.size();
+    std::memcpy(out.data(), &header, sizeof(header));
+    return out;
+}
+
+// ==================== 加载 ====================
+
+std::unique_ptr<IRBinaryModule> IRBinaryModule::open(const std::string& path, std::ostream& diag) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        diag << "Error: Cannot open file " << path << std::endl;
+        return nullptr;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        diag << "Error: " << path << " is not a binary IR file" << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr<IRBinaryModule> module(new IRBinaryModule());
+    module->mappingSize = static_cast<size_t>(info.st_size);
+    module->mapping = ::mmap(nullptr, module->mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // 映射建立后不再需要描述符
+    if (module->mapping == MAP_FAILED) {
+        module->mapping = nullptr;
+        diag << "Error: Cannot map file " << path << std::endl;
+        return nullptr;
+    }
+    if (!module->validate(diag)) {
+        diag << "Error: " << path << " is not a valid binary IR file" << std::endl;
+        return nullptr;
+    }
+    return module;
+}
+
+IRBinaryModule::~IRBinaryModule() {
+    if (mapping) {
+        ::munmap(mapping, mappingSize);
+    }
+}
+
+// 文件可能来自别的编译器版本或已损坏：先查版本和各段边界，再逐条检查下标，
+// 之后的访问器和 materialize() 都不必再做越界检查
+bool IRBinaryModule::validate(std::ostream& diag) const {
+    const FileHeader& head = header();
+    if (std::memcmp(head.magic, kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    if (head.version != kVersion) {
+        diag << "Error: Binary IR version " << head.version << " is not supported (expected "
+             << kVersion << ")" << std::endl;
+        return false;
+    }
+    if (head.fileSize != mappingSize) {
+        return false;
+    }
+
+    auto fits = [&](uint64_t offset, uint64_t count, uint64_t size) {
+        return offset % 8 == 0 && offset >= sizeof(FileHeader) && offset <= mappingSize &&
+               count <= (mappingSize - offset) / size;
+    };
+    uint64_t stringDataSize = head.functionOffset >= head.stringDataOffset
+        ? head.functionOffset - head.stringDataOffset : 0;
+    if (!fits(head.stringIndexOffset, head.stringCount, sizeof(StringRecord)) ||
+        !fits(head.stringDataOffset, stringDataSize, 1) ||
+        !fits(head.functionOffset, head.functionCount, sizeof(FunctionRecord)) ||
+        !fits(head.instrOffset, head.instrCount, sizeof(InstrRecord)) ||
+        !fits(head.operandOffset, head.operandCount, sizeof(OperandRecord)) ||
+        !fits(head.blockOffset, head.blockCount, sizeof(BlockRecord)) ||
+        !fits(head.edgeOffset, head.edgeCount, sizeof(uint32_t)) ||
+        !fits(head.vregOffset, head.vregCount, sizeof(VregRecord))) {
+        return false;
+    }
+
+    auto inRange = [](uint64_t first, uint64_t count, uint64_t limit) {
+        return first <= limit && count <= limit - first;
+    };
+    auto validString = [&](uint32_t index, bool optional) {
+        return (optional && index == kNoString) || index < head.stringCount;
+    };
+
+    const StringRecord* strings = section<StringRecord>(head.stringIndexOffset);
+    for (uint32_t i = 0; i < head.stringCount; ++i) {
+        if (!inRange(strings[i].offset, strings[i].length, stringDataSize)) {
+            return false;
+        }
+    }
+    const OperandRecord* operands = section<OperandRecord>(head.operandOffset);
+    for (uint32_t i = 0; i < head.operandCount; ++i) {
+        const OperandRecord& op = operands[i];
+        if (op.type == kNullOperand || op.type == static_cast<uint8_t>(OperandType::CONSTANT)) {
+            continue;
+        }
+        if (op.type > static_cast<uint8_t>(OperandType::LABEL) || !validString(op.name, false)) {
+            return false;
+        }
+    }
+    const InstrRecord* instrs = section<InstrRecord>(head.instrOffset);
+    for (uint32_t i = 0; i < head.instrCount; ++i) {
+        const InstrRecord& record = instrs[i];
+        if (record.opcode > static_cast<uint8_t>(OpCode::FUNCTION_END) ||
+            !validString(record.symbol, true) ||
+            !inRange(record.firstOperand, record.operandCount, head.operandCount)) {
+            return false;
+        }
+        // 重建指令时按位置取操作数，数目必须与指令种类相符
+        OpCode op = static_cast<OpCode>(record.opcode);
+        uint32_t expected = isBinaryOp(op) ? 3 : isUnaryOp(op) ? 2 : 0;
+        switch (op) {
+            case OpCode::ASSIGN: case OpCode::IF_GOTO: expected = 2; break;
+            case OpCode::GOTO: case OpCode::RETURN: expected = 1; break;
+            case OpCode::CALL: expected = std::max<uint32_t>(record.operandCount, 1); break;
+            case OpCode::FUNCTION_BEGIN: expected = record.operandCount; break;
+            default: break;
+        }
+        if (record.operandCount != expected) {
+            return false;
+        }
+        // 只有调用结果和返回值可以为空；形参必须是变量名
+        for (uint32_t k = 0; k < record.operandCount; ++k) {
+            const OperandRecord& operand = operands[record.firstOperand + k];
+            bool nullable = (op == OpCode::CALL || op == OpCode::RETURN) && k == 0;
+            if (operand.type == kNullOperand && !nullable) {
+                return false;
+            }
+            if (op == OpCode::FUNCTION_BEGIN && operand.type != static_cast<uint8_t>(OperandType::VARIABLE)) {
+                return false;
+            }
+        }
+        bool needsSymbol = op == OpCode::CALL || op == OpCode::LABEL ||
+                           op == OpCode::FUNCTION_BEGIN || op == OpCode::FUNCTION_END;
+        if (needsSymbol && record.symbol == kNoString) {
+            return false;
+        }
+    }
+    const BlockRecord* blocks = section<BlockRecord>(head.blockOffset);
+    for (uint32_t i = 0; i < head.blockCount; ++i) {
+        if (!inRange(blocks[i].firstInstr, blocks[i].instrCount, head.instrCount) ||
+            !inRange(blocks[i].firstEdge, blocks[i].edgeCount, head.edgeCount)) {
+            return false;
+        }
+    }
+    const uint32_t* edges = section<uint32_t>(head.edgeOffset);
+    for (uint32_t i = 0; i < head.edgeCount; ++i) {
+        if (edges[i] >= head.blockCount) {
+            return false;
+        }
+    }
+    const VregRecord* vregs = section<VregRecord>(head.vregOffset);
+    for (uint32_t i = 0; i < head.vregCount; ++i) {
+        if (!validString(vregs[i].name, false)) {
+            return false;
+        }
+    }
+    const FunctionRecord* functions = section<FunctionRecord>(head.functionOffset);
+    for (uint32_t i = 0; i < head.functionCount; ++i) {
+        const FunctionRecord& func = functions[i];
+        if (!validString(func.name, false) || !validString(func.returnType, false) ||
+            !inRange(func.firstInstr, func.instrCount, head.instrCount) ||
+            !inRange(func.firstBlock, func.blockCount, head.blockCount) ||
+            !inRange(func.firstVreg, func.vregCount, head.vregCount)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const FunctionRecord& IRBinaryModule::function(size_t index) const {
+    return section<FunctionRecord>(header().functionOffset)[index];
+}
+
+const InstrRecord& IRBinaryModule::instr(uint32_t index) const {
+    return section<InstrRecord>(header().instrOffset)[index];
+}
+
+const OperandRecord& IRBinaryModule::operand(uint32_t index) const {
+    return section<OperandRecord>(header().operandOffset)[index];
+}
+
+const BlockRecord& IRBinaryModule::block(uint32_t index) const {
+    return section<BlockRecord>(header().blockOffset)[index];
+}
+
+uint32_t IRBinaryModule::edge(uint32_t index) const {
+    return section<uint32_t>(header().edgeOffset)[index];
+}
+
+const VregRecord& IRBinaryModule::vreg(uint32_t index) const {
+    return section<VregRecord>(header().vregOffset)[index];
+}
+
+std::string_view IRBinaryModule::string(uint32_t index) const {
+    const StringRecord& record = section<StringRecord>(header().stringIndexOffset)[index];
+    return std::string_view(section<char>(header().stringDataOffset) + record.offset, record.length);
+}
+
+// ==================== 重建指令 ====================
+
+std::shared_ptr<Operand> IRBinaryModule::makeOperand(uint32_t index) const {
+    const OperandRecord& record = operand(index);
+    if (record.type == kNullOperand) {
+        return nullptr;
+    }
+    auto type = static_cast<OperandType>(record.type);
+    if (type == OperandType::CONSTANT) {
+        return std::make_shared<Operand>(record.value);
+    }
+    auto op = std::make_shared<Operand>(type, std::string(string(record.name)));
+    op->value = record.value;
+    return op;
+}
+
+std::vector<std::shared_ptr<IRInstr>> IRBinaryModule::materialize(size_t functionIndex) const {
+    const FunctionRecord& func = function(functionIndex);
+    std::vector<std::shared_ptr<IRInstr>> instructions;
+    instructions.reserve(func.instrCount);
+
+    for (uint32_t i = func.firstInstr; i < func.firstInstr + func.instrCount; ++i) {
+        const InstrRecord& record = instr(i);
+        OpCode op = static_cast<OpCode>(record.opcode);
+        uint32_t first = record.firstOperand;
+        std::shared_ptr<IRInstr> result;
+
+        if (isBinaryOp(op)) {
+            result = std::make_shared<BinaryOpInstr>(op, makeOperand(first), makeOperand(first + 1),
+                                                     makeOperand(first + 2));
+        } else if (isUnaryOp(op)) {
+            result = std::make_shared<UnaryOpInstr>(op, makeOperand(first), makeOperand(first + 1));
+        } else {
+            switch (op) {
+                case OpCode::ASSIGN:
+                    result = std::make_shared<AssignInstr>(makeOperand(first), makeOperand(first + 1));
+                    break;
+                case OpCode::GOTO:
+                    result = std::make_shared<GotoInstr>(makeOperand(first));
+                    break;
+                case OpCode::IF_GOTO:
+                    result = std::make_shared<IfGotoInstr>(makeOperand(first), makeOperand(first + 1));
+                    break;
+                case OpCode::CALL: {
+                    auto call = std::make_shared<CallInstr>(makeOperand(first), std::string(string(record.symbol)),
+                                                            record.count);
+                    for (uint32_t k = 1; k < record.operandCount; ++k) {
+                        call->params.push_back(makeOperand(first + k));
+                    }
+                    result = call;
+                    break;
+                }
+                case OpCode::RETURN:
+                    result = std::make_shared<ReturnInstr>(makeOperand(first));
+                    break;
+                case OpCode::LABEL:
+                    result = std::make_shared<LabelInstr>(std::string(string(record.symbol)));
+                    break;
+                case OpCode::FUNCTION_BEGIN: {
+                    auto begin = std::make_shared<FunctionBeginInstr>(std::string(string(record.symbol)),
+                                                                      std::string(string(func.returnType)));
+                    for (uint32_t k = 0; k < record.operandCount; ++k) {
+                        begin->paramNames.emplace_back(string(operand(first + k).name));
+                    }
+                    result = begin;
+                    break;
+                }
+                case OpCode::FUNCTION_END:
+                    result = std::make_shared<FunctionEndInstr>(std::string(string(record.symbol)));
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (result) {
+            instructions.push_back(result);
+        }
+    }
+    return instructions;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include "ir.h"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ==================== 二进制 IR 格式 ====================
+
+/**
+ * IR 的二进制序列化格式，可以 mmap 后直接读取，不做任何解析。
+ *
+ * 文件由定长文件头和若干段组成，每段是定长记录的数组，按 8 字节对齐：
+ *   字符串表      所有名字（变量、临时变量、标签、函数名、类型）去重后存一份
+ *   函数表        每个函数的指令、基本块、虚拟寄存器在各段中的区间
+ *   指令 / 操作数  每条指令的操作码和操作数，操作数的名字是字符串表下标
+ *   基本块 / 边    控制流图：块内指令区间与后继块
+ *   虚拟寄存器     每个变量、临时变量的定义次数、使用次数和首末引用位置
+ *
+ * 所有下标都是整个文件内的绝对下标。文件头带魔数和版本号，格式一改版本号就加一，
+ * 旧文件加载时直接拒绝。按本机字节序写出，只在同一种机器之间使用。
+ */
+namespace irbin {
+
+constexpr uint32_t kVersion = 2;   // 2：去掉 param 指令，实参只存在 call 上
+constexpr uint32_t kNoString = 0xffffffffu;
+constexpr uint8_t kNullOperand = 0xff;   // 可空操作数（无返回值的调用、return）为空
+
+struct FileHeader {
+    char magic[4];   // "TCIR"
+    uint32_t version;
+    uint32_t stringCount, functionCount, instrCount, operandCount;
+    uint32_t blockCount, edgeCount, vregCount, reserved;
+    uint64_t stringIndexOffset, stringDataOffset, functionOffset, instrOffset;
+    uint64_t operandOffset, blockOffset, edgeOffset, vregOffset;
+    uint64_t fileSize;
+};
+
+struct StringRecord {
+    uint32_t offset;   // 相对字符串数据段
+    uint32_t length;
+};
+
+struct FunctionRecord {
+    uint32_t name, returnType;
+    uint32_t firstInstr, instrCount;
+    uint32_t firstBlock, blockCount;
+    uint32_t firstVreg, vregCount;
+};
+
+/**
+ * 操作数按指令种类依次存放：
+ *   二元 result,left,right；一元 result,operand；赋值 target,source；
+ *   goto target；if cond,target；return value；
+ *   call result,实参...（symbol 为函数名，count 为参数个数）；
+ *   label 无操作数（symbol 为标签名）；function begin 形参名（symbol 为函数名）
+ */
+struct InstrRecord {
+    uint8_t opcode;
+    uint8_t reserved[3];
+    uint32_t symbol;   // 标签名 / 函数名，没有时为 kNoString
+    int32_t count;     // call 的参数个数
+    uint32_t firstOperand;
+    uint32_t operandCount;
+};
+
+struct OperandRecord {
+    uint8_t type;   // OperandType，或 kNullOperand
+    uint8_t reserved[3];
+    uint32_t name;  // 字符串表下标，常量为 kNoString
+    int32_t value;
+};
+
+struct BlockRecord {
+    uint32_t firstInstr, instrCount;
+    uint32_t firstEdge, edgeCount;
+};
+
+enum class VregKind : uint32_t { VARIABLE, TEMP };
+
+struct VregRecord {
+    uint32_t name;
+    VregKind kind;
+    uint32_t defCount, useCount;
+    uint32_t firstRef, lastRef;   // 首次与最后一次被引用的指令下标
+};
+
+}  // namespace irbin
+
+class IRBinaryWriter {
+public:
+    // 序列化一组函数（以 function begin/end 分隔的指令序列）
+    static std::string serialize(const std::vector<std::shared_ptr<IRInstr>>& instructions);
+};
+
+/**
+ * 只读映射的二进制 IR 模块。
+ *
+ * 打开时只校验文件头与各段边界，记录访问器直接指向映射内存，
+ * 字符串以 string_view 返回，不复制。代码生成器目前以 IRInstr 对象为输入，
+ * 需要时用 materialize() 逐个函数重建指令。
+ */
+class IRBinaryModule {
+public:
+    // 失败时返回 nullptr 并写诊断
+    static std::unique_ptr<IRBinaryModule> open(const std::string& path, std::ostream& diag);
+    ~IRBinaryModule();
+
+    IRBinaryModule(const IRBinaryModule&) = delete;
+    IRBinaryModule& operator=(const IRBinaryModule&) = delete;
+
+    const irbin::FileHeader& header() const { return *static_cast<const irbin::FileHeader*>(mapping); }
+
+    size_t functionCount() const { return header().functionCount; }
+    const irbin::FunctionRecord& function(size_t index) const;
+    const irbin::InstrRecord& instr(uint32_t index) const;
+    const irbin::OperandRecord& operand(uint32_t index) const;
+    const irbin::BlockRecord& block(uint32_t index) const;
+    uint32_t edge(uint32_t index) const;
+    const irbin::VregRecord& vreg(uint32_t index) const;
+    std::string_view string(uint32_t index) const;
+
+    std::vector<std::shared_ptr<IRInstr>> materialize(size_t functionIndex) const;
+
+private:
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+
+    IRBinaryModule() = default;
+
+    template <typename T>
+    const T* section(uint64_t offset) const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(mapping) + offset);
+    }
+
+    bool validate(std::ostream& diag) const;
+    std::shared_ptr<Operand> makeOperand(uint32_t index) const;
+};
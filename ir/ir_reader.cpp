@@ -0,0 +1,342 @@
+#include "ir_reader.h"
+#include <charconv>
+#include <string>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\r')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// 按空格切分；IR 中的名字都不含空格
+std::vector<std::string_view> split(std::string_view text) {
+    std::vector<std::string_view> tokens;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(' ', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        if (end > pos) {
+            tokens.push_back(text.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    return tokens;
+}
+
+bool parseInt(std::string_view text, int& value) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+bool isConstant(std::string_view token) {
+    size_t digit = !token.empty() && token[0] == '-' ? 1 : 0;
+    return token.size() > digit && token[digit] >= '0' && token[digit] <= '9';
+}
+
+// 临时变量由生成器命名为 t0, t1, ...
+bool isTempName(std::string_view token) {
+    if (token.size() < 2 || token[0] != 't') {
+        return false;
+    }
+    for (size_t i = 1; i < token.size(); ++i) {
+        if (token[i] < '0' || token[i] > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<Operand> parseOperand(std::string_view token) {
+    if (token.empty()) {
+        return nullptr;
+    }
+    if (isConstant(token)) {
+        int value = 0;
+        if (!parseInt(token, value)) {
+            return nullptr;
+        }
+        return std::make_shared<Operand>(value);
+    }
+    OperandType type = isTempName(token) ? OperandType::TEMP : OperandType::VARIABLE;
+    return std::make_shared<Operand>(type, std::string(token));
+}
+
+std::shared_ptr<Operand> labelOperand(std::string_view token) {
+    return std::make_shared<Operand>(OperandType::LABEL, std::string(token));
+}
+
+bool binaryOpCode(std::string_view op, OpCode& opcode) {
+    static const std::pair<std::string_view, OpCode> table[] = {
+        {"+", OpCode::ADD}, {"-", OpCode::SUB}, {"*", OpCode::MUL}, {"/", OpCode::DIV},
+        {"%", OpCode::MOD}, {"<", OpCode::LT}, {">", OpCode::GT}, {"<=", OpCode::LE},
+        {">=", OpCode::GE}, {"==", OpCode::EQ}, {"!=", OpCode::NE}, {"&&", OpCode::AND},
+        {"||", OpCode::OR}, {"<<", OpCode::SHL}, {">>", OpCode::SHR},
+    };
+    for (const auto& [text, code] : table) {
+        if (text == op) {
+            opcode = code;
+            return true;
+        }
+    }
+    return false;
+}
+
+class LineParser {
+public:
+    explicit LineParser(std::vector<std::shared_ptr<IRInstr>>& instructions)
+        : instructions(instructions) {}
+
+    bool parse(std::string_view line);
+
+private:
+    std::vector<std::shared_ptr<IRInstr>>& instructions;
+    std::vector<std::shared_ptr<Operand>> paramQueue;   // 旧格式中尚未被 call 消费的 param
+
+    bool parseFunctionBegin(std::string_view rest);
+    bool parseCall(std::shared_ptr<Operand> result, std::string_view rest);
+    bool parseAssignment(const std::vector<std::string_view>& tokens);
+
+    void add(std::shared_ptr<IRInstr> instr) {
+        instructions.push_back(std::move(instr));
+    }
+};
+
+bool LineParser::parse(std::string_view line) {
+    if (line.back() == ':' && line.find(' ') == std::string_view::npos) {
+        add(std::make_shared<LabelInstr>(std::string(line.substr(0, line.size() - 1))));
+        return true;
+    }
+
+    std::vector<std::string_view> tokens = split(line);
+    std::string_view head = tokens[0];
+
+    if (head == "function") {
+        if (tokens.size() == 3 && tokens[2] == "end") {
+            add(std::make_shared<FunctionEndInstr>(std::string(tokens[1])));
+            return true;
+        }
+        paramQueue.clear();
+        return tokens.back() == "begin" && parseFunctionBegin(line.substr(head.size()));
+    }
+    if (head == "goto" && tokens.size() == 2) {
+        add(std::make_shared<GotoInstr>(labelOperand(tokens[1])));
+        return true;
+    }
+    if (head == "if" && tokens.size() == 4 && tokens[2] == "goto") {
+        auto condition = parseOperand(tokens[1]);
+        if (!condition) {
+            return false;
+        }
+        add(std::make_shared<IfGotoInstr>(condition, labelOperand(tokens[3])));
+        return true;
+    }
+    if (head == "param" && tokens.size() == 2) {
+        // 旧格式：实参逐条写在 call 之前，收进紧随其后的 call
+        auto param = parseOperand(tokens[1]);
+        if (!param) {
+            return false;
+        }
+        paramQueue.push_back(param);
+        return true;
+    }
+    if (head == "return" && tokens.size() <= 2) {
+        std::shared_ptr<Operand> value;
+        if (tokens.size() == 2 && !(value = parseOperand(tokens[1]))) {
+            return false;
+        }
+        add(std::make_shared<ReturnInstr>(value));
+        return true;
+    }
+    if (head == "call") {
+        return parseCall(nullptr, line.substr(head.size()));
+    }
+    if (tokens.size() >= 3 && tokens[1] == "=") {
+        if (tokens[2] == "call") {
+            auto result = parseOperand(tokens[0]);
+            size_t callPos = line.find(" call");
+            return result && parseCall(result, line.substr(callPos + 5));
+        }
+        return parseAssignment(tokens);
+    }
+    return false;
+}
+
+// function 返回类型 函数名(形参, ...) begin；也接受旧格式 function 函数名 begin
+bool LineParser::parseFunctionBegin(std::string_view rest) {
+    rest = trim(rest);
+    rest = trim(rest.substr(0, rest.size() - std::string_view("begin").size()));
+
+    size_t open = rest.find('(');
+    if (open == std::string_view::npos) {
+        if (rest.empty() || rest.find(' ') != std::string_view::npos) {
+            return false;
+        }
+        add(std::make_shared<FunctionBeginInstr>(std::string(rest)));
+        return true;
+    }
+    if (rest.back() != ')') {
+        return false;
+    }
+
+    std::vector<std::string_view> signature = split(rest.substr(0, open));
+    if (signature.size() != 2) {
+        return false;
+    }
+    auto begin = std::make_shared<FunctionBeginInstr>(std::string(signature[1]), std::string(signature[0]));
+
+    std::string_view params = trim(rest.substr(open + 1, rest.size() - open - 2));
+    while (!params.empty()) {
+        size_t comma = params.find(',');
+        std::string_view param = trim(params.substr(0, comma));
+        if (param.empty()) {
+            return false;
+        }
+        begin->paramNames.emplace_back(param);
+        params = comma == std::string_view::npos ? std::string_view() : params.substr(comma + 1);
+    }
+    add(begin);
+    return true;
+}
+
+// call 函数名(实参, ...)；也接受旧格式 call 函数名, 参数个数
+bool LineParser::parseCall(std::shared_ptr<Operand> result, std::string_view rest) {
+    rest = trim(rest);
+    size_t open = rest.find('(');
+    if (open != std::string_view::npos) {
+        std::string_view funcName = trim(rest.substr(0, open));
+        if (funcName.empty() || rest.back() != ')') {
+            return false;
+        }
+        auto call = std::make_shared<CallInstr>(result, std::string(funcName), 0);
+        std::string_view args = trim(rest.substr(open + 1, rest.size() - open - 2));
+        while (!args.empty()) {
+            size_t comma = args.find(',');
+            auto arg = parseOperand(trim(args.substr(0, comma)));
+            if (!arg) {
+                return false;
+            }
+            call->params.push_back(arg);
+            args = comma == std::string_view::npos ? std::string_view() : args.substr(comma + 1);
+        }
+        call->paramCount = static_cast<int>(call->params.size());
+        add(call);
+        return true;
+    }
+
+    size_t comma = rest.find(',');
+    if (comma == std::string_view::npos) {
+        return false;
+    }
+    std::string_view funcName = trim(rest.substr(0, comma));
+    int paramCount = 0;
+    if (funcName.empty() || !parseInt(trim(rest.substr(comma + 1)), paramCount) || paramCount < 0) {
+        return false;
+    }
+
+    size_t count = static_cast<size_t>(paramCount);
+    if (paramQueue.size() < count) {
+        return false;
+    }
+    auto call = std::make_shared<CallInstr>(result, std::string(funcName), paramCount);
+    call->params.assign(paramQueue.end() - count, paramQueue.end());
+    paramQueue.erase(paramQueue.end() - count, paramQueue.end());
+    add(call);
+    return true;
+}
+
+// r = a op b / r = -x / r = - 5 / r = !x / r = x
+bool LineParser::parseAssignment(const std::vector<std::string_view>& tokens) {
+    auto result = parseOperand(tokens[0]);
+    if (!result) {
+        return false;
+    }
+
+    if (tokens.size() == 5) {
+        OpCode opcode;
+        auto left = parseOperand(tokens[2]);
+        auto right = parseOperand(tokens[4]);
+        if (!binaryOpCode(tokens[3], opcode) || !left || !right) {
+            return false;
+        }
+        add(std::make_shared<BinaryOpInstr>(opcode, result, left, right));
+        return true;
+    }
+
+    std::string_view opText;
+    std::string_view operandText;
+    if (tokens.size() == 4) {
+        // 常量操作数与运算符之间有空格
+        opText = tokens[2];
+        operandText = tokens[3];
+    } else if (tokens.size() == 3 && !isConstant(tokens[2]) &&
+               (tokens[2][0] == '-' || tokens[2][0] == '!')) {
+        opText = tokens[2].substr(0, 1);
+        operandText = tokens[2].substr(1);
+    } else if (tokens.size() == 3) {
+        auto source = parseOperand(tokens[2]);
+        if (!source) {
+            return false;
+        }
+        add(std::make_shared<AssignInstr>(result, source));
+        return true;
+    } else {
+        return false;
+    }
+
+    auto operand = parseOperand(operandText);
+    if (!operand || (opText != "-" && opText != "!")) {
+        return false;
+    }
+    add(std::make_shared<UnaryOpInstr>(opText == "-" ? OpCode::NEG : OpCode::NOT, result, operand));
+    return true;
+}
+
+}  // namespace
+
+bool IRReader::parse(std::string_view text, std::vector<std::shared_ptr<IRInstr>>& instructions,
+                     std::ostream& diag) {
+    LineParser parser(instructions);
+    size_t lineNumber = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view line = trim(text.substr(pos, end - pos));
+        pos = end + 1;
+        ++lineNumber;
+
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        if (!parser.parse(line)) {
+            diag << "Error: IR line " << lineNumber << ": cannot parse '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<std::shared_ptr<IRInstr>>> IRReader::splitFunctions(
+    const std::vector<std::shared_ptr<IRInstr>>& instructions) {
+    std::vector<std::vector<std::shared_ptr<IRInstr>>> functions(1);
+    for (const auto& instr : instructions) {
+        functions.back().push_back(instr);
+        if (instr->opcode == OpCode::FUNCTION_END) {
+            functions.emplace_back();
+        }
+    }
+    if (functions.back().empty()) {
+        functions.pop_back();
+    }
+    return functions;
+}
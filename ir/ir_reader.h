@@ -0,0 +1,27 @@
+#pragma once
+#include "ir.h"
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// ==================== 文本 IR 读取 ====================
+
+/**
+ * 把 IRPrinter::print / IRInstr::toString() 的输出还原成指令序列。
+ *
+ * 逐行手写解析，不用正则；空行和以 # 开头的注释行跳过。
+ * 文本本身不区分临时变量和命名变量，按生成器的命名规则还原：
+ * 形如 t<数字> 的名字是临时变量，其余是变量；跳转目标是标签。
+ * call 的实参写在括号里；旧格式的 call 函数名, 个数 取紧挨着它的那几条 param 作实参。
+ */
+class IRReader {
+public:
+    // 解析失败时写出行号和原因，返回 false
+    static bool parse(std::string_view text, std::vector<std::shared_ptr<IRInstr>>& instructions,
+                      std::ostream& diag);
+
+    // 按 function end 切分成函数；优化遍和代码生成都以单个函数为单位
+    static std::vector<std::vector<std::shared_ptr<IRInstr>>> splitFunctions(
+        const std::vector<std::shared_ptr<IRInstr>>& instructions);
+};
@@ -101,6 +101,8 @@ std::string BinaryOpInstr::toString() const {
         case OpCode::NE: opStr = "!="; break;
         case OpCode::AND: opStr = "&&"; break;
         case OpCode::OR: opStr = "||"; break;
+        case OpCode::SHL: opStr = "<<"; break;
+        case OpCode::SHR: opStr = ">>"; break;
         default: opStr = "unknown"; break;
     }
     // 格式: result = left op right
@@ -117,8 +119,9 @@ std::string UnaryOpInstr::toString() const {
         default: opStr = "unknown"; break;
     }
     
-    // 格式: result = op operand
-    return result->toString() + " = " + opStr + operand->toString();
+    // 格式: result = op operand；对常量取负写作 "- 5"，与赋值负常量 "= -5" 区分开
+    std::string separator = operand->type == OperandType::CONSTANT ? " " : "";
+    return result->toString() + " = " + opStr + separator + operand->toString();
 }
 
 // AssignInstr toString方法 - 表示赋值，如a = b
@@ -136,20 +139,14 @@ std::string IfGotoInstr::toString() const {
     return "if " + condition->toString() + " goto " + target->toString();
 }
 
-// ParamInstr toString方法 - 表示函数参数
-std::string ParamInstr::toString() const {
-    return "param " + param->toString();
-}
-
-// CallInstr toString方法 - 表示函数调用
+// CallInstr toString方法 - 表示函数调用: [result = ]call func(arg, ...)
 std::string CallInstr::toString() const {
-    if (result) {
-        // 有返回值的函数调用: result = call func, paramCount
-        return result->toString() + " = call " + funcName + ", " + std::to_string(paramCount);
-    } else {
-        // 无返回值的函数调用: call func, paramCount
-        return "call " + funcName + ", " + std::to_string(paramCount);
+    std::string text = result ? result->toString() + " = call " : "call ";
+    text += funcName + "(";
+    for (size_t i = 0; i < params.size(); ++i) {
+        text += (i ? ", " : "") + params[i]->toString();
     }
+    return text + ")";
 }
 
 // ReturnInstr toString方法 - 表示返回语句
@@ -170,7 +167,12 @@ std::string LabelInstr::toString() const {
 
 // FunctionBeginInstr toString方法 - 表示函数定义开始
 std::string FunctionBeginInstr::toString() const {
-    return "function " + funcName + " begin";
+    // 格式: function 返回类型 函数名(形参, ...) begin
+    std::string text = "function " + returnType + " " + funcName + "(";
+    for (size_t i = 0; i < paramNames.size(); ++i) {
+        text += (i ? ", " : "") + paramNames[i];
+    }
+    return text + ") begin";
 }
 
 // FunctionEndInstr toString方法 - 表示函数定义结束
@@ -192,20 +194,176 @@ std::string FunctionEndInstr::toString() const {
  */
 void IRGenerator::generate(std::shared_ptr<CompUnit> ast) {
     if (ast) {
-        // 遍历AST生成IR
-        ast->accept(*this);
+        // 逐个函数生成并优化IR，函数之间互不影响
+        for (const auto& func : ast->functions) {
+            auto funcInstrs = generateFunction(*func);
+            instructions.insert(instructions.end(), funcInstrs.begin(), funcInstrs.end());
+        }
+    }
+}
+
+/**
+ * 为单个函数生成IR。
+ * 
+ * 先把函数翻译成IR，如果启用了优化则只优化该函数的指令。
+ * 
+ * @param funcDef 函数定义
+ * @return 该函数的IR指令
+ */
+std::vector<std::shared_ptr<IRInstr>> IRGenerator::generateFunction(FunctionDef& funcDef) {
+    std::vector<std::shared_ptr<IRInstr>> funcInstrs = lowerFunction(funcDef);
+
+    // 如果启用了优化，则优化IR
+    if (config.enableOptimizations) {
+        optimizeFunction(funcInstrs);
+    }
+    return funcInstrs;
+}
+
+/**
+ * 把单个函数翻译成未优化的IR。
+ * 
+ * 在空的指令列表上遍历函数，然后恢复之前已生成的指令。
+ * 
+ * @param funcDef 函数定义
+ * @return 该函数的IR指令
+ */
+std::vector<std::shared_ptr<IRInstr>> IRGenerator::lowerFunction(FunctionDef& funcDef) {
+    std::vector<std::shared_ptr<IRInstr>> saved;
+    saved.swap(instructions);
+
+    funcDef.accept(*this);
+
+    std::vector<std::shared_ptr<IRInstr>> funcInstrs;
+    funcInstrs.swap(instructions);
+    instructions.swap(saved);
+    return funcInstrs;
+}
 
-        // 如果启用了优化，则优化IR
-        if (config.enableOptimizations) {
-            // Debug IR printing (commented out)
-            // std::cerr << "=== IR Before Optimization ===" << std::endl;
-            // for (auto& instr : instructions) {
-            //     std::cerr << instr->toString() << std::endl;
-            // }
-            // std::cerr << "============================" << std::endl;
-            optimize();
+/**
+ * 优化单个函数的IR。
+ * 
+ * 优化遍直接作用于成员指令列表，这里把函数的指令换入、优化后再换出。
+ * 基本块标签要用到函数名，从 FUNCTION_BEGIN 指令中取得。
+ * 
+ * @param funcInstrs 该函数的IR指令，原地优化
+ */
+void IRGenerator::optimizeFunction(std::vector<std::shared_ptr<IRInstr>>& funcInstrs) {
+    if (!config.passes.empty() && runPasses(funcInstrs, config.passes)) {
+        return;
+    }
+    runOnFunction(funcInstrs, [this] { optimize(); });
+}
+
+/**
+ * 在单个函数上依次运行指定的优化遍。
+ *
+ * 名字见 passNames()，按给出的顺序执行，可以重复；
+ * 有未知名字时一个遍也不运行并返回 false。
+ */
+bool IRGenerator::runPasses(std::vector<std::shared_ptr<IRInstr>>& funcInstrs,
+                            const std::vector<std::string>& passes) {
+    std::vector<const PassInfo*> sequence;
+    for (const auto& name : passes) {
+        const PassInfo* info = findPass(name);
+        if (!info) {
+            return false;
         }
+        sequence.push_back(info);
     }
+
+    runOnFunction(funcInstrs, [&] { runPassSequence(sequence); });
+    return true;
+}
+
+/**
+ * 在当前函数上按顺序运行优化遍，全局遍受编译预算约束。
+ *
+ * 每个全局遍运行前重新估算工作量（前面的遍可能已经改变了函数规模），
+ * 超出单遍预算，或与已运行的全局遍累计超出函数预算时，改用它的块内版本或跳过，
+ * 并记一条降级记录。
+ */
+void IRGenerator::runPassSequence(const std::vector<const PassInfo*>& sequence) {
+    uint64_t spent = 0;
+    for (const PassInfo* info : sequence) {
+        if (info->global && (config.passBudget || config.functionBudget)) {
+            uint64_t cost = FunctionSize::measure(instructions).dataflowCost();
+            uint64_t budget = 0;
+            if (config.passBudget && cost > config.passBudget) {
+                budget = config.passBudget;
+            } else if (config.functionBudget && spent + cost > config.functionBudget) {
+                budget = config.functionBudget;
+                cost += spent;
+            }
+            if (budget) {
+                budgetEvents.push_back({currentFunction, info->name, info->fallback, cost, budget});
+                if (const PassInfo* fallback = findPass(info->fallback)) {
+                    (this->*fallback->run)();
+                }
+                continue;
+            }
+            spent += cost;
+        }
+        (this->*info->run)();
+    }
+}
+
+std::vector<std::string> IRGenerator::passNames() {
+    std::vector<std::string> names;
+    for (const auto& entry : passTable()) {
+        names.push_back(entry.name);
+    }
+    return names;
+}
+
+const std::vector<IRGenerator::PassInfo>& IRGenerator::passTable() {
+    static const std::vector<PassInfo> table = {
+        {"constfold", &IRGenerator::constantFolding, false, ""},
+        {"algebraic", &IRGenerator::algebraicSimplification, false, ""},
+        {"constprop", &IRGenerator::constantPropagationCFG, true, "lvn"},
+        {"copyprop", &IRGenerator::copyPropagationCFG, false, ""},
+        {"strength", &IRGenerator::strengthReduction, false, ""},
+        {"cse", &IRGenerator::commonSubexpressionElimination, true, "lvn"},
+        // 按值编号消除冗余，同 cse
+        {"gvn", &IRGenerator::commonSubexpressionElimination, true, "lvn"},
+        // 基于 CFG 的常量传播，同 constprop
+        {"sccp", &IRGenerator::constantPropagationCFG, true, "lvn"},
+        {"lvn", &IRGenerator::localValueNumbering, false, ""},
+        {"licm", &IRGenerator::loopInvariantCodeMotion, true, ""},
+        {"simplifycfg", &IRGenerator::controlFlowOptimization, true, ""},
+        {"dce", &IRGenerator::deadCodeElimination, false, ""},
+    };
+    return table;
+}
+
+const IRGenerator::PassInfo* IRGenerator::findPass(const std::string& name) {
+    for (const auto& entry : passTable()) {
+        if (entry.name == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+// 把函数的指令换入 instructions 后执行 body，再换回；标签前缀取自 function begin
+void IRGenerator::runOnFunction(std::vector<std::shared_ptr<IRInstr>>& funcInstrs,
+                                const std::function<void()>& body) {
+    // 优化过的 IR 里 function begin 之前可能已有块标签
+    for (const auto& instr : funcInstrs) {
+        if (auto begin = std::dynamic_pointer_cast<FunctionBeginInstr>(instr)) {
+            currentFunction = begin->funcName;
+            break;
+        }
+    }
+
+    std::vector<std::shared_ptr<IRInstr>> saved;
+    saved.swap(instructions);
+    instructions.swap(funcInstrs);
+
+    body();
+
+    instructions.swap(funcInstrs);
+    instructions.swap(saved);
 }
 
 /**
@@ -228,7 +386,9 @@ std::shared_ptr<Operand> IRGenerator::createTemp() {
  * @return 新标签操作数的共享指针
  */
 std::shared_ptr<Operand> IRGenerator::createLabel() {
-    std::string name = "L" + std::to_string(labelCount++);
+    // 标签编号在函数内从零开始；.L 前缀是汇编器的局部标签，
+    // 标识符里不会出现 '.'，所以 .L<函数名>.<n> 在整个文件内唯一
+    std::string name = ".L" + currentFunction + "." + std::to_string(labelCount++);
     return std::make_shared<Operand>(OperandType::LABEL, name);
 }
 
@@ -260,6 +420,31 @@ std::shared_ptr<Operand> IRGenerator::getTopOperand() {
     return result;
 }
 
+/**
+ * 按目标求值表达式。
+ *
+ * 赋值和带初始化的声明把变量作为目标传进来，表达式的最后一条指令（运算、调用、短路的两路赋值）
+ * 直接写进变量，不再先写临时变量再复制一次。目标只在所有操作数读完之后写入，
+ * 所以 x = x + 1 这类右侧读到目标的表达式也不受影响。
+ * 常量和变量表达式没有指令可写，照旧返回它们自己，由调用方补一条赋值。
+ *
+ * @param expr 要求值的表达式
+ * @param target 结果要写进的变量
+ * @return 持有结果的操作数
+ */
+std::shared_ptr<Operand> IRGenerator::lowerInto(Expr& expr, const std::shared_ptr<Operand>& target) {
+    destination = target;
+    expr.accept(*this);
+    destination.reset();
+    return getTopOperand();
+}
+
+std::shared_ptr<Operand> IRGenerator::takeDestination() {
+    std::shared_ptr<Operand> target = std::move(destination);
+    destination.reset();
+    return target;
+}
+
 //------------------------------------------------------------------------------
 // 作用域管理方法
 //------------------------------------------------------------------------------
@@ -413,31 +598,25 @@ void IRGenerator::dumpIR(const std::string& filename) const {
  * 对IR指令应用各种优化技术。
  */
 void IRGenerator::optimize() {
-    // 按顺序应用每种优化技术
-    
-    // 第一轮：基础优化
-    constantFolding();            // 在编译时评估常量表达式
-    algebraicSimplification();    // 应用代数恒等式简化
-    
-    // 第二轮：常量和复制传播
-    constantPropagationCFG();     // 在代码中传播常量值
-    copyPropagationCFG();         // 复制传播优化
-    constantFolding();            // 再次常量折叠
-    algebraicSimplification();    // 再次代数简化
-    
-    // 第三轮：强度削减
-    strengthReduction();          // 强度削减（乘法转移位等）
-    
-    // 第四轮：清理优化
-    constantPropagationCFG();     // 再次常量传播
-    constantFolding();            // 再次常量折叠
-    algebraicSimplification();    // 再次代数简化
-    strengthReduction();          // 再次强度削减
-    
-    // 最后：删除死代码
-    // commonSubexpressionElimination();  // 公共子表达式消除
-    deadCodeElimination();        // 删除无效果的代码
-    //controlFlowOptimization(); // 优化控制流（跳转、分支等）
+    // 按顺序应用每种优化技术；commonSubexpressionElimination 与 controlFlowOptimization 不在默认序列中
+    static const std::vector<std::string> pipeline = {
+        // 第一轮：基础优化（常量折叠、代数恒等式简化）
+        "constfold", "algebraic",
+        // 第二轮：常量和复制传播，再次折叠与简化
+        "constprop", "copyprop", "constfold", "algebraic",
+        // 第三轮：强度削减（乘法转移位等）
+        "strength",
+        // 第四轮：清理优化
+        "constprop", "constfold", "algebraic", "strength",
+        // 最后：删除死代码
+        "dce",
+    };
+
+    std::vector<const PassInfo*> sequence;
+    for (const auto& name : pipeline) {
+        sequence.push_back(findPass(name));
+    }
+    runPassSequence(sequence);
 }
 
 /**
@@ -927,6 +1106,11 @@ std::shared_ptr<Operand> IRGenerator::makeConstantOperand(int v, std::string nam
     return op;
 }
 
+// 基本块标签按函数命名，逐函数优化时不同函数的块标签不会重名
+std::string IRGenerator::blockLabel(int id) const {
+    return ".L" + currentFunction + ".b" + std::to_string(id);
+}
+
 // ---------- 构建基本块 ----------
 std::vector<std::shared_ptr<IRGenerator::BasicBlock>> IRGenerator::buildBasicBlocks() {
     std::vector<std::shared_ptr<BasicBlock>> blocks;    // 存储生成的基本块
@@ -1074,7 +1258,7 @@ std::vector<std::shared_ptr<IRGenerator::BasicBlock>> IRGenerator::buildBasicBlo
         // === 修改点3：新标签使用 makeUniqueLabel 确保全局唯一 ===
         if (block->instructions.empty() || 
             !std::dynamic_pointer_cast<LabelInstr>(block->instructions.front())) {
-            std::string newLabel = makeUniqueLabel("__block" + std::to_string(block->id));
+            std::string newLabel = makeUniqueLabel(blockLabel(block->id));
             auto lblInstr = std::make_shared<LabelInstr>(newLabel);
             block->instructions.insert(block->instructions.begin(), lblInstr);
             block->label = newLabel;
@@ -1089,6 +1273,27 @@ std::vector<std::shared_ptr<IRGenerator::BasicBlock>> IRGenerator::buildBasicBlo
     return blocks;
 }
 
+// ---------- CFG 边的释放 ----------
+// successors / predecessors 互相持有 shared_ptr，带循环的 CFG 会形成引用环。
+// 每个构建了 CFG 的优化在返回时拆掉所有边，基本块才能随局部变量一起释放；
+// 中途从 blocks 里删掉的块也在快照里，一样会被拆开。
+namespace {
+class CFGEdgeRelease {
+public:
+    explicit CFGEdgeRelease(const std::vector<std::shared_ptr<IRGenerator::BasicBlock>>& blocks)
+        : blocks(blocks) {}
+    ~CFGEdgeRelease() {
+        for (auto& b : blocks) {
+            b->successors.clear();
+            b->predecessors.clear();
+        }
+    }
+
+private:
+    std::vector<std::shared_ptr<IRGenerator::BasicBlock>> blocks;
+};
+}  // namespace
+
 // ---------- 构建 CFG（连接基本块） ----------
 void IRGenerator::buildCFG(std::vector<std::shared_ptr<BasicBlock>>& blocks) {
     if (blocks.empty()) return;
@@ -1301,7 +1506,7 @@ void applyTransferToEnv(ConstMap& env, const std::shared_ptr<IRInstr>& instr) {
     } 
     // 其他指令
     else {
-        // GotoInstr / IfGotoInstr / ParamInstr / ReturnInstr / LabelInstr / FunctionBeginInstr / FunctionEndInstr
+        // GotoInstr / IfGotoInstr / ReturnInstr / LabelInstr / FunctionBeginInstr / FunctionEndInstr
         // 不会产生新的定义，因此 env 保持不变
     }
 }
@@ -1312,6 +1517,7 @@ void IRGenerator::constantPropagationCFG() {
     // 1. 构建 basic blocks 与 CFG
     auto blocks = buildBasicBlocks();
     buildCFG(blocks);
+    CFGEdgeRelease releaseEdges(blocks);
 
     int n = (int)blocks.size();
     if (n == 0) return;
@@ -1488,15 +1694,6 @@ void IRGenerator::constantPropagationCFG() {
                     }
                 }
             } 
-            // 处理参数传递指令
-            else if (auto paramInstr = std::dynamic_pointer_cast<ParamInstr>(instr)) {
-                if (paramInstr->param->type == OperandType::VARIABLE || paramInstr->param->type == OperandType::TEMP) {
-                    auto it = env.find(paramInstr->param->name);
-                    if (it != env.end() && it->second.kind == LatticeKind::Constant) {
-                        paramInstr->param = makeConstantOperand(it->second.constantValue, paramInstr->param->name);
-                    }
-                }
-            } 
             // 处理函数调用指令
             else if (auto callInstr = std::dynamic_pointer_cast<CallInstr>(instr)) {
                 for (auto& arg : callInstr->params) {
@@ -1548,6 +1745,7 @@ void IRGenerator::deadCodeElimination() {
     // ========== Step 0: 构建CFG ==========
     auto basicBlocks = buildBasicBlocks();
     buildCFG(basicBlocks);
+    CFGEdgeRelease releaseEdges(basicBlocks);
 
     // ========== Step 1: 收集use/def集合 ==========
     std::unordered_map<std::shared_ptr<BasicBlock>, std::unordered_set<std::string>> use, def;
@@ -1781,8 +1979,7 @@ bool IRGenerator::isSideEffectInstr(const std::shared_ptr<IRInstr>& instr) {
         std::dynamic_pointer_cast<IfGotoInstr>(instr) != nullptr ||             // 条件跳转
         std::dynamic_pointer_cast<LabelInstr>(instr) != nullptr ||              // 标签
         std::dynamic_pointer_cast<FunctionBeginInstr>(instr) != nullptr ||      // 函数开始
-        std::dynamic_pointer_cast<FunctionEndInstr>(instr) != nullptr ||        // 函数结束
-        std::dynamic_pointer_cast<ParamInstr>(instr) != nullptr;                // 参数传递
+        std::dynamic_pointer_cast<FunctionEndInstr>(instr) != nullptr;          // 函数结束
 }
 
 // 复制传播优化实现
@@ -1960,14 +2157,7 @@ void IRAnalyzer::replaceUsedVariable(std::shared_ptr<IRInstr>& instr,
             unaryOp->operand = newOp;
         }
     }
-    // 4. 参数传递指令
-    else if (auto paramInstr = std::dynamic_pointer_cast<ParamInstr>(instr)) {
-        if ((paramInstr->param->type == OperandType::VARIABLE || paramInstr->param->type == OperandType::TEMP) &&
-        paramInstr->param->name == oldVar) {
-            paramInstr->param = newOp;
-        }
-    }
-    // 5. 函数调用指令
+    // 4. 函数调用指令
     else if (auto callInstr = std::dynamic_pointer_cast<CallInstr>(instr)) {
         for (auto& arg : callInstr->params) {
             if ((arg->type == OperandType::VARIABLE || arg->type == OperandType::TEMP) &&
@@ -1976,14 +2166,14 @@ void IRAnalyzer::replaceUsedVariable(std::shared_ptr<IRInstr>& instr,
             }
         }
     }
-    // 6. 条件跳转指令
+    // 5. 条件跳转指令
     else if (auto ifg = std::dynamic_pointer_cast<IfGotoInstr>(instr)) {
         if ((ifg->condition->type == OperandType::VARIABLE || ifg->condition->type == OperandType::TEMP) &&
         ifg->condition->name == oldVar) {
             ifg->condition = newOp;
         }
     }
-    // 7. 返回指令
+    // 6. 返回指令
     else if (auto retInstr = std::dynamic_pointer_cast<ReturnInstr>(instr)) {
         if (retInstr->value && (retInstr->value->type == OperandType::VARIABLE || retInstr->value->type == OperandType::TEMP) &&
         retInstr->value->name == oldVar) {
@@ -1992,6 +2182,48 @@ void IRAnalyzer::replaceUsedVariable(std::shared_ptr<IRInstr>& instr,
     }
 }
 
+std::shared_ptr<IRInstr> IRAnalyzer::rewriteOperands(const std::shared_ptr<IRInstr>& instr,
+                                                     const OperandRenamer& rename) {
+    auto use = [&](const std::shared_ptr<Operand>& op) {
+        bool named = op && (op->type == OperandType::VARIABLE || op->type == OperandType::TEMP);
+        return named ? rename(op, false) : op;
+    };
+    auto def = [&](const std::shared_ptr<Operand>& op) {
+        bool named = op && (op->type == OperandType::VARIABLE || op->type == OperandType::TEMP);
+        return named ? rename(op, true) : op;
+    };
+
+    if (auto bin = std::dynamic_pointer_cast<BinaryOpInstr>(instr)) {
+        auto left = use(bin->left);
+        auto right = use(bin->right);
+        return std::make_shared<BinaryOpInstr>(bin->opcode, def(bin->result), left, right);
+    }
+    if (auto unary = std::dynamic_pointer_cast<UnaryOpInstr>(instr)) {
+        auto operand = use(unary->operand);
+        return std::make_shared<UnaryOpInstr>(unary->opcode, def(unary->result), operand);
+    }
+    if (auto assign = std::dynamic_pointer_cast<AssignInstr>(instr)) {
+        auto source = use(assign->source);
+        return std::make_shared<AssignInstr>(def(assign->target), source);
+    }
+    if (auto ifGoto = std::dynamic_pointer_cast<IfGotoInstr>(instr)) {
+        return std::make_shared<IfGotoInstr>(use(ifGoto->condition), ifGoto->target);
+    }
+    if (auto call = std::dynamic_pointer_cast<CallInstr>(instr)) {
+        std::vector<std::shared_ptr<Operand>> params;
+        for (const auto& param : call->params) {
+            params.push_back(use(param));
+        }
+        auto result = std::make_shared<CallInstr>(def(call->result), call->funcName, call->paramCount);
+        result->params = std::move(params);
+        return result;
+    }
+    if (auto ret = std::dynamic_pointer_cast<ReturnInstr>(instr)) {
+        return std::make_shared<ReturnInstr>(use(ret->value));
+    }
+    return instr;
+}
+
 // ---------- 构建基本块（仅用标签划分） ----------
 std::vector<std::shared_ptr<IRGenerator::BasicBlock>> IRGenerator::buildBasicBlocksByLabel() {
     std::vector<std::shared_ptr<BasicBlock>> blocks;    // 存储生成的基本块
@@ -2028,7 +2260,7 @@ std::vector<std::shared_ptr<IRGenerator::BasicBlock>> IRGenerator::buildBasicBlo
             block->label = lbl->label;
         } else {
             // 如果第一条不是标签，生成新标签并插入
-            std::string newLabel = "__block" + std::to_string(block->id);
+            std::string newLabel = blockLabel(block->id);
             auto lblInstr = std::make_shared<LabelInstr>(newLabel);
             block->instructions.insert(block->instructions.begin(), lblInstr);
             block->label = newLabel;
@@ -2054,6 +2286,7 @@ void IRGenerator::copyPropagationCFG() {
     //auto blocks = buildBasicBlocksByLabel();
     auto blocks = buildBasicBlocks();
     buildCFG(blocks);
+    CFGEdgeRelease releaseEdges(blocks);
 
     int n = (int)blocks.size();
     if (n == 0) return;
@@ -2161,6 +2394,7 @@ void IRGenerator::commonSubexpressionElimination() {
     // ====== Step 0: 构建基本块和控制流图 ======
     auto blocks = buildBasicBlocks();
     buildCFG(blocks);
+    CFGEdgeRelease releaseEdges(blocks);
 
     // 全局变量名到 Operand 指针的映射（替换时用，但需要配合版本号校验）
     std::unordered_map<std::string, std::shared_ptr<Operand>> varToOperand;
@@ -2179,7 +2413,7 @@ void IRGenerator::commonSubexpressionElimination() {
         for (auto& instr : blk->instructions) {
             if (auto binOp = std::dynamic_pointer_cast<BinaryOpInstr>(instr)) {
                 if (!isSideEffectInstr(instr)) {
-                    auto [lhs, rhs] = norm(binOp->opcode, binOp->left->name, binOp->right->name);
+                    auto [lhs, rhs] = norm(binOp->opcode, binOp->left->toString(), binOp->right->toString());
                     allExprs.insert(Expression{binOp->opcode, lhs, rhs, false});
                 }
             }
@@ -2220,7 +2454,7 @@ void IRGenerator::commonSubexpressionElimination() {
             // GEN 仅包含 BinaryOpInstr
             if (auto binOp = std::dynamic_pointer_cast<BinaryOpInstr>(instr)) {
                 if (!isSideEffectInstr(instr)) {
-                    auto [lhs, rhs] = norm(binOp->opcode, binOp->left->name, binOp->right->name);
+                    auto [lhs, rhs] = norm(binOp->opcode, binOp->left->toString(), binOp->right->toString());
                     gen.insert(Expression{binOp->opcode, lhs, rhs, false});
                 }
             }
@@ -2324,7 +2558,7 @@ void IRGenerator::commonSubexpressionElimination() {
             }
 
             // 标准化表达式（无版本）
-            auto [lhs, rhs] = norm(binOp->opcode, binOp->left->name, binOp->right->name);
+            auto [lhs, rhs] = norm(binOp->opcode, binOp->left->toString(), binOp->right->toString());
             Expression e{binOp->opcode, lhs, rhs, false};
 
             // 【修改7】仅当：
@@ -2406,6 +2640,150 @@ void IRGenerator::commonSubexpressionElimination() {
 
 
 
+/**
+ * 块内值编号（Local Value Numbering）。
+ *
+ * 只在单个基本块内传播常量和复制、复用相同的二元表达式，遇到标签和跳转就清空，
+ * 一趟线性扫描，不建 CFG。全局的常量传播和公共子表达式消除超出编译预算时用它代替，
+ * 效果弱一些，但工作量与指令数成正比。
+ */
+void IRGenerator::localValueNumbering() {
+    // 名字每被定义一次版本加一；记录里带着版本，名字被重新定义后旧记录自然失效
+    std::unordered_map<std::string, int> versions;
+    struct Value {
+        std::shared_ptr<Operand> operand;   // 常量，或持有同一个值的变量
+        int version = 0;                    // operand 为变量时记录时的版本
+    };
+    std::unordered_map<std::string, std::pair<int, Value>> known;   // 名字 -> (名字的版本, 它等于的值)
+    std::unordered_map<std::string, Value> expressions;             // 表达式 -> 持有其值的变量
+
+    auto versionOf = [&](const std::string& name) {
+        auto it = versions.find(name);
+        return it == versions.end() ? 0 : it->second;
+    };
+    auto isName = [](const std::shared_ptr<Operand>& operand) {
+        return operand && (operand->type == OperandType::VARIABLE || operand->type == OperandType::TEMP);
+    };
+    // 已知等于常量或仍然有效的变量时，把操作数换成它
+    auto replace = [&](std::shared_ptr<Operand>& operand) {
+        if (!isName(operand)) {
+            return;
+        }
+        auto it = known.find(operand->name);
+        if (it == known.end() || it->second.first != versionOf(operand->name)) {
+            return;
+        }
+        const Value& value = it->second.second;
+        if (value.operand->type == OperandType::CONSTANT) {
+            operand = makeConstantOperand(value.operand->value, operand->name);
+        } else if (versionOf(value.operand->name) == value.version) {
+            operand = value.operand;
+        }
+    };
+    auto valueKey = [&](const std::shared_ptr<Operand>& operand) {
+        if (operand->type == OperandType::CONSTANT) {
+            return std::to_string(operand->value);
+        }
+        return operand->name + "#" + std::to_string(versionOf(operand->name));
+    };
+    // 定义 result，并记下它等于 value（可为空）
+    auto define = [&](const std::shared_ptr<Operand>& result, const std::shared_ptr<Operand>& value) {
+        int version = ++versions[result->name];
+        if (value && (value->type == OperandType::CONSTANT || (isName(value) && value->name != result->name))) {
+            known[result->name] = {version, Value{value, versionOf(value->name)}};
+        }
+    };
+    auto reset = [&] {
+        known.clear();
+        expressions.clear();
+    };
+
+    for (auto& instr : instructions) {
+        switch (instr->opcode) {
+            case OpCode::LABEL:
+            case OpCode::FUNCTION_BEGIN:
+            case OpCode::FUNCTION_END:
+            case OpCode::GOTO:
+                reset();
+                break;
+
+            case OpCode::ASSIGN: {
+                auto assign = std::static_pointer_cast<AssignInstr>(instr);
+                replace(assign->source);
+                define(assign->target, assign->source);
+                break;
+            }
+
+            case OpCode::NEG:
+            case OpCode::NOT: {
+                if (auto unary = std::dynamic_pointer_cast<UnaryOpInstr>(instr)) {
+                    replace(unary->operand);
+                    define(unary->result, nullptr);
+                }
+                break;
+            }
+
+            case OpCode::CALL: {
+                auto call = std::static_pointer_cast<CallInstr>(instr);
+                for (auto& arg : call->params) {
+                    replace(arg);
+                }
+                if (call->result) {
+                    define(call->result, nullptr);
+                }
+                break;
+            }
+
+            case OpCode::RETURN: {
+                auto ret = std::static_pointer_cast<ReturnInstr>(instr);
+                replace(ret->value);
+                reset();
+                break;
+            }
+
+            case OpCode::IF_GOTO: {
+                auto ifGoto = std::static_pointer_cast<IfGotoInstr>(instr);
+                replace(ifGoto->condition);
+                reset();
+                break;
+            }
+
+            default: {
+                auto binOp = std::dynamic_pointer_cast<BinaryOpInstr>(instr);
+                if (!binOp) {
+                    break;
+                }
+                replace(binOp->left);
+                replace(binOp->right);
+
+                std::string lhs = valueKey(binOp->left);
+                std::string rhs = valueKey(binOp->right);
+                if ((binOp->opcode == OpCode::ADD || binOp->opcode == OpCode::MUL ||
+                     binOp->opcode == OpCode::EQ || binOp->opcode == OpCode::NE) && rhs < lhs) {
+                    std::swap(lhs, rhs);
+                }
+                std::string key = std::to_string(static_cast<int>(binOp->opcode)) + "|" + lhs + "|" + rhs;
+
+                auto it = expressions.find(key);
+                if (it != expressions.end() && versionOf(it->second.operand->name) == it->second.version) {
+                    // 同一个值已经在块内算过，改成复制
+                    auto holder = it->second.operand;
+                    instr = std::make_shared<AssignInstr>(binOp->result, holder);
+                    define(binOp->result, holder);
+                    break;
+                }
+
+                define(binOp->result, nullptr);
+                // x = x + 1 这类结果覆盖了操作数的表达式，之后不能复用
+                if (binOp->result->name != binOp->left->name && binOp->result->name != binOp->right->name) {
+                    expressions[key] = Value{binOp->result, versionOf(binOp->result->name)};
+                }
+                break;
+            }
+        }
+    }
+}
+
 /**
  * 执行控制流优化（Control Flow Optimization）
  * 主要包含四个优化阶段：
@@ -2483,6 +2861,7 @@ void IRGenerator::controlFlowOptimization() {
     // 构建基本块和CFG
     auto blocks = buildBasicBlocks();
     buildCFG(blocks);
+    CFGEdgeRelease releaseEdges(blocks);
     if (blocks.empty()) return;
 
     // Step 1: 删除不可达基本块
@@ -2739,13 +3118,15 @@ void IRGenerator::visit(VariableExpr& expr) {
  * @param expr 二元表达式
  */
 void IRGenerator::visit(BinaryExpr& expr) {
+    std::shared_ptr<Operand> target = takeDestination();
+
     // 处理逻辑运算符的短路求值
     if (expr.op == "&&") {
-        auto result = generateShortCircuitAnd(expr);
+        auto result = generateShortCircuitAnd(expr, target);
         operandStack.push_back(result);
         return;
     } else if (expr.op == "||") {
-        auto result = generateShortCircuitOr(expr);
+        auto result = generateShortCircuitOr(expr, target);
         operandStack.push_back(result);
         return;
     }
@@ -2756,7 +3137,7 @@ void IRGenerator::visit(BinaryExpr& expr) {
     expr.left->accept(*this);
     std::shared_ptr<Operand> left = getTopOperand();
     
-    std::shared_ptr<Operand> result = createTemp();
+    std::shared_ptr<Operand> result = target ? target : createTemp();
     // 将运算符字符串映射到操作码
     OpCode opcode;
     if (expr.op == "+") opcode = OpCode::ADD;
@@ -2788,15 +3169,18 @@ void IRGenerator::visit(BinaryExpr& expr) {
  * 无需评估右操作数。否则，结果为右操作数的值。
  * 
  * @param expr 二元表达式
+ * @param result 结果要写进的变量；为空时用新的临时变量
  * @return 结果操作数
  */
-std::shared_ptr<Operand> IRGenerator::generateShortCircuitAnd(BinaryExpr& expr) {
+std::shared_ptr<Operand> IRGenerator::generateShortCircuitAnd(BinaryExpr& expr, std::shared_ptr<Operand> result) {
     // 评估左操作数
     expr.left->accept(*this);
     std::shared_ptr<Operand> left = getTopOperand();
 
     // 创建结果临时变量和短路标签
-    std::shared_ptr<Operand> result = createTemp();
+    if (!result) {
+        result = createTemp();
+    }
     std::shared_ptr<Operand> shortCircuitLabel = createLabel();
     std::shared_ptr<Operand> endLabel = createLabel();
 
@@ -2834,15 +3218,18 @@ std::shared_ptr<Operand> IRGenerator::generateShortCircuitAnd(BinaryExpr& expr)
  * 无需评估右操作数。否则，结果为右操作数的值。
  * 
  * @param expr 二元表达式
+ * @param result 结果要写进的变量；为空时用新的临时变量
  * @return 结果操作数
  */
-std::shared_ptr<Operand> IRGenerator::generateShortCircuitOr(BinaryExpr& expr) {
+std::shared_ptr<Operand> IRGenerator::generateShortCircuitOr(BinaryExpr& expr, std::shared_ptr<Operand> result) {
     // 评估左操作数
     expr.left->accept(*this);
     std::shared_ptr<Operand> left = getTopOperand();
     
     // 创建结果临时变量和短路标签
-    std::shared_ptr<Operand> result = createTemp();
+    if (!result) {
+        result = createTemp();
+    }
     std::shared_ptr<Operand> shortCircuitLabel = createLabel();
     std::shared_ptr<Operand> endLabel = createLabel();
     
@@ -2867,6 +3254,79 @@ std::shared_ptr<Operand> IRGenerator::generateShortCircuitOr(BinaryExpr& expr) {
     return result;
 }
 
+/**
+ * 把 if/while 的条件翻译成跳转代码。
+ *
+ * 条件的值为 jumpIfTrue 时跳到 target，否则落到后面的代码。&&、|| 把跳转目标往下传，
+ * 短路时直接跳走；! 只是把 jumpIfTrue 取反。到了叶子上，比较运算按需要换成相反的比较
+ * （a < b 为假即 a >= b 为真），常量条件直接变成无条件跳转或什么都不生成，
+ * 其他表达式照常求值后按非零判断。整个条件不会先算出 0/1 再判断一次。
+ *
+ * @param expr 条件表达式
+ * @param target 跳转目标
+ * @param jumpIfTrue 条件为真时跳转（false 表示为假时跳转）
+ */
+void IRGenerator::lowerCondition(Expr& expr, const std::shared_ptr<Operand>& target, bool jumpIfTrue) {
+    if (auto number = dynamic_cast<NumberExpr*>(&expr)) {
+        if ((number->value != 0) == jumpIfTrue) {
+            addInstruction(std::make_shared<GotoInstr>(target));
+        }
+        return;
+    }
+
+    if (auto unary = dynamic_cast<UnaryExpr*>(&expr); unary && unary->op == "!") {
+        lowerCondition(*unary->operand, target, !jumpIfTrue);
+        return;
+    }
+
+    if (auto binary = dynamic_cast<BinaryExpr*>(&expr)) {
+        // a && b 为假、a || b 为真时，左边就能决定结果，直接跳到 target；
+        // 另外两种情况下左边决定结果时要跳过右边，落到整个条件之后
+        bool isAnd = binary->op == "&&";
+        if (isAnd || binary->op == "||") {
+            if (isAnd != jumpIfTrue) {
+                lowerCondition(*binary->left, target, jumpIfTrue);
+                lowerCondition(*binary->right, target, jumpIfTrue);
+            } else {
+                std::shared_ptr<Operand> skipLabel = createLabel();
+                lowerCondition(*binary->left, skipLabel, !jumpIfTrue);
+                lowerCondition(*binary->right, target, jumpIfTrue);
+                addInstruction(std::make_shared<LabelInstr>(skipLabel->name));
+            }
+            return;
+        }
+
+        static const std::map<std::string, std::pair<OpCode, OpCode>> comparisons = {
+            {"<", {OpCode::LT, OpCode::GE}}, {">", {OpCode::GT, OpCode::LE}},
+            {"<=", {OpCode::LE, OpCode::GT}}, {">=", {OpCode::GE, OpCode::LT}},
+            {"==", {OpCode::EQ, OpCode::NE}}, {"!=", {OpCode::NE, OpCode::EQ}},
+        };
+        auto it = comparisons.find(binary->op);
+        if (it != comparisons.end()) {
+            // 与 visit(BinaryExpr&) 相同，先右后左求值
+            binary->right->accept(*this);
+            std::shared_ptr<Operand> right = getTopOperand();
+            binary->left->accept(*this);
+            std::shared_ptr<Operand> left = getTopOperand();
+
+            std::shared_ptr<Operand> result = createTemp();
+            OpCode opcode = jumpIfTrue ? it->second.first : it->second.second;
+            addInstruction(std::make_shared<BinaryOpInstr>(opcode, result, left, right));
+            addInstruction(std::make_shared<IfGotoInstr>(result, target));
+            return;
+        }
+    }
+
+    expr.accept(*this);
+    std::shared_ptr<Operand> value = getTopOperand();
+    if (!jumpIfTrue) {
+        std::shared_ptr<Operand> negated = createTemp();
+        addInstruction(std::make_shared<UnaryOpInstr>(OpCode::NOT, negated, value));
+        value = negated;
+    }
+    addInstruction(std::make_shared<IfGotoInstr>(value, target));
+}
+
 /**
  * 访问一元表达式。
  * 
@@ -2875,10 +3335,11 @@ std::shared_ptr<Operand> IRGenerator::generateShortCircuitOr(BinaryExpr& expr) {
  * @param expr 一元表达式
  */
 void IRGenerator::visit(UnaryExpr& expr) {
+    std::shared_ptr<Operand> target = takeDestination();
     expr.operand->accept(*this);
     std::shared_ptr<Operand> operand = getTopOperand();
     
-    std::shared_ptr<Operand> result = createTemp();
+    std::shared_ptr<Operand> result = target ? target : createTemp();
     
     // 处理不同的一元运算符
     if (expr.op == "-") {
@@ -2908,6 +3369,8 @@ void IRGenerator::visit(UnaryExpr& expr) {
  * @param expr 函数调用表达式
  */
 void IRGenerator::visit(CallExpr& expr) {
+    std::shared_ptr<Operand> target = takeDestination();
+
     // 处理参数
     std::vector<std::shared_ptr<Operand>> args;
     for (const auto& arg : expr.arguments) {
@@ -2915,19 +3378,14 @@ void IRGenerator::visit(CallExpr& expr) {
         args.push_back(getTopOperand());
     }
     
-    // 从左到右添加参数指令（与RISC-V调用约定一致）
-    for (const auto& arg : args) {
-        addInstruction(std::make_shared<ParamInstr>(arg));
-    }
-    
-    // 为结果创建临时变量
-    std::shared_ptr<Operand> result = createTemp();
+    // 为结果创建临时变量（没有目标变量时）
+    std::shared_ptr<Operand> result = target ? target : createTemp();
     
     // 创建调用指令
     auto callInstr = std::make_shared<CallInstr>(
         result, expr.callee, expr.arguments.size());
     
-    // 存储参数列表，便于代码生成
+    // 实参只记在调用指令上，代码生成按它传参
     callInstr->params = args;
     
     // 调用函数
@@ -2983,10 +3441,10 @@ void IRGenerator::visit(VarDeclStmt& stmt) {
     std::shared_ptr<Operand> var = getVariable(stmt.name, true);
     
     if (stmt.initializer) {
-        stmt.initializer->accept(*this);
-        std::shared_ptr<Operand> value = getTopOperand();
-        
-        addInstruction(std::make_shared<AssignInstr>(var, value));
+        std::shared_ptr<Operand> value = lowerInto(*stmt.initializer, var);
+        if (value != var) {
+            addInstruction(std::make_shared<AssignInstr>(var, value));
+        }
     }
 }
 
@@ -2998,15 +3456,14 @@ void IRGenerator::visit(VarDeclStmt& stmt) {
  * @param stmt 赋值语句
  */
 void IRGenerator::visit(AssignStmt& stmt) {
-    // 评估右侧
-    stmt.value->accept(*this);
-    std::shared_ptr<Operand> value = getTopOperand();
-    
     // 获取变量
     std::shared_ptr<Operand> var = getVariable(stmt.name);
     
-    // 将值赋给变量
-    addInstruction(std::make_shared<AssignInstr>(var, value));
+    // 评估右侧，结果直接写进变量；右侧只是常量或另一个变量时补一条赋值
+    std::shared_ptr<Operand> value = lowerInto(*stmt.value, var);
+    if (value != var) {
+        addInstruction(std::make_shared<AssignInstr>(var, value));
+    }
 }
 
 /**
@@ -3040,18 +3497,8 @@ void IRGenerator::visit(IfStmt& stmt) {
     std::shared_ptr<Operand> elseLabel = createLabel();
     std::shared_ptr<Operand> endLabel = stmt.elseBranch ? createLabel() : elseLabel;
     
-    // 评估条件
-    stmt.condition->accept(*this);
-    std::shared_ptr<Operand> condition = getTopOperand();
-    
-    // 如果条件为假，跳转到else分支
-    // 注意：IfGotoInstr在条件为真时跳转，所以我们需要翻转逻辑
-    // 我们想要的是：if (!condition) goto elseLabel
-    // 但IfGotoInstr是：if (condition) goto target
-    // 所以我们需要使用一个临时变量来存储!condition
-    std::shared_ptr<Operand> notCondition = createTemp();
-    addInstruction(std::make_shared<UnaryOpInstr>(OpCode::NOT, notCondition, condition));
-    addInstruction(std::make_shared<IfGotoInstr>(notCondition, elseLabel));
+    // 条件为假时跳转到else分支
+    lowerCondition(*stmt.condition, elseLabel, false);
     
     // 为then分支生成代码
     stmt.thenBranch->accept(*this);
@@ -3102,12 +3549,8 @@ void IRGenerator::visit(WhileStmt& stmt) {
     // 条件判断标签
     addInstruction(std::make_shared<LabelInstr>(condLabel->name));
     
-    // 条件表达式
-    stmt.condition->accept(*this);
-    std::shared_ptr<Operand> condition = getTopOperand();
-    
     // 条件为真时跳转到循环体开始
-    addInstruction(std::make_shared<IfGotoInstr>(condition, startLabel));
+    lowerCondition(*stmt.condition, startLabel, true);
     
     // 循环结束标签
     addInstruction(std::make_shared<LabelInstr>(endLabel->name));
@@ -3183,6 +3626,8 @@ void IRGenerator::visit(ReturnStmt& stmt) {
 void IRGenerator::visit(FunctionDef& funcDef) {
     currentFunction = funcDef.name;
     currentFunctionReturnType = funcDef.returnType;
+    tempCount = 0;
+    labelCount = 0;
 
     // 函数开始
     auto funcBeginInstr = std::make_shared<FunctionBeginInstr>(funcDef.name, funcDef.returnType);
@@ -3405,9 +3850,11 @@ std::vector<std::string> IRAnalyzer::getUsedVariables(const std::shared_ptr<IRIn
             usedVars.push_back(ifGotoInstr->condition->name);
         }
     }
-    else if (auto paramInstr = std::dynamic_pointer_cast<ParamInstr>(instr)) {
-        if (paramInstr->param && paramInstr->param->type != OperandType::CONSTANT) {
-            usedVars.push_back(paramInstr->param->name);
+    else if (auto callInstr = std::dynamic_pointer_cast<CallInstr>(instr)) {
+        for (const auto& param : callInstr->params) {
+            if (param && param->type != OperandType::CONSTANT) {
+                usedVars.push_back(param->name);
+            }
         }
     }
     else if (auto returnInstr = std::dynamic_pointer_cast<ReturnInstr>(instr)) {
@@ -3515,6 +3962,7 @@ void IRGenerator::loopInvariantCodeMotion() {
     // 构建CFG
     auto blocks = buildBasicBlocks();
     buildCFG(blocks);
+    CFGEdgeRelease releaseEdges(blocks);
     
     if (blocks.empty()) return;
     
@@ -3554,6 +4002,10 @@ void IRGenerator::loopInvariantCodeMotion() {
                 // 跳过有副作用的指令
                 if (isSideEffectInstr(instr)) continue;
                 
+                // 只外提写临时变量的指令：临时变量只定义一次，提前算好不影响别处；
+                // 源码变量（赋值直接写进变量时）在循环里可能还有别的定义和使用
+                if (binOp->result->type != OperandType::TEMP) continue;
+
                 // 检查是否是常量运算（两个操作数都是常量）
                 bool leftConst = (binOp->left->type == OperandType::CONSTANT);
                 bool rightConst = (binOp->right->type == OperandType::CONSTANT);
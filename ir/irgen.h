@@ -1,5 +1,6 @@
 #pragma once
 #include "ir.h"
+#include "budget.h"
 #include "parser/ast.h"
 #include "semantic/semantic.h"
 #include <string>
@@ -24,6 +25,13 @@ struct IRGenConfig {
     bool enableOptimizations = false;
     bool generateDebugInfo = false;
     bool inlineSmallFunctions = false;
+    std::vector<std::string> passes;   // 非空时按此序列运行（名字见 passNames()），代替默认序列
+
+    // 单个函数上的工作量预算（见 ir/budget.h），0 表示不限。全局数据流遍运行前
+    // 估算工作量，超出单遍预算或函数累计预算时降级为块内值编号或跳过，
+    // 保证超大函数的优化时间有界
+    uint64_t passBudget = 1000000;
+    uint64_t functionBudget = 3000000;
 };
 
 // ==================== IR优化器接口 ====================
@@ -68,6 +76,8 @@ private:
     std::map<std::string, std::shared_ptr<Operand>> variables;
     std::vector<std::shared_ptr<Operand>> operandStack;
     std::vector<std::map<std::string, std::shared_ptr<Operand>>> scopeStack;
+    // 正在求值的表达式的结果要写进的变量；为空时写进新的临时变量，见 lowerInto()
+    std::shared_ptr<Operand> destination;
     
     int tempCount = 0;
     int labelCount = 0;
@@ -128,7 +138,6 @@ public:
                 case OpCode::ASSIGN: op = "ASSIGN"; break;
                 case OpCode::GOTO: op = "GOTO"; break;
                 case OpCode::IF_GOTO: op = "IF_GOTO"; break;
-                case OpCode::PARAM: op = "PARAM"; break;
                 case OpCode::CALL: op = "CALL"; break;
                 case OpCode::RETURN: op = "RETURN"; break;
                 case OpCode::LABEL: op = "LABEL"; break;
@@ -148,8 +157,31 @@ public:
     const std::vector<std::shared_ptr<IRInstr>>& getInstructions() const { 
         return instructions; 
     }
+
+    const IRGenConfig& getConfig() const { return config; }
     
     void generate(std::shared_ptr<CompUnit> ast);
+
+    /**
+     * 为单个函数生成 IR，并按配置优化。
+     *
+     * 临时变量和标签在每个函数内从零编号，标签带函数名前缀，
+     * 优化也只在该函数的指令上进行，因此结果只取决于函数本身，
+     * 可以按函数缓存和复用。generate() 就是逐个函数调用本方法后拼接。
+     */
+    std::vector<std::shared_ptr<IRInstr>> generateFunction(FunctionDef& funcDef);
+
+    // generateFunction() 的两个步骤，流水线编译时在不同线程上分别执行；
+    // optimizeFunction() 不依赖 lowerFunction() 留下的状态，可以用另一个生成器实例
+    std::vector<std::shared_ptr<IRInstr>> lowerFunction(FunctionDef& funcDef);
+    void optimizeFunction(std::vector<std::shared_ptr<IRInstr>>& funcInstrs);
+
+    // 可单独运行的优化遍的名字，供 toyc_opt -passes= 选择
+    static std::vector<std::string> passNames();
+    bool runPasses(std::vector<std::shared_ptr<IRInstr>>& funcInstrs, const std::vector<std::string>& passes);
+
+    // 取走此前优化时因超出预算而降级的记录
+    std::vector<BudgetEvent> takeBudgetEvents() { return std::move(budgetEvents); }
     void dumpIR(const std::string& filename) const;
     void optimize();
 
@@ -157,6 +189,10 @@ public:
     std::shared_ptr<Operand> createLabel();
     void addInstruction(std::shared_ptr<IRInstr> instr);
     std::shared_ptr<Operand> getTopOperand();
+    // 求值 expr，最后一条指令直接写进 target；返回持有结果的操作数（target，或常量、变量本身）
+    std::shared_ptr<Operand> lowerInto(Expr& expr, const std::shared_ptr<Operand>& target);
+    // 取走当前表达式的目标变量；必须在求值子表达式之前取走，子表达式只能写临时变量
+    std::shared_ptr<Operand> takeDestination();
 
     const std::set<std::string>& getUsedFunctions() const {
         return usedFunctions;
@@ -195,12 +231,27 @@ private:
     std::shared_ptr<Operand> findVariable(const std::string& name);
     void defineVariable(const std::string& name, std::shared_ptr<Operand> var);
     
+    using Pass = void (IRGenerator::*)();
+    struct PassInfo {
+        std::string name;
+        Pass run;
+        bool global;      // 基于整个函数的数据流分析，工作量随函数规模超线性增长，受预算约束
+        std::string fallback;   // 超出预算时改用的块内版本的名字，为空则跳过
+    };
+    static const std::vector<PassInfo>& passTable();
+    static const PassInfo* findPass(const std::string& name);
+    void runOnFunction(std::vector<std::shared_ptr<IRInstr>>& funcInstrs, const std::function<void()>& body);
+    void runPassSequence(const std::vector<const PassInfo*>& sequence);
+
+    std::vector<BudgetEvent> budgetEvents;
+
     void constantFolding();
     void constantPropagationCFG();
     void deadCodeElimination();
     void copyPropagationCFG();
     void controlFlowOptimization();
     void commonSubexpressionElimination();
+    void localValueNumbering();
     void algebraicSimplification();
     void loopInvariantCodeMotion();
     void strengthReduction();
@@ -213,11 +264,14 @@ private:
         std::unordered_set<std::string>& visited,
         int depth = 0);
     
-    std::shared_ptr<Operand> generateShortCircuitAnd(BinaryExpr& expr);
-    std::shared_ptr<Operand> generateShortCircuitOr(BinaryExpr& expr);
+    std::shared_ptr<Operand> generateShortCircuitAnd(BinaryExpr& expr, std::shared_ptr<Operand> result);
+    std::shared_ptr<Operand> generateShortCircuitOr(BinaryExpr& expr, std::shared_ptr<Operand> result);
+    // 控制流中的条件：值为 jumpIfTrue 时跳到 target，否则顺序执行下去，不生成布尔值
+    void lowerCondition(Expr& expr, const std::shared_ptr<Operand>& target, bool jumpIfTrue);
     
     std::shared_ptr<Operand> makeConstantOperand(int v, std::string name);
 
+    std::string blockLabel(int id) const;
     std::vector<std::shared_ptr<BasicBlock>> buildBasicBlocks();
     std::vector<std::shared_ptr<BasicBlock>> buildBasicBlocksByLabel();
 
@@ -0,0 +1,69 @@
+#pragma once
+#include "lexer.h"
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// ==================== 关键字识别 ====================
+//
+// 关键字集合固定，编译期构造一张 16 槽的完美哈希表：
+// 槽位 = (首字符 + 7 * 长度) & 15。分类一个标识符只需一次取槽和
+// 一次定长比较，不分配内存；若增删关键字导致冲突，buildKeywordTable
+// 在常量求值中抛出异常，编译直接失败。
+
+struct KeywordEntry {
+    std::string_view text;
+    TokenType type = TokenType::IDENTIFIER;
+};
+
+inline constexpr KeywordEntry kKeywords[] = {
+    {"int", TokenType::INT},
+    {"void", TokenType::VOID},
+    {"if", TokenType::IF},
+    {"else", TokenType::ELSE},
+    {"while", TokenType::WHILE},
+    {"break", TokenType::BREAK},
+    {"continue", TokenType::CONTINUE},
+    {"return", TokenType::RETURN},
+    {"const", TokenType::CONST},
+};
+
+inline constexpr size_t kKeywordMinLength = 2;
+inline constexpr size_t kKeywordMaxLength = 8;
+inline constexpr size_t kKeywordSlots = 16;
+
+constexpr size_t keywordSlot(std::string_view text) {
+    return (static_cast<unsigned char>(text[0]) + 7 * text.size()) & (kKeywordSlots - 1);
+}
+
+constexpr std::array<KeywordEntry, kKeywordSlots> buildKeywordTable() {
+    std::array<KeywordEntry, kKeywordSlots> table{};
+    for (const KeywordEntry& keyword : kKeywords) {
+        if (keyword.text.size() < kKeywordMinLength || keyword.text.size() > kKeywordMaxLength) {
+            throw "keyword length outside [kKeywordMinLength, kKeywordMaxLength]";
+        }
+        KeywordEntry& slot = table[keywordSlot(keyword.text)];
+        if (!slot.text.empty()) {
+            throw "keyword hash collision, pick a new slot function";
+        }
+        slot = keyword;
+    }
+    return table;
+}
+
+inline constexpr std::array<KeywordEntry, kKeywordSlots> kKeywordTable = buildKeywordTable();
+
+// 关键字返回对应的 TokenType，否则返回 IDENTIFIER
+constexpr TokenType classifyIdentifier(std::string_view text) {
+    if (text.size() < kKeywordMinLength || text.size() > kKeywordMaxLength) {
+        return TokenType::IDENTIFIER;
+    }
+    const KeywordEntry& entry = kKeywordTable[keywordSlot(text)];
+    return entry.text == text ? entry.type : TokenType::IDENTIFIER;
+}
+
+static_assert(classifyIdentifier("continue") == TokenType::CONTINUE);
+static_assert(classifyIdentifier("const") == TokenType::CONST);
+static_assert(classifyIdentifier("if") == TokenType::IF);
+static_assert(classifyIdentifier("iff") == TokenType::IDENTIFIER);
+static_assert(classifyIdentifier("x") == TokenType::IDENTIFIER);
@@ -1,40 +1,53 @@
 #include "lexer.h"
+#include "keywords.h"
+#include "scan_kernels.h"
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
-// ==================== 构造函数 ====================
+// ==================== 行首偏移表 ====================
 
-Lexer::Lexer() : source(""), position(0), line(1), column(1) {
-    keywords["int"] = TokenType::INT;
-    keywords["void"] = TokenType::VOID;
-    keywords["if"] = TokenType::IF;
-    keywords["else"] = TokenType::ELSE;
-    keywords["while"] = TokenType::WHILE;
-    keywords["break"] = TokenType::BREAK;
-    keywords["continue"] = TokenType::CONTINUE;
-    keywords["return"] = TokenType::RETURN;
-    
-    initOperators();
+void LineTable::build() const {
+    lineStarts.push_back(0);
+    const char* begin = source.data();
+    const char* end = begin + source.size();
+    for (const char* p = begin; p < end; ++p) {
+        p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!p) break;
+        lineStarts.push_back(static_cast<uint32_t>(p - begin + 1));
+    }
 }
 
-Lexer::Lexer(const std::string& source) : source(source), position(0), line(1), column(1) {
-    keywords["int"] = TokenType::INT;
-    keywords["void"] = TokenType::VOID;
-    keywords["if"] = TokenType::IF;
-    keywords["else"] = TokenType::ELSE;
-    keywords["while"] = TokenType::WHILE;
-    keywords["break"] = TokenType::BREAK;
-    keywords["continue"] = TokenType::CONTINUE;
-    keywords["return"] = TokenType::RETURN;
-
-    initOperators();
+int LineTable::columnOf(const Token& token) const {
+    if (lineStarts.empty()) {
+        build();
+    }
+    // Token 自带行号，直接定位行首；行号越界时退回二分查找
+    uint32_t lineStart;
+    if (token.line >= 1 && token.line <= lineStarts.size() &&
+        lineStarts[token.line - 1] <= token.offset) {
+        lineStart = lineStarts[token.line - 1];
+    } else {
+        auto it = std::upper_bound(lineStarts.begin(), lineStarts.end(), token.offset);
+        lineStart = *(it - 1);
+    }
+    return static_cast<int>(token.offset - lineStart) + 1;
 }
 
+// ==================== 构造函数 ====================
+
+Lexer::Lexer() : source(""), position(0), line(1), lineTable(source) {}
+
+Lexer::Lexer(const std::string& source) : source(source), position(0), line(1), lineTable(this->source) {}
+
 // ==================== 核心扫描方法 ====================
 
 std::vector<Token> Lexer::tokenize() {
     std::vector<Token> tokens;
+    // 经验值：平均每 4 个字符一个标记，避免反复扩容
+    tokens.reserve(source.size() / 4 + 1);
     
     while (!isAtEnd()) {
         skipWhitespace();
@@ -43,113 +56,103 @@ std::vector<Token> Lexer::tokenize() {
         tokens.push_back(scanToken());
     }
     
-    tokens.push_back(Token(TokenType::END_OF_FILE, "", line, column));
+    tokens.push_back(makeToken(TokenType::END_OF_FILE, position, line));
     return tokens;
 }
 
+Token Lexer::makeToken(TokenType type, uint32_t start, uint32_t startLine) const {
+    return Token(type, start, position - start, startLine);
+}
+
 Token Lexer::scanToken() {
-    char c = advance();
+    char c = peek();
     
     if (isalpha(c) || c == '_') {
-        position--;
-        column--;
         return scanIdentifier();
     }
     
     if (isdigit(c)) {
-        position--;
-        column--;
         return scanNumber();
     }
     
-    int tokenLine = line;
-    int tokenColumn = column - 1;
+    uint32_t start = position;
+    uint32_t tokenLine = line;
+    advance();
 
     switch (c) {
-        case '(': return Token(TokenType::LPAREN, "(", tokenLine, tokenColumn);
-        case ')': return Token(TokenType::RPAREN, ")", tokenLine, tokenColumn);
-        case '{': return Token(TokenType::LBRACE, "{", tokenLine, tokenColumn);
-        case '}': return Token(TokenType::RBRACE, "}", tokenLine, tokenColumn);
-        case ';': return Token(TokenType::SEMICOLON, ";", tokenLine, tokenColumn);
-        case ',': return Token(TokenType::COMMA, ",", tokenLine, tokenColumn);
-        case '+': return Token(TokenType::PLUS, "+", tokenLine, tokenColumn);
-        case '-': return Token(TokenType::MINUS, "-", tokenLine, tokenColumn);
-        case '*': return Token(TokenType::MULTIPLY, "*", tokenLine, tokenColumn);
-        case '%': return Token(TokenType::MODULO, "%", tokenLine, tokenColumn);
-        case '/': return Token(TokenType::DIVIDE, "/", tokenLine, tokenColumn);
+        case '(': return makeToken(TokenType::LPAREN, start, tokenLine);
+        case ')': return makeToken(TokenType::RPAREN, start, tokenLine);
+        case '{': return makeToken(TokenType::LBRACE, start, tokenLine);
+        case '}': return makeToken(TokenType::RBRACE, start, tokenLine);
+        case ';': return makeToken(TokenType::SEMICOLON, start, tokenLine);
+        case ',': return makeToken(TokenType::COMMA, start, tokenLine);
+        case '+': return makeToken(TokenType::PLUS, start, tokenLine);
+        case '-': return makeToken(TokenType::MINUS, start, tokenLine);
+        case '*': return makeToken(TokenType::MULTIPLY, start, tokenLine);
+        case '%': return makeToken(TokenType::MODULO, start, tokenLine);
+        case '/': return makeToken(TokenType::DIVIDE, start, tokenLine);
             
         case '=':
             if (peek() == '=') {
                 advance();
-                return Token(TokenType::EQ, "==", tokenLine, tokenColumn);
+                return makeToken(TokenType::EQ, start, tokenLine);
             }
-            return Token(TokenType::ASSIGN, "=", tokenLine, tokenColumn);
+            return makeToken(TokenType::ASSIGN, start, tokenLine);
             
         case '!':
             if (peek() == '=') {
                 advance();
-                return Token(TokenType::NEQ, "!=", tokenLine, tokenColumn);
+                return makeToken(TokenType::NEQ, start, tokenLine);
             }
-            return Token(TokenType::NOT, "!", tokenLine, tokenColumn);
+            return makeToken(TokenType::NOT, start, tokenLine);
             
         case '<':
             if (peek() == '=') {
                 advance();
-                return Token(TokenType::LE, "<=", tokenLine, tokenColumn);
+                return makeToken(TokenType::LE, start, tokenLine);
             }
-            return Token(TokenType::LT, "<", tokenLine, tokenColumn);
+            return makeToken(TokenType::LT, start, tokenLine);
             
         case '>':
             if (peek() == '=') {
                 advance();
-                return Token(TokenType::GE, ">=", tokenLine, tokenColumn);
+                return makeToken(TokenType::GE, start, tokenLine);
             }
-            return Token(TokenType::GT, ">", tokenLine, tokenColumn);
+            return makeToken(TokenType::GT, start, tokenLine);
             
         case '&':
             if (peek() == '&') {
                 advance();
-                return Token(TokenType::AND, "&&", tokenLine, tokenColumn);
+                return makeToken(TokenType::AND, start, tokenLine);
             }
-            return Token(TokenType::UNKNOWN, "&", tokenLine, tokenColumn);
+            return makeToken(TokenType::UNKNOWN, start, tokenLine);
             
         case '|':
             if (peek() == '|') {
                 advance();
-                return Token(TokenType::OR, "||", tokenLine, tokenColumn);
+                return makeToken(TokenType::OR, start, tokenLine);
             }
-            return Token(TokenType::UNKNOWN, "|", tokenLine, tokenColumn);
+            return makeToken(TokenType::UNKNOWN, start, tokenLine);
     }
     
-    return Token(TokenType::UNKNOWN, std::string(1, c), tokenLine, tokenColumn);
+    return makeToken(TokenType::UNKNOWN, start, tokenLine);
 }
 
 Token Lexer::scanIdentifier() {
-    int startPos = position;
-    int startColumn = column;
-    int startLine = line;
-    
-    if (isalpha(peek()) || peek() == '_') {
-        advance();
-    }
+    uint32_t startPos = position;
+    uint32_t startLine = line;
     
-    while (!isAtEnd() && (isalnum(peek()) || peek() == '_')) {
-        advance();
-    }
+    // 标识符不含换行，整段跳过即可，无需逐字符维护行号
+    const char* begin = source.data();
+    position = static_cast<uint32_t>(scanIdentifierRun(begin + position, begin + source.size()) - begin);
 
-    std::string lexeme = source.substr(startPos, position - startPos);
-    
-    if (keywords.find(lexeme) != keywords.end()) {
-        return Token(keywords[lexeme], lexeme, startLine, startColumn);
-    }
-    
-    return Token(TokenType::IDENTIFIER, lexeme, startLine, startColumn);
+    std::string_view lexeme(source.data() + startPos, position - startPos);
+    return makeToken(classifyIdentifier(lexeme), startPos, startLine);
 }
 
 Token Lexer::scanNumber() {
-    int startPos = position;
-    int startColumn = column;
-    int startLine = line;
+    uint32_t startPos = position;
+    uint32_t startLine = line;
     
     if (peek() == '-') {
         advance();
@@ -159,37 +162,12 @@ Token Lexer::scanNumber() {
         advance();
     }
     
-    std::string lexeme = source.substr(startPos, position - startPos);
-    return Token(TokenType::NUMBER, lexeme, startLine, startColumn);
+    return makeToken(TokenType::NUMBER, startPos, startLine);
 }
 
 // ==================== 辅助方法 ====================
 
-void Lexer::initOperators() {
-    operators["="] = TokenType::ASSIGN;
-    operators["+"] = TokenType::PLUS;
-    operators["-"] = TokenType::MINUS;
-    operators["*"] = TokenType::MULTIPLY;
-    operators["/"] = TokenType::DIVIDE;
-    operators["%"] = TokenType::MODULO;
-    operators["<"] = TokenType::LT;
-    operators[">"] = TokenType::GT;
-    operators["<="] = TokenType::LE;
-    operators[">="] = TokenType::GE;
-    operators["=="] = TokenType::EQ;
-    operators["!="] = TokenType::NEQ;
-    operators["&&"] = TokenType::AND;
-    operators["||"] = TokenType::OR;
-    operators["!"] = TokenType::NOT;
-    operators["("] = TokenType::LPAREN;
-    operators[")"] = TokenType::RPAREN;
-    operators["{"] = TokenType::LBRACE;
-    operators["}"] = TokenType::RBRACE;
-    operators[";"] = TokenType::SEMICOLON;
-    operators[","] = TokenType::COMMA;
-}
-
-char Lexer::peek(int offset) const {
+char Lexer::peek(uint32_t offset) const {
     if (position + offset >= source.length()) {
         return '\0';
     }
@@ -201,9 +179,6 @@ char Lexer::advance() {
     
     if (current == '\n') {
         line++;
-        column = 1;
-    } else {
-        column++;
     }
     
     return current;
@@ -214,93 +189,47 @@ bool Lexer::isAtEnd() const {
 }
 
 void Lexer::skipWhitespace() {
+    const char* begin = source.data();
+    const char* end = begin + source.size();
+
     while (!isAtEnd()) {
-        char c = peek();
-        
-        switch (c) {
-            case ' ':
-            case '\t':
-            case '\r':
-                advance();
-                break;
-            case '\n':
-                advance();
-                break;
-            case '/':
-                if (peek(1) == '/' || peek(1) == '*') {
-                    skipComment();
-                } else {
-                    return;
-                }
-                break;
-            default:
-                return;
+        // 紧凑代码里标记之间常常没有空白，先做一次标量判断再进入向量内核
+        char c = source[position];
+        if (!isScanWhitespace(c) && c != '/') {
+            return;
+        }
+
+        ScanResult run = scanWhitespaceRun(begin + position, end);
+        position = static_cast<uint32_t>(run.stop - begin);
+        line += run.newlines;
+
+        if (peek() == '/' && (peek(1) == '/' || peek(1) == '*')) {
+            skipComment();
+        } else {
+            return;
         }
     }
 }
 
 void Lexer::skipComment() {
-    char c = peek();
+    const char* begin = source.data();
+    const char* end = begin + source.size();
     
-    if (c == '/') {
+    if (peek() == '/') {
         if (peek(1) == '/') {
-            position += 2;
-            column += 2;
-            
-            while (!isAtEnd() && peek() != '\n') {
-                advance();
-            }
+            // 停在换行符上，由 skipWhitespace 负责计数
+            position = static_cast<uint32_t>(scanLineEnd(begin + position + 2, end) - begin);
         } else if (peek(1) == '*') {
-            position += 2;
-            column += 2;
-            
-            while (!isAtEnd()) {
-                if (peek() == '*' && peek(1) == '/') {
-                    position += 2;
-                    column += 2;
-                    break;
-                }
-                if (peek() == '\n') {
-                    line++;
-                    column = 1;
-                    position++;
-                } else {
-                    position++;
-                    column++;
-                }
+            ScanResult run = scanBlockCommentEnd(begin + position + 2, end);
+            line += run.newlines;
+            position = static_cast<uint32_t>(run.stop - begin);
+            if (!isAtEnd()) {
+                position += 2;
             }
         }
     }
 }
 
-Token Lexer::readOperatorOrPunctuator() {
-    int start = position;
-    int startLine = line;
-    int startColumn = column;
-
-    char c = peek();
-    position++;
-    column++;
-
-    if (position < source.length()) {
-        char next = peek();
-        std::string twoCharOp = std::string(1, c) + next;
-        
-        if (operators.find(twoCharOp) != operators.end()) {
-            position++;
-            column++;
-            return Token(operators.at(twoCharOp), twoCharOp, startLine, startColumn);
-        }
-    }
-
-    std::string singleCharOp = std::string(1, c);
-    if (operators.find(singleCharOp) != operators.end()) {
-        return Token(operators.at(singleCharOp), singleCharOp, startLine, startColumn);
-    }
-
-    return Token(TokenType::UNKNOWN, singleCharOp, startLine, startColumn);
-}
-
 // ==================== 公共接口 ====================
 
 Token Lexer::nextToken() {
@@ -308,7 +237,7 @@ Token Lexer::nextToken() {
         skipWhitespace();
         
         if (isAtEnd()) {
-            return Token(TokenType::END_OF_FILE, "", line, column);
+            return makeToken(TokenType::END_OF_FILE, position, line);
         }
         
         return scanToken();
@@ -316,15 +245,13 @@ Token Lexer::nextToken() {
 }
 
 Token Lexer::peekToken() {
-    int savedPosition = position;
-    int savedLine = line;
-    int savedColumn = column;
+    uint32_t savedPosition = position;
+    uint32_t savedLine = line;
 
     Token token = nextToken();
 
     position = savedPosition;
     line = savedLine;
-    column = savedColumn;
 
     return token;
 }
@@ -332,4 +259,4 @@ Token Lexer::peekToken() {
 std::vector<Token> Lexer::tokenize(const std::string& source) {
     Lexer lexer(source);
     return lexer.tokenize();
-}
\ No newline at end of file
+}
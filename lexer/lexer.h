@@ -1,12 +1,13 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 
 // 标记类型枚举 - 定义了所有可能的标记类型
-enum class TokenType {
+enum class TokenType : uint8_t {
     // 关键字
-    INT, VOID, IF, ELSE, WHILE, BREAK, CONTINUE, RETURN,
+    INT, VOID, IF, ELSE, WHILE, BREAK, CONTINUE, RETURN, CONST,
     
     // 标识符和字面量
     IDENTIFIER, NUMBER,
@@ -25,49 +26,72 @@ enum class TokenType {
 };
 
 // 标记结构体 - 表示源代码中的一个词法单元
+// 只记录词素在源码中的位置，不复制文本；列号通过 LineTable 按需计算
 struct Token {
     TokenType type;
-    std::string lexeme;
-    int line;
-    int column;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t line;
     
-    Token(TokenType type, const std::string& lexeme, int line, int column)
-        : type(type), lexeme(lexeme), line(line), column(column) {}
+    Token(TokenType type, uint32_t offset, uint32_t length, uint32_t line)
+        : type(type), offset(offset), length(length), line(line) {}
+
+    std::string_view lexeme(std::string_view source) const {
+        return source.substr(offset, length);
+    }
+};
+
+static_assert(sizeof(Token) == 16, "Token should stay compact");
+
+// 行首偏移表 - 第一次查询列号时才扫描源码建立
+class LineTable {
+private:
+    std::string_view source;
+    mutable std::vector<uint32_t> lineStarts;
+
+    void build() const;
+
+public:
+    explicit LineTable(std::string_view source) : source(source) {}
+
+    int columnOf(const Token& token) const;
 };
 
 // Lexer类 - 负责将源代码字符串分解为标记序列
 class Lexer {
 private:
     std::string source;
-    int position = 0;
-    int line = 1;
-    int column = 1;
-    
-    std::unordered_map<std::string, TokenType> keywords;
-    std::unordered_map<std::string, TokenType> operators;
+    uint32_t position = 0;
+    uint32_t line = 1;
+    LineTable lineTable;
 
-    void initOperators();
-    char peek(int offset = 0) const;
+    char peek(uint32_t offset = 0) const;
     char advance();
     bool isAtEnd() const;
     void skipWhitespace();
     void skipComment();
     
+    Token makeToken(TokenType type, uint32_t start, uint32_t startLine) const;
     Token scanToken();
     Token scanIdentifier();
     Token scanNumber();
-    Token readOperatorOrPunctuator();
 
 public:
     Lexer();
     Lexer(const std::string& source);
+
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
     
     int getLine() const { return line; }
-    int getColumn() const { return column; }
+    std::string_view getSource() const { return source; }
+
+    std::string_view lexeme(const Token& token) const { return token.lexeme(source); }
+    int columnOf(const Token& token) const { return lineTable.columnOf(token); }
     
     Token nextToken();
     Token peekToken();
     
     std::vector<Token> tokenize();
     std::vector<Token> tokenize(const std::string& source);
-};
\ No newline at end of file
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ==================== 词法扫描内核 ====================
+//
+// 一次对 16/32 字节分类，找出空白串、标识符串的结尾以及块注释的 "*/"，
+// 并用 popcount 统计跨过的换行数。按编译目标选择 AVX2 / SSE2，
+// 否则退回逐字节的标量实现。尾部不足一个向量宽度的字节统一走标量路径，
+// 因此不会越过 end 读取内存。
+
+struct ScanResult {
+    const char* stop;    // 第一个不属于该串的位置（或 end）
+    uint32_t newlines;   // [begin, stop) 内的换行数
+};
+
+inline bool isScanWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isScanIdentChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+#if defined(__AVX2__)
+struct ScanVec {
+    static constexpr size_t width = 32;
+    __m256i v;
+
+    static ScanVec load(const char* p) { return {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))}; }
+    uint32_t eq(char c) const { return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)))); }
+    // 有符号比较：>= 0x80 的字节为负数，自然落在所有 ASCII 区间之外
+    uint32_t inRange(char lo, char hi) const {
+        __m256i ge = _mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1)));
+        __m256i le = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v);
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(ge, le)));
+    }
+    static constexpr uint32_t allOnes = 0xFFFFFFFFu;
+};
+#else
+struct ScanVec {
+    static constexpr size_t width = 16;
+    __m128i v;
+
+    static ScanVec load(const char* p) { return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))}; }
+    uint32_t eq(char c) const { return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)))); }
+    // 有符号比较：>= 0x80 的字节为负数，自然落在所有 ASCII 区间之外
+    uint32_t inRange(char lo, char hi) const {
+        __m128i ge = _mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1)));
+        __m128i le = _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(hi + 1)), v);
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(ge, le)));
+    }
+    static constexpr uint32_t allOnes = 0xFFFFu;
+};
+#endif
+
+// 低于第 index 位的掩码
+inline uint32_t scanMaskBelow(unsigned index) {
+    return index >= 32 ? 0xFFFFFFFFu : ((1u << index) - 1);
+}
+
+inline ScanResult scanWhitespaceRun(const char* p, const char* end) {
+    uint32_t newlines = 0;
+    while (static_cast<size_t>(end - p) >= ScanVec::width) {
+        ScanVec chunk = ScanVec::load(p);
+        uint32_t nl = chunk.eq('\n');
+        uint32_t ws = nl | chunk.eq(' ') | chunk.eq('\t') | chunk.eq('\r');
+        uint32_t other = ~ws & ScanVec::allOnes;
+        if (other) {
+            unsigned index = __builtin_ctz(other);
+            newlines += __builtin_popcount(nl & scanMaskBelow(index));
+            return {p + index, newlines};
+        }
+        newlines += __builtin_popcount(nl);
+        p += ScanVec::width;
+    }
+    for (; p < end && isScanWhitespace(*p); ++p) {
+        newlines += (*p == '\n');
+    }
+    return {p, newlines};
+}
+
+inline const char* scanIdentifierRun(const char* p, const char* end) {
+    while (static_cast<size_t>(end - p) >= ScanVec::width) {
+        ScanVec chunk = ScanVec::load(p);
+        uint32_t ident = chunk.inRange('a', 'z') | chunk.inRange('A', 'Z') |
+                         chunk.inRange('0', '9') | chunk.eq('_');
+        uint32_t other = ~ident & ScanVec::allOnes;
+        if (other) {
+            return p + __builtin_ctz(other);
+        }
+        p += ScanVec::width;
+    }
+    while (p < end && isScanIdentChar(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// 从 p 开始查找块注释结尾 "*/"；stop 指向 '*'，找不到时为 end
+inline ScanResult scanBlockCommentEnd(const char* p, const char* end) {
+    uint32_t newlines = 0;
+    // 需要同时读取 p 与 p+1 两个向量
+    while (static_cast<size_t>(end - p) >= ScanVec::width + 1) {
+        ScanVec chunk = ScanVec::load(p);
+        ScanVec next = ScanVec::load(p + 1);
+        uint32_t nl = chunk.eq('\n');
+        uint32_t close = chunk.eq('*') & next.eq('/');
+        if (close) {
+            unsigned index = __builtin_ctz(close);
+            newlines += __builtin_popcount(nl & scanMaskBelow(index));
+            return {p + index, newlines};
+        }
+        newlines += __builtin_popcount(nl);
+        p += ScanVec::width;
+    }
+    for (; p < end; ++p) {
+        if (*p == '*' && p + 1 < end && p[1] == '/') {
+            return {p, newlines};
+        }
+        newlines += (*p == '\n');
+    }
+    return {end, newlines};
+}
+
+#else
+
+inline ScanResult scanWhitespaceRun(const char* p, const char* end) {
+    uint32_t newlines = 0;
+    for (; p < end && isScanWhitespace(*p); ++p) {
+        newlines += (*p == '\n');
+    }
+    return {p, newlines};
+}
+
+inline const char* scanIdentifierRun(const char* p, const char* end) {
+    while (p < end && isScanIdentChar(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+inline ScanResult scanBlockCommentEnd(const char* p, const char* end) {
+    uint32_t newlines = 0;
+    for (; p < end; ++p) {
+        if (*p == '*' && p + 1 < end && p[1] == '/') {
+            return {p, newlines};
+        }
+        newlines += (*p == '\n');
+    }
+    return {end, newlines};
+}
+
+#endif
+
+// 行注释只需找下一个换行，libc 的 memchr 本身已经向量化
+inline const char* scanLineEnd(const char* p, const char* end) {
+    const void* hit = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return hit ? static_cast<const char*>(hit) : end;
+}
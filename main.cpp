@@ -1,88 +1,287 @@
 // main.cpp - 编译器主程序
-#include "parser/ast.h"
-#include "semantic/semantic.h"
-#include "ir/ir.h"
-#include "ir/irgen.h"
-#include "codegen/codegen.h"
+#include "parser/parse_context.h"
+#include "driver/driver.h"
+#include "driver/disk_cache.h"
+#include "driver/server.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <cstdio>
+#include <thread>
+#include <vector>
 
-// Declare external parser function and root
-extern int yyparse();
-extern std::shared_ptr<CompUnit> root;
-extern FILE* yyin;
+// 用法:
+//   toyc_compiler [options] [file] [-o out.s]            单文件，汇编输出到 stdout 或 out.s
+//   toyc_compiler [options] [-j N] a.tc b.tc ... -o dir/  批量编译，每个输入生成 dir/<stem>.s
+//   toyc_compiler --server [-j N] [--socket path]       常驻编译服务器
+//   toyc_compiler --server-stop [--socket path]         停止服务器
+// options: -O0/-O1/-O2/-O3/-Os 优化级别（-opt 即 -O2），-passes=a,b,... 指定 IR 优化序列，
+//          -regalloc=naive|linear|graph|ssa|auto 指定寄存器分配，-print-ir 把 IR 打印到 stderr，
+//          -stats 把每个函数的规模、耗时和编译预算降级打印到 stderr
+// toyc_compiler_opt 与 toyc_compiler 相同，只是默认 -O2
+// 单文件模式会先把请求转发给当前用户正在运行的服务器（其他用户的服务器一律忽略），--no-server 关闭此行为
+// --cache-dir DIR（或环境变量 TOYC_CACHE_DIR）启用磁盘结果缓存，--no-cache 关闭
+// --stream 单文件流式编译：逐个函数生成并立即输出，不经过服务器和整份文件缓存
+// --pipeline 同 --stream，但解析、分析、IR 生成、优化、输出各占一个线程并行推进
+// -emit-ir out.ir       只运行前端和 IR 优化，把 IR 以文本格式写入 out.ir（toyc_opt / toyc_llc 的输入）
+// -emit-ir-bin out.tcir 只运行前端和 IR 优化，把 IR 以二进制格式写入 out.tcir
+// -from-ir-bin in.tcir  跳过前端，从二进制 IR 生成汇编
+
+// 把结果写入 outputPath，为空时写到 stdout
+static int writeOutput(const std::string& outputPath, const std::string& text) {
+    if (outputPath.empty()) {
+        std::cout << text;
+        return 0;
+    }
+    std::ofstream output(outputPath, std::ios::binary);
+    if (!output) {
+        std::cerr << "Error: Cannot open file " << outputPath << " for writing" << std::endl;
+        return 1;
+    }
+    output << text;
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
-    bool enableOptimization = false;
-    bool enablePrintIR = false;
-    
-    std::string filename;
+    CompileOptions options;
+#ifdef ENABLE_OPTIMIZATION
+    // toyc_compiler_opt：默认 -O2 的 toyc_compiler
+    options.optLevel = OptLevel::O2;
+#endif
+    std::vector<std::string> inputs;
+    std::string outputPath;
+    unsigned jobs = 0;
+    bool batchMode = false;
+    bool jobsGiven = false;
+    bool serverMode = false;
+    bool stopServerMode = false;
+    bool useServer = true;
+    std::string socketPath = defaultServerSocketPath();
+    std::string cacheDir;
+    bool useCache = true;
+    bool streamMode = false;
+    bool pipelineMode = false;
+    std::string irTextOutput;
+    std::string irBinaryOutput;
+    std::string irBinaryInput;
+    if (const char* env = std::getenv("TOYC_CACHE_DIR")) {
+        cacheDir = env;
+    }
     
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
-        if (arg == "-opt") {
-            enableOptimization = true;
-            std::cerr << "Optimization enabled." << std::endl;
+        OptionParse parsed = parseCompileOption(arg, options, std::cerr);
+        if (parsed == OptionParse::INVALID) {
+            return 1;
+        }
+        if (parsed == OptionParse::ACCEPTED) {
+            if (arg == "-opt") {
+                std::cerr << "Optimization enabled." << std::endl;
+            }
+            continue;
+        }
+
+        if (arg == "-j" || arg.rfind("-j", 0) == 0) {
+            std::string value = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : "");
+            try {
+                jobs = static_cast<unsigned>(std::stoul(value));
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid job count '" << value << "'" << std::endl;
+                return 1;
+            }
+            jobsGiven = true;
+        } else if (arg == "-o") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: Missing path after -o" << std::endl;
+                return 1;
+            }
+            outputPath = argv[++i];
+        } else if (arg == "--server") {
+            serverMode = true;
+        } else if (arg == "--server-stop") {
+            stopServerMode = true;
+        } else if (arg == "--no-server") {
+            useServer = false;
+        } else if (arg == "--cache-dir") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: Missing path after --cache-dir" << std::endl;
+                return 1;
+            }
+            cacheDir = argv[++i];
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg == "--stream") {
+            streamMode = true;
+        } else if (arg == "--pipeline") {
+            pipelineMode = true;
+        } else if (arg == "-emit-ir") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: Missing path after " << arg << std::endl;
+                return 1;
+            }
+            irTextOutput = argv[++i];
+        } else if (arg == "-emit-ir-bin" || arg == "-from-ir-bin") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: Missing path after " << arg << std::endl;
+                return 1;
+            }
+            (arg == "-emit-ir-bin" ? irBinaryOutput : irBinaryInput) = argv[++i];
+        } else if (arg == "--socket") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: Missing path after --socket" << std::endl;
+                return 1;
+            }
+            socketPath = argv[++i];
         } else {
-            filename = arg;
+            inputs.push_back(arg);
         }
     }
-    
-    if (!filename.empty()) {
-        yyin = fopen(filename.c_str(), "r");
-        if (!yyin) {
-            std::cerr << "Error: Cannot open file " << filename << std::endl;
-            return 1;
+
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::unique_ptr<DiskCache> cache;
+    if (useCache && !cacheDir.empty() && !stopServerMode) {
+        uint64_t capacityMB = 256;
+        if (const char* env = std::getenv("TOYC_CACHE_SIZE_MB")) {
+            capacityMB = std::strtoull(env, nullptr, 10);
         }
-    } else {
-        yyin = stdin;
+        // 缓存不可用只影响速度，打印警告后照常编译
+        cache = DiskCache::open(cacheDir, capacityMB * 1024 * 1024, std::cerr);
+        options.cache = cache.get();
     }
-    
-    if (yyparse() != 0) {
-        std::cerr << "Error: Parsing failed." << std::endl;
-        return 1;
+
+    if (serverMode) {
+        return runServer(socketPath, jobs, cache.get());
     }
-    
-    if (!root) {
-        std::cerr << "Error: Parsing failed (no AST generated)." << std::endl;
-        return 1;
+    if (stopServerMode) {
+        if (!stopServer(socketPath)) {
+            std::cerr << "Error: No server listening on " << socketPath << std::endl;
+            return 1;
+        }
+        return 0;
     }
-    
-    SemanticAnalyzer semanticAnalyzer;
-    if (!semanticAnalyzer.analyze(root)) {
-        std::cerr << "Error: Semantic analysis failed." << std::endl;
-        return 1;
+
+    if (!irBinaryInput.empty()) {
+        std::stringstream outputStream;
+        if (!compileIRBinary(irBinaryInput, options, outputStream, std::cerr)) {
+            return 1;
+        }
+        return writeOutput(outputPath, outputStream.str());
     }
 
-    IRGenConfig irConfig;
-    if (enableOptimization) {
-        irConfig.enableOptimizations = true;
+    // 多个输入、给了 -j、或 -o 指向目录时进入批量模式
+    if (inputs.size() > 1 || jobsGiven) {
+        batchMode = true;
+    } else if (!outputPath.empty() &&
+               (outputPath.back() == '/' || std::filesystem::is_directory(outputPath))) {
+        batchMode = true;
     }
-    
-    IRGenerator irGenerator(irConfig);
-    irGenerator.generate(root);
-    
-    if (enablePrintIR) {
-        IRPrinter::print(irGenerator.getInstructions(), std::cerr);
+
+    if (batchMode) {
+        if (inputs.empty()) {
+            std::cerr << "Error: No input files" << std::endl;
+            return 1;
+        }
+        if (outputPath.empty()) {
+            std::cerr << "Error: Batch mode requires -o <outdir>" << std::endl;
+            return 1;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(outputPath, ec);
+        if (ec) {
+            std::cerr << "Error: Cannot create output directory " << outputPath << std::endl;
+            return 1;
+        }
+
+        std::vector<BatchJob> batch;
+        std::vector<std::string> seen;
+        for (const auto& input : inputs) {
+            std::string output = batchOutputPath(input, outputPath);
+            for (const auto& other : seen) {
+                if (other == output) {
+                    std::cerr << "Error: Inputs map to the same output file " << output << std::endl;
+                    return 1;
+                }
+            }
+            seen.push_back(output);
+            batch.push_back({input, output});
+        }
+
+        int failures = compileBatch(batch, options, jobs, std::cerr);
+        return failures == 0 ? 0 : 1;
     }
     
-    CodeGenConfig config;
-    if (enableOptimization) {
-        config.regAllocStrategy = RegisterAllocStrategy::LINEAR_SCAN;
-        config.optimizeStackLayout = true;
-        config.eliminateDeadStores = true;
-        config.enablePeepholeOptimizations = true;
+    std::stringstream source;
+    if (!inputs.empty()) {
+        std::ifstream input(inputs.front(), std::ios::binary);
+        if (!input) {
+            std::cerr << "Error: Cannot open file " << inputs.front() << std::endl;
+            return 1;
+        }
+        source << input.rdbuf();
+    } else {
+        source << std::cin.rdbuf();
     }
     
+    if (!irTextOutput.empty()) {
+        ParseContext parseContext;
+        std::ostringstream text;
+        if (!emitIRText(parseContext, source.str(), options, text, std::cerr)) {
+            return 1;
+        }
+        return writeOutput(irTextOutput, text.str());
+    }
+
+    if (!irBinaryOutput.empty()) {
+        ParseContext parseContext;
+        std::ostringstream binary;
+        if (!emitIRBinary(parseContext, source.str(), options, binary, std::cerr)) {
+            return 1;
+        }
+        return writeOutput(irBinaryOutput, binary.str());
+    }
+
+    if (streamMode || pipelineMode) {
+        auto compile = pipelineMode ? compilePipelined : compileStreaming;
+        ParseContext parseContext;
+        if (outputPath.empty()) {
+            return compile(parseContext, source.str(), options, std::cout, std::cerr) ? 0 : 1;
+        }
+        std::ofstream output(outputPath, std::ios::binary);
+        if (!output) {
+            std::cerr << "Error: Cannot open file " << outputPath << " for writing" << std::endl;
+            return 1;
+        }
+        bool ok = compile(parseContext, source.str(), options, output, std::cerr);
+        output.close();
+        if (!ok) {
+            // 不留下只写了一半的汇编文件
+            std::filesystem::remove(outputPath);
+            return 1;
+        }
+        return 0;
+    }
+
     std::stringstream outputStream;
+    ServerReply reply;
+    if (useServer && compileViaServer(socketPath, source.str(), options, reply)) {
+        std::cerr << reply.diagnostics;
+        if (!reply.ok) {
+            return 1;
+        }
+        outputStream << reply.assembly;
+    } else {
+        ParseContext parseContext;
+        if (!compileSource(parseContext, source.str(), options, outputStream, std::cerr)) {
+            return 1;
+        }
+    }
     
-    CodeGenerator generator(outputStream, irGenerator.getInstructions(), config);
-    generator.generate();
-    
-    std::cout << outputStream.str();
-    
-    return 0;
-}
\ No newline at end of file
+    return writeOutput(outputPath, outputStream.str());
+}
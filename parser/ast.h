@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
 
 // ==================== AST节点基类 ====================
 
@@ -46,7 +47,7 @@ class VariableExpr : public Expr {
 public:
     std::string name;
     
-    VariableExpr(const std::string& name, int line = 0, int column = 0) : name(name) {
+    VariableExpr(std::string name, int line = 0, int column = 0) : name(std::move(name)) {
         this->line = line;
         this->column = column;
     }
@@ -59,9 +60,9 @@ public:
     std::string op;
     std::shared_ptr<Expr> right;
     
-    BinaryExpr(std::shared_ptr<Expr> left, const std::string& op, std::shared_ptr<Expr> right,
+    BinaryExpr(std::shared_ptr<Expr> left, std::string op, std::shared_ptr<Expr> right,
               int line = 0, int column = 0)
-        : left(left), op(op), right(right) {
+        : left(std::move(left)), op(std::move(op)), right(std::move(right)) {
         this->line = line;
         this->column = column;
     }
@@ -73,9 +74,9 @@ public:
     std::string op;
     std::shared_ptr<Expr> operand;
     
-    UnaryExpr(const std::string& op, std::shared_ptr<Expr> operand,
+    UnaryExpr(std::string op, std::shared_ptr<Expr> operand,
              int line = 0, int column = 0)
-        : op(op), operand(operand) {
+        : op(std::move(op)), operand(std::move(operand)) {
         this->line = line;
         this->column = column;
     }
@@ -87,9 +88,9 @@ public:
     std::string callee;
     std::vector<std::shared_ptr<Expr>> arguments;
     
-    CallExpr(const std::string& callee, const std::vector<std::shared_ptr<Expr>>& arguments,
+    CallExpr(std::string callee, std::vector<std::shared_ptr<Expr>> arguments,
             int line = 0, int column = 0)
-        : callee(callee), arguments(arguments) {
+        : callee(std::move(callee)), arguments(std::move(arguments)) {
         this->line = line;
         this->column = column;
     }
@@ -101,7 +102,7 @@ public:
     std::shared_ptr<Expr> expression;
     
     ExprStmt(std::shared_ptr<Expr> expression, int line = 0, int column = 0)
-        : expression(expression) {
+        : expression(std::move(expression)) {
         this->line = line;
         this->column = column;
     }
@@ -112,10 +113,11 @@ class VarDeclStmt : public Stmt {
 public:
     std::string name;
     std::shared_ptr<Expr> initializer;
+    bool isConst = false;   // const int：不可赋值，初值是常量时按立即数处理
     
-    VarDeclStmt(const std::string& name, std::shared_ptr<Expr> initializer,
+    VarDeclStmt(std::string name, std::shared_ptr<Expr> initializer,
                int line = 0, int column = 0)
-        : name(name), initializer(initializer) {
+        : name(std::move(name)), initializer(std::move(initializer)) {
         this->line = line;
         this->column = column;
     }
@@ -127,9 +129,9 @@ public:
     std::string name;
     std::shared_ptr<Expr> value;
     
-    AssignStmt(const std::string& name, std::shared_ptr<Expr> value,
+    AssignStmt(std::string name, std::shared_ptr<Expr> value,
               int line = 0, int column = 0)
-        : name(name), value(value) {
+        : name(std::move(name)), value(std::move(value)) {
         this->line = line;
         this->column = column;
     }
@@ -140,9 +142,9 @@ class BlockStmt : public Stmt {
 public:
     std::vector<std::shared_ptr<Stmt>> statements;
     
-    BlockStmt(const std::vector<std::shared_ptr<Stmt>>& statements,
+    BlockStmt(std::vector<std::shared_ptr<Stmt>> statements,
              int line = 0, int column = 0)
-        : statements(statements) {
+        : statements(std::move(statements)) {
         this->line = line;
         this->column = column;
     }
@@ -157,7 +159,7 @@ public:
     
     IfStmt(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> thenBranch, std::shared_ptr<Stmt> elseBranch,
           int line = 0, int column = 0)
-        : condition(condition), thenBranch(thenBranch), elseBranch(elseBranch) {
+        : condition(std::move(condition)), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch)) {
         this->line = line;
         this->column = column;
     }
@@ -171,7 +173,7 @@ public:
     
     WhileStmt(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> body,
              int line = 0, int column = 0)
-        : condition(condition), body(body) {
+        : condition(std::move(condition)), body(std::move(body)) {
         this->line = line;
         this->column = column;
     }
@@ -201,7 +203,7 @@ public:
     std::shared_ptr<Expr> value;
     
     ReturnStmt(std::shared_ptr<Expr> value, int line = 0, int column = 0)
-        : value(value) {
+        : value(std::move(value)) {
         this->line = line;
         this->column = column;
     }
@@ -214,8 +216,8 @@ public:
     int line = 0;
     int column = 0;
     
-    Param(const std::string& name, int line = 0, int column = 0)
-        : name(name), line(line), column(column) {}
+    Param(std::string name, int line = 0, int column = 0)
+        : name(std::move(name)), line(line), column(column) {}
 };
 
 class FunctionDef : public ASTNode {
@@ -225,10 +227,10 @@ public:
     std::vector<Param> params;
     std::shared_ptr<BlockStmt> body;
     
-    FunctionDef(const std::string& returnType, const std::string& name, 
-               const std::vector<Param>& params, std::shared_ptr<BlockStmt> body,
+    FunctionDef(std::string returnType, std::string name, 
+               std::vector<Param> params, std::shared_ptr<BlockStmt> body,
                int line = 0, int column = 0)
-        : returnType(returnType), name(name), params(params), body(body) {
+        : returnType(std::move(returnType)), name(std::move(name)), params(std::move(params)), body(std::move(body)) {
         this->line = line;
         this->column = column;
     }
@@ -239,9 +241,9 @@ class CompUnit : public ASTNode {
 public:
     std::vector<std::shared_ptr<FunctionDef>> functions;
     
-    CompUnit(const std::vector<std::shared_ptr<FunctionDef>>& functions,
+    CompUnit(std::vector<std::shared_ptr<FunctionDef>> functions,
             int line = 0, int column = 0)
-        : functions(functions) {
+        : functions(std::move(functions)) {
         this->line = line;
         this->column = column;
     }
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// ==================== AST 内存池 ====================
+
+/**
+ * 解析期间 AST 节点使用的单调分配区。
+ *
+ * 节点先从自有缓冲中切分，缓冲用完才向系统申请。reset() 一次性回收本轮
+ * 的全部节点，并按本轮溢出的字节数扩大缓冲，因此反复解析相近规模的
+ * 输入时，热身之后不再产生任何系统分配。
+ */
+class AstArena {
+private:
+    // 记录溢出到上游的字节数，用于下一轮扩大缓冲
+    class CountingUpstream : public std::pmr::memory_resource {
+    public:
+        size_t overflowBytes = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            overflowBytes += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::unique_ptr<std::byte[]> buffer;
+    size_t capacity;
+    CountingUpstream upstream;
+    std::optional<std::pmr::monotonic_buffer_resource> resource;
+
+public:
+    explicit AstArena(size_t initialBytes)
+        : buffer(new std::byte[initialBytes]), capacity(initialBytes) {
+        resource.emplace(buffer.get(), capacity, &upstream);
+    }
+
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    std::pmr::memory_resource* get() { return &*resource; }
+    size_t getCapacity() const { return capacity; }
+
+    // 调用前必须保证本轮分配的节点都已不再被引用
+    void reset() {
+        resource.reset();
+        if (upstream.overflowBytes > 0) {
+            capacity += upstream.overflowBytes;
+            buffer.reset(new std::byte[capacity]);
+            upstream.overflowBytes = 0;
+        }
+        resource.emplace(buffer.get(), capacity, &upstream);
+    }
+};
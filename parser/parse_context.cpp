@@ -0,0 +1,91 @@
+#include "parse_context.h"
+#include "parser.hpp"
+#include <iostream>
+
+// Flex reentrant 扫描器接口（定义在生成的 lexer.cpp 中）
+struct yy_buffer_state;
+int yylex_init_extra(ParseContext* extra, yyscan_t* scanner);
+int yylex_destroy(yyscan_t scanner);
+void yyrestart(FILE* in, yyscan_t scanner);
+int yyget_lineno(yyscan_t scanner);
+void yyset_lineno(int line, yyscan_t scanner);
+yy_buffer_state* yy_scan_bytes(const char* bytes, int len, yyscan_t scanner);
+void yy_delete_buffer(yy_buffer_state* buffer, yyscan_t scanner);
+
+// 首块 arena 的大小，足以容纳中等规模源文件的全部 AST 节点
+static constexpr size_t kInitialArenaBytes = 64 * 1024;
+
+// ==================== 构造与析构 ====================
+
+ParseContext::ParseContext() : arena(kInitialArenaBytes) {
+    yylex_init_extra(this, &scanner);
+}
+
+ParseContext::~ParseContext() {
+    if (scanner) {
+        yylex_destroy(scanner);
+    }
+}
+
+// ==================== 解析入口 ====================
+
+bool ParseContext::parseFile(FILE* in) {
+    reset();
+    yyrestart(in ? in : stdin, scanner);
+    return runParser();
+}
+
+bool ParseContext::parseString(const std::string& source) {
+    reset();
+    yy_buffer_state* buffer = yy_scan_bytes(source.data(), static_cast<int>(source.size()), scanner);
+    bool ok = runParser();
+    yy_delete_buffer(buffer, scanner);
+    return ok;
+}
+
+void ParseContext::reset() {
+    root.reset();
+    arena.reset();
+    errorCount = 0;
+}
+
+bool ParseContext::runParser() {
+    yyset_lineno(1, scanner);
+    yy::parser parser(scanner, *this);
+    if (parser.parse() != 0 || errorCount > 0) {
+        return false;
+    }
+    return root != nullptr;
+}
+
+// ==================== 语法动作辅助 ====================
+
+void ParseContext::addFunction(std::vector<std::shared_ptr<FunctionDef>>& functions,
+                               std::shared_ptr<FunctionDef> func) {
+    if (!functionSink) {
+        functions.push_back(std::move(func));
+        return;
+    }
+    // 已经出错的输入不会生成代码，不再交出后续函数
+    if (errorCount > 0) {
+        return;
+    }
+    functionSink(std::move(func));
+    // 此时 arena 中没有任何节点仍被引用（func_list 为空，栈上只剩终结符的值）
+    if (!retainNodes) {
+        arena.reset();
+    }
+}
+
+int ParseContext::currentLine() const {
+    return yyget_lineno(scanner);
+}
+
+void ParseContext::reportError(const std::string& message) {
+    errorCount++;
+    *diagnostics << "Error: " << message << " at line " << currentLine() << std::endl;
+}
+
+void ParseContext::reportUnknownCharacter(std::string_view text) {
+    *diagnostics << "Unknown character: " << text << std::endl;
+}
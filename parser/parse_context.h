@@ -0,0 +1,99 @@
+#pragma once
+#include "parser/ast.h"
+#include "parser/ast_arena.h"
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 与 Flex 生成的扫描器共享的句柄类型（reentrant 模式）
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+// ==================== 解析上下文 ====================
+
+/**
+ * 一次解析所需的全部状态。
+ *
+ * 扫描器句柄与语法树根节点都由上下文持有，不再依赖 yyin/yylineno/root
+ * 等全局变量，因此同一进程内可以并发解析多个文件，也可以反复复用同一个
+ * 上下文解析新的输入。
+ *
+ * AST 节点分配在上下文的 arena 中，只在上下文存活且未 reset() 期间有效。
+ * 批量编译时每个工作线程复用同一个上下文，arena 的缓冲随之复用。
+ *
+ * 设置了函数接收器（流式解析）时，每归约出一个函数就立即交给接收器，
+ * 不再挂到 CompUnit 上；接收器返回后 arena 即被回收，因此解析期间的
+ * AST 内存只取决于最大的那个函数。若接收器要把函数交给其他线程继续
+ * 使用，则改从堆上分配节点，每个函数随最后一个引用释放。
+ */
+class ParseContext {
+private:
+    yyscan_t scanner = nullptr;
+    AstArena arena;
+    std::shared_ptr<CompUnit> root;
+    int errorCount = 0;
+    std::ostream* diagnostics = &std::cerr;
+    std::function<void(std::shared_ptr<FunctionDef>)> functionSink;
+    bool retainNodes = false;
+
+public:
+    using FunctionSink = std::function<void(std::shared_ptr<FunctionDef>)>;
+
+    ParseContext();
+    ~ParseContext();
+
+    ParseContext(const ParseContext&) = delete;
+    ParseContext& operator=(const ParseContext&) = delete;
+
+    // 解析入口，成功时返回 true，结果通过 getRoot() 获取
+    bool parseFile(FILE* in);
+    bool parseString(const std::string& source);
+
+    // 丢弃上一次解析的结果并回收 arena，使上下文可以解析下一个输入
+    void reset();
+
+    std::shared_ptr<CompUnit> getRoot() const { return root; }
+    int getErrorCount() const { return errorCount; }
+
+    // 诊断信息的输出位置，默认 std::cerr
+    void setDiagnostics(std::ostream& out) { diagnostics = &out; }
+    std::ostream& getDiagnostics() const { return *diagnostics; }
+
+    // 流式解析；传入空函数恢复整体解析。retain 为 false 时接收器返回后
+    // 不得再持有该函数的任何节点，为 true 时节点在堆上分配，可以一直持有
+    void setFunctionSink(FunctionSink sink, bool retain = false) {
+        functionSink = std::move(sink);
+        retainNodes = functionSink && retain;
+    }
+
+    // 以下接口供语法动作使用
+    yyscan_t getScanner() const { return scanner; }
+    int currentLine() const;
+    void setRoot(std::shared_ptr<CompUnit> unit) { root = std::move(unit); }
+    void addFunction(std::vector<std::shared_ptr<FunctionDef>>& functions,
+                     std::shared_ptr<FunctionDef> func);
+    void reportError(const std::string& message);
+    void reportUnknownCharacter(std::string_view text);
+
+    // 构造 AST 节点，通常在 arena 中
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(nodeResource()),
+                                       std::forward<Args>(args)...);
+    }
+
+private:
+    bool runParser();
+
+    std::pmr::memory_resource* nodeResource() {
+        return retainNodes ? std::pmr::new_delete_resource() : arena.get();
+    }
+};
@@ -0,0 +1,89 @@
+#include "parse_context.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include <iostream>
+
+// 手写前端版本的 ParseContext：接口与 Flex/Bison 版本一致，
+// 由 CMake 的 TOYC_FRONTEND 选项决定链接哪一个实现
+
+// 首块 arena 的大小，与 Flex/Bison 版本保持一致
+static constexpr size_t kInitialArenaBytes = 64 * 1024;
+
+// ==================== 构造与析构 ====================
+
+ParseContext::ParseContext() : arena(kInitialArenaBytes) {}
+
+ParseContext::~ParseContext() = default;
+
+// ==================== 解析入口 ====================
+
+bool ParseContext::parseFile(FILE* in) {
+    if (!in) {
+        in = stdin;
+    }
+
+    std::string source;
+    char buffer[64 * 1024];
+    size_t bytes;
+    while ((bytes = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        source.append(buffer, bytes);
+    }
+    return parseString(source);
+}
+
+bool ParseContext::parseString(const std::string& source) {
+    reset();
+
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    // 与 Flex 规则一致：未知字符只报告并跳过，不交给语法分析
+    std::erase_if(tokens, [&](const Token& token) {
+        if (token.type != TokenType::UNKNOWN) {
+            return false;
+        }
+        reportUnknownCharacter(lexer.lexeme(token));
+        return true;
+    });
+
+    Parser parser(tokens, lexer.getSource(), nodeResource(), *diagnostics);
+    if (functionSink) {
+        // 函数之间语法分析器不持有任何节点，交出后即可回收 arena
+        parser.setFunctionSink([this](std::shared_ptr<FunctionDef> func) {
+            functionSink(std::move(func));
+            if (!retainNodes) {
+                arena.reset();
+            }
+        });
+    }
+    root = parser.parse();
+    if (parser.hasError()) {
+        errorCount++;
+        return false;
+    }
+    return root != nullptr;
+}
+
+void ParseContext::reset() {
+    root.reset();
+    arena.reset();
+    errorCount = 0;
+}
+
+bool ParseContext::runParser() {
+    return root != nullptr;
+}
+
+// ==================== 语法动作辅助 ====================
+
+int ParseContext::currentLine() const {
+    return 0;
+}
+
+void ParseContext::reportError(const std::string& message) {
+    errorCount++;
+    *diagnostics << "Error: " << message << std::endl;
+}
+
+void ParseContext::reportUnknownCharacter(std::string_view text) {
+    *diagnostics << "Unknown character: " << text << std::endl;
+}
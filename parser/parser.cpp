@@ -4,14 +4,14 @@
 
 // ==================== 辅助方法 ====================
 
-Token Parser::advance() {
+const Token& Parser::advance() {
     if (!isAtEnd()) current++;
     return previous();
 }
 
 ParseError Parser::error(const Token& token, const std::string& message) {
     if (!isRecovering) {
-        std::cerr << "[Error at line " << token.line << ", column " << token.column << "] "
+        diagnostics << "[Error at line " << token.line << ", column " << columnOf(token) << "] "
                   << message << std::endl;
         errorCount++;
         hadError = true;
@@ -31,6 +31,7 @@ void Parser::synchronize() {
             
             switch (peek(0).type) {
                 case TokenType::INT:
+                case TokenType::CONST:
                 case TokenType::VOID:
                 case TokenType::IF:
                 case TokenType::ELSE:
@@ -42,6 +43,8 @@ void Parser::synchronize() {
                 case TokenType::RBRACE:
                     isRecovering = false;
                     return;
+                default:
+                    break;
             }
 
             advance();
@@ -65,12 +68,12 @@ bool Parser::match(std::initializer_list<TokenType> types) {
     return false;
 }
 
-Token Parser::consume(TokenType type, const std::string& message) {
+const Token& Parser::consume(TokenType type, const std::string& message) {
     if (check(type)) return advance();
     throw error(peek(0), message);
 }
 
-Token Parser::previous() const {
+const Token& Parser::previous() const {
     return tokens[current - 1];
 }
 
@@ -100,7 +103,7 @@ std::shared_ptr<CompUnit> Parser::compUnit() {
     std::vector<std::shared_ptr<FunctionDef>> functions;
 
     int line = peek(0).line;
-    int column = peek(0).column;
+    int column = columnOf(peek(0));
     
     while (!isAtEnd()) {
         isRecovering = false;
@@ -108,7 +111,11 @@ std::shared_ptr<CompUnit> Parser::compUnit() {
         try {
             if (check(TokenType::INT) || check(TokenType::VOID)) {
                 auto func = funcDef();
-                if (func) {
+                if (func && functionSink) {
+                    if (!hadError) {
+                        functionSink(std::move(func));
+                    }
+                } else if (func) {
                     functions.push_back(func);
                 }
             }
@@ -124,12 +131,12 @@ std::shared_ptr<CompUnit> Parser::compUnit() {
         }
     }
 
-    return std::make_shared<CompUnit>(functions, line, column);
+    return make<CompUnit>(functions, line, column);
 }
 
 std::shared_ptr<FunctionDef> Parser::funcDef() {
     int line = peek(0).line;
-    int column = peek(0).column;
+    int column = columnOf(peek(0));
     
     std::string returnTypeStr;
     if (match({ TokenType::INT })) {
@@ -150,7 +157,7 @@ std::shared_ptr<FunctionDef> Parser::funcDef() {
         synchronize();
         return nullptr;
     }
-    std::string name = nameToken.lexeme;
+    std::string name = text(nameToken);
 
     try {
         consume(TokenType::LPAREN, "Expected '(' after function name.");
@@ -185,7 +192,7 @@ std::shared_ptr<FunctionDef> Parser::funcDef() {
 
             try {
                 Token paramName = consume(TokenType::IDENTIFIER, "Expected parameter name.");
-                params.push_back(Param(paramName.lexeme));
+                params.push_back(Param(text(paramName)));
             }
             catch (const ParseError& e) {
                 synchronize();
@@ -223,30 +230,30 @@ std::shared_ptr<FunctionDef> Parser::funcDef() {
         return nullptr;
     }
 
-    return std::make_shared<FunctionDef>(returnTypeStr, name, params, body, line, column);
+    return make<FunctionDef>(returnTypeStr, name, params, body, line, column);
 }
 
 Param Parser::param() {
     int line = peek(0).line;
-    int column = peek(0).column;
+    int column = columnOf(peek(0));
 
     consume(TokenType::INT, "Parameter type must be 'int'.");
     Token name = consume(TokenType::IDENTIFIER, "Expected parameter name.");
-    return Param(name.lexeme, line, column);
+    return Param(text(name), line, column);
 }
 
 // ==================== 语句解析 ====================
 
 std::shared_ptr<BlockStmt> Parser::block() {
     int line = peek(0).line;
-    int column = peek(0).column;
+    int column = columnOf(peek(0));
     
     try {
         consume(TokenType::LBRACE, "Expected '{' before block.");
     }
     catch (const ParseError& e) {
         synchronize();
-        return std::make_shared<BlockStmt>(std::vector<std::shared_ptr<Stmt>>());
+        return make<BlockStmt>(std::vector<std::shared_ptr<Stmt>>());
     }
 
     std::vector<std::shared_ptr<Stmt>> statements;
@@ -272,12 +279,12 @@ std::shared_ptr<BlockStmt> Parser::block() {
         synchronize();
     }
 
-    return std::make_shared<BlockStmt>(statements, line, column);
+    return make<BlockStmt>(statements, line, column);
 }
 
 std::shared_ptr<Stmt> Parser::stmt() {
     if (match({TokenType::SEMICOLON})) {
-        return std::make_shared<ExprStmt>(nullptr);
+        return make<ExprStmt>(nullptr);
     }
     
     if (check(TokenType::LBRACE)) {
@@ -287,6 +294,11 @@ std::shared_ptr<Stmt> Parser::stmt() {
     if (match({TokenType::INT})) {
         return varDeclStmt();
     }
+
+    if (match({TokenType::CONST})) {
+        consume(TokenType::INT, "Expected 'int' after 'const'.");
+        return constDeclStmt();
+    }
     
     if (match({TokenType::IF})) {
         return ifStmt();
@@ -317,40 +329,56 @@ std::shared_ptr<Stmt> Parser::stmt() {
 
 std::shared_ptr<Stmt> Parser::exprStmt() {
     int line = peek(0).line;
-    int column = peek(0).column;
+    int column = columnOf(peek(0));
     
     auto expression = expr();
     consume(TokenType::SEMICOLON, "Expected ';' after expression.");
-    return std::make_shared<ExprStmt>(expression);
+    return make<ExprStmt>(expression, line, column);
 }
 
 std::shared_ptr<Stmt> Parser::varDeclStmt() {
     int line = previous().line;
-    int column = previous().column;
+    int column = columnOf(previous());
 
-    Token name = consume(TokenType::IDENTIFIER, "Expected variable name after 'int'.");
-    consume(TokenType::ASSIGN, "Expected '=' after variable name.");
-    auto initializer = expr();
+    const Token& name = consume(TokenType::IDENTIFIER, "Expected variable name after 'int'.");
+    std::shared_ptr<Expr> initializer = nullptr;
+    if (match({TokenType::ASSIGN})) {
+        initializer = expr();
+    }
     consume(TokenType::SEMICOLON, "Expected ';' after variable declaration.");
     
-    return std::make_shared<VarDeclStmt>(name.lexeme, initializer, line, column);
+    return make<VarDeclStmt>(text(name), initializer, line, column);
+}
+
+std::shared_ptr<Stmt> Parser::constDeclStmt() {
+    int line = previous().line;
+    int column = columnOf(previous());
+
+    const Token& name = consume(TokenType::IDENTIFIER, "Expected constant name after 'const int'.");
+    consume(TokenType::ASSIGN, "Expected '=' after constant name.");
+    auto initializer = expr();
+    consume(TokenType::SEMICOLON, "Expected ';' after constant declaration.");
+
+    auto decl = make<VarDeclStmt>(text(name), initializer, line, column);
+    decl->isConst = true;
+    return decl;
 }
 
 std::shared_ptr<Stmt> Parser::assignStmt() {
     int line = peek(0).line;
-    int column = peek(0).column;
+    int column = columnOf(peek(0));
 
     Token name = consume(TokenType::IDENTIFIER, "Expected variable name.");
     consume(TokenType::ASSIGN, "Expected '=' after variable name.");
     auto value = expr();
     consume(TokenType::SEMICOLON, "Expected ';' after assignment.");
     
-    return std::make_shared<AssignStmt>(name.lexeme, value, line, column);
+    return make<AssignStmt>(text(name), value, line, column);
 }
 
 std::shared_ptr<Stmt> Parser::ifStmt() {
     int line = previous().line;
-    int column = previous().column;
+    int column = columnOf(previous());
 
     consume(TokenType::LPAREN, "Expected '(' after 'if'.");
     auto condition = expr();
@@ -363,40 +391,40 @@ std::shared_ptr<Stmt> Parser::ifStmt() {
         elseBranch = stmt();
     }
     
-    return std::make_shared<IfStmt>(condition, thenBranch, elseBranch, line, column);
+    return make<IfStmt>(condition, thenBranch, elseBranch, line, column);
 }
 
 std::shared_ptr<Stmt> Parser::whileStmt() {
     int line = previous().line;
-    int column = previous().column;
+    int column = columnOf(previous());
     
     consume(TokenType::LPAREN, "Expected '(' after 'while'.");
     auto condition = expr();
     consume(TokenType::RPAREN, "Expected ')' after while condition.");
     auto body = stmt();
     
-    return std::make_shared<WhileStmt>(condition, body, line, column);
+    return make<WhileStmt>(condition, body, line, column);
 }
 
 std::shared_ptr<Stmt> Parser::breakStmt() {
     int line = previous().line;
-    int column = previous().column;
+    int column = columnOf(previous());
     
     consume(TokenType::SEMICOLON, "Expected ';' after 'break'.");
-    return std::make_shared<BreakStmt>(line, column);
+    return make<BreakStmt>(line, column);
 }
 
 std::shared_ptr<Stmt> Parser::continueStmt() {
     int line = previous().line;
-    int column = previous().column;
+    int column = columnOf(previous());
     
     consume(TokenType::SEMICOLON, "Expected ';' after 'continue'.");
-    return std::make_shared<ContinueStmt>(line, column);
+    return make<ContinueStmt>(line, column);
 }
 
 std::shared_ptr<Stmt> Parser::returnStmt() {
     int line = previous().line;
-    int column = previous().column;
+    int column = columnOf(previous());
 
     std::shared_ptr<Expr> value = nullptr;
     if (!check(TokenType::SEMICOLON)) {
@@ -404,7 +432,7 @@ std::shared_ptr<Stmt> Parser::returnStmt() {
     }
     
     consume(TokenType::SEMICOLON, "Expected ';' after return value.");
-    return std::make_shared<ReturnStmt>(value, line, column);
+    return make<ReturnStmt>(value, line, column);
 }
 
 // ==================== 表达式解析 ====================
@@ -417,21 +445,33 @@ std::shared_ptr<Expr> Parser::lorExpr() {
     auto expr = landExpr();
     
     while (match({TokenType::OR})) {
-        std::string op = previous().lexeme;
+        std::string op = text(previous());
         auto right = landExpr();
-        expr = std::make_shared<BinaryExpr>(expr, op, right);
+        expr = make<BinaryExpr>(expr, op, right);
     }
     
     return expr;
 }
 
 std::shared_ptr<Expr> Parser::landExpr() {
-    auto expr = relExpr();
+    auto expr = eqExpr();
     
     while (match({TokenType::AND})) {
-        std::string op = previous().lexeme;
+        std::string op = text(previous());
+        auto right = eqExpr();
+        expr = make<BinaryExpr>(expr, op, right);
+    }
+    
+    return expr;
+}
+
+std::shared_ptr<Expr> Parser::eqExpr() {
+    auto expr = relExpr();
+    
+    while (match({TokenType::EQ, TokenType::NEQ})) {
+        std::string op = text(previous());
         auto right = relExpr();
-        expr = std::make_shared<BinaryExpr>(expr, op, right);
+        expr = make<BinaryExpr>(expr, op, right);
     }
     
     return expr;
@@ -440,11 +480,10 @@ std::shared_ptr<Expr> Parser::landExpr() {
 std::shared_ptr<Expr> Parser::relExpr() {
     auto expr = addExpr();
     
-    while (match({TokenType::LT, TokenType::GT, TokenType::LE, 
-                 TokenType::GE, TokenType::EQ, TokenType::NEQ})) {
-        std::string op = previous().lexeme;
+    while (match({TokenType::LT, TokenType::GT, TokenType::LE, TokenType::GE})) {
+        std::string op = text(previous());
         auto right = addExpr();
-        expr = std::make_shared<BinaryExpr>(expr, op, right);
+        expr = make<BinaryExpr>(expr, op, right);
     }
     
     return expr;
@@ -454,9 +493,9 @@ std::shared_ptr<Expr> Parser::addExpr() {
     auto expr = mulExpr();
     
     while (match({TokenType::PLUS, TokenType::MINUS})) {
-        std::string op = previous().lexeme;
+        std::string op = text(previous());
         auto right = mulExpr();
-        expr = std::make_shared<BinaryExpr>(expr, op, right);
+        expr = make<BinaryExpr>(expr, op, right);
     }
     
     return expr;
@@ -466,11 +505,11 @@ std::shared_ptr<Expr> Parser::mulExpr() {
     auto expr = unaryExpr();
     
     while (match({TokenType::MULTIPLY, TokenType::DIVIDE, TokenType::MODULO})) {
-        std::string op = previous().lexeme;
+        std::string op = text(previous());
         int line = previous().line;
-        int column = previous().column;
+        int column = columnOf(previous());
         auto right = unaryExpr();
-        expr = std::make_shared<BinaryExpr>(expr, op, right, line, column);
+        expr = make<BinaryExpr>(expr, op, right, line, column);
     }
     
     return expr;
@@ -478,11 +517,11 @@ std::shared_ptr<Expr> Parser::mulExpr() {
 
 std::shared_ptr<Expr> Parser::unaryExpr() {
     if (match({TokenType::PLUS, TokenType::MINUS, TokenType::NOT})) {
-        std::string op = previous().lexeme;
+        std::string op = text(previous());
         int line = previous().line;
-        int column = previous().column;
+        int column = columnOf(previous());
         auto right = unaryExpr();
-        return std::make_shared<UnaryExpr>(op, right, line, column);
+        return make<UnaryExpr>(op, right, line, column);
     }
     
     return primaryExpr();
@@ -490,16 +529,16 @@ std::shared_ptr<Expr> Parser::unaryExpr() {
 
 std::shared_ptr<Expr> Parser::primaryExpr() {
     if (match({TokenType::NUMBER})) {
-        int value = std::stoi(previous().lexeme);
+        int value = std::stoi(text(previous()));
         int line = previous().line;
-        int column = previous().column;
-        return std::make_shared<NumberExpr>(value, line, column);
+        int column = columnOf(previous());
+        return make<NumberExpr>(value, line, column);
     }
     
     if (match({TokenType::IDENTIFIER})) {
-        std::string name = previous().lexeme;
+        std::string name = text(previous());
         int line = previous().line;
-        int column = previous().column;
+        int column = columnOf(previous());
         
         if (match({TokenType::LPAREN})) {
             std::vector<std::shared_ptr<Expr>> arguments;
@@ -512,10 +551,10 @@ std::shared_ptr<Expr> Parser::primaryExpr() {
             
             consume(TokenType::RPAREN, "Expected ')' after arguments.");
             
-            return std::make_shared<CallExpr>(name, arguments, line, column);
+            return make<CallExpr>(name, arguments, line, column);
         }
         
-        return std::make_shared<VariableExpr>(name, line, column);
+        return make<VariableExpr>(name, line, column);
     }
     
     if (match({TokenType::LPAREN})) {
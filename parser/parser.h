@@ -2,42 +2,71 @@
 #include "lexer/lexer.h"
 #include "parser/ast.h"
 #include <vector>
+#include <functional>
+#include <iostream>
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <stdexcept>
+#include <string_view>
 
 class ParseError : public std::runtime_error {
 public:
     ParseError(const std::string& message) : std::runtime_error(message) {}
 };
 
+// 语法分析器只借用标记序列与源码，调用方需保证二者在解析期间存活
 class Parser {
 private:
-    std::vector<Token> tokens;
-    int current = 0;
+    std::span<const Token> tokens;
+    std::string_view source;
+    LineTable lineTable;
+    std::pmr::memory_resource* resource;
+    std::ostream& diagnostics;
+    size_t current = 0;
     bool hadError = false;
     int errorCount = 0;
     bool isRecovering = false;
+    std::function<void(std::shared_ptr<FunctionDef>)> functionSink;
 
 public:
-    Parser(const std::vector<Token>& tokens) : tokens(tokens) {}
+    Parser(std::span<const Token> tokens, std::string_view source,
+           std::pmr::memory_resource* resource = std::pmr::new_delete_resource(),
+           std::ostream& diagnostics = std::cerr)
+        : tokens(tokens), source(source), lineTable(source), resource(resource), diagnostics(diagnostics) {}
     
     std::shared_ptr<CompUnit> parse();
     bool hasError() const { return hadError; }
 
+    // 设置后每解析完一个函数就交给 sink，不再收集到 CompUnit 中；出错后不再交出
+    void setFunctionSink(std::function<void(std::shared_ptr<FunctionDef>)> sink) {
+        functionSink = std::move(sink);
+    }
+
 private:
-    Token peek(int offset) const {
+    const Token& peek(size_t offset) const {
         if (current + offset >= tokens.size()) {
             return tokens.back();
         }
         return tokens[current + offset];
     }
+
+    // AST 节点从 resource 分配，由调用方决定是否放进 arena
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(resource),
+                                       std::forward<Args>(args)...);
+    }
+
+    std::string text(const Token& token) const { return std::string(token.lexeme(source)); }
+    int columnOf(const Token& token) const { return lineTable.columnOf(token); }
     
-    Token previous() const;
+    const Token& previous() const;
     bool isAtEnd() const;
-    Token advance();
+    const Token& advance();
     bool check(TokenType type) const;
     bool match(std::initializer_list<TokenType> types);
-    Token consume(TokenType type, const std::string& message);
+    const Token& consume(TokenType type, const std::string& message);
     ParseError error(const Token& token, const std::string& message);
     void synchronize();
 
@@ -48,6 +77,7 @@ private:
     std::shared_ptr<BlockStmt> block();
     std::shared_ptr<Stmt> exprStmt();
     std::shared_ptr<Stmt> varDeclStmt();
+    std::shared_ptr<Stmt> constDeclStmt();
     std::shared_ptr<Stmt> assignStmt();
     std::shared_ptr<Stmt> ifStmt();
     std::shared_ptr<Stmt> whileStmt();
@@ -58,6 +88,7 @@ private:
     std::shared_ptr<Expr> expr();
     std::shared_ptr<Expr> lorExpr();
     std::shared_ptr<Expr> landExpr();
+    std::shared_ptr<Expr> eqExpr();
     std::shared_ptr<Expr> relExpr();
     std::shared_ptr<Expr> addExpr();
     std::shared_ptr<Expr> mulExpr();
@@ -1,250 +1,236 @@
+%require "3.6"
+%skeleton "lalr1.cc"
+%defines
+
+%define api.value.type variant
+%define api.value.automove
+%define api.token.constructor
+
 %code requires {
 #include <string>
 #include <vector>
 #include <memory>
 #include "parser/ast.h"
+#include "parser/parse_context.h"
 }
 
 %{
 #include <iostream>
 #include <memory>
+#include <utility>
 #include "parser/ast.h"
+%}
 
-extern int yylex();
-extern int yyparse();
-extern int yylineno;
-void yyerror(const char* s);
+%param {yyscan_t scanner}
+%parse-param {ParseContext& ctx}
 
-std::shared_ptr<CompUnit> root;
-%}
+%code {
+yy::parser::symbol_type yylex(yyscan_t scanner);
+}
 
-%union {
-    int num;
-    std::string* str;
-    ASTNode* node;
-    Expr* expr;
-    Stmt* stmt;
-    BlockStmt* block;
-    FunctionDef* func;
-    CompUnit* unit;
-    std::vector<Param>* params;
-    std::vector<std::shared_ptr<Stmt>>* stmts;
-    std::vector<std::shared_ptr<Expr>>* args;
-    std::vector<std::shared_ptr<FunctionDef>>* funcs;
-}
-
-%token <str> IDENTIFIER
-%token <num> NUMBER
+%token <std::string> IDENTIFIER
+%token <int> NUMBER
 %token INT VOID IF ELSE WHILE BREAK CONTINUE RETURN CONST
 %token PLUS MINUS MULTIPLY DIVIDE MODULO
 %token ASSIGN EQ NEQ LT GT LE GE AND OR NOT
 %token LPAREN RPAREN LBRACE RBRACE SEMICOLON COMMA
 
-%type <unit> comp_unit
-%type <funcs> func_list
-%type <func> func_def
-%type <str> type
-%type <params> params param_list
-%type <block> block
-%type <stmts> stmt_list
-%type <stmt> stmt var_decl assign_stmt if_stmt while_stmt return_stmt expr_stmt
-%type <expr> expr lor_expr land_expr eq_expr rel_expr add_expr mul_expr unary_expr primary_expr
-%type <args> args arg_list
+// 悬空 else 归最近的 if
+%precedence THEN
+%precedence ELSE
+
+%type <std::shared_ptr<CompUnit>> comp_unit
+%type <std::vector<std::shared_ptr<FunctionDef>>> func_list
+%type <std::shared_ptr<FunctionDef>> func_def
+%type <std::string> type
+%type <std::vector<Param>> params param_list
+%type <std::shared_ptr<BlockStmt>> block
+%type <std::vector<std::shared_ptr<Stmt>>> stmt_list
+%type <std::shared_ptr<Stmt>> stmt var_decl assign_stmt if_stmt while_stmt return_stmt expr_stmt
+%type <std::shared_ptr<Expr>> expr lor_expr land_expr eq_expr rel_expr add_expr mul_expr unary_expr primary_expr
+%type <std::vector<std::shared_ptr<Expr>>> args arg_list
 
 %start comp_unit
 
 %%
 
 comp_unit: func_list {
-    $$ = new CompUnit(*$1, yylineno);
-    root = std::shared_ptr<CompUnit>($$);
-    delete $1;
+    $$ = ctx.make<CompUnit>($1, ctx.currentLine());
+    ctx.setRoot($$);
 }
 
 func_list: func_list func_def {
     $$ = $1;
-    $$->push_back(std::shared_ptr<FunctionDef>($2));
+    ctx.addFunction($$, $2);
 }
 | func_def {
-    $$ = new std::vector<std::shared_ptr<FunctionDef>>();
-    $$->push_back(std::shared_ptr<FunctionDef>($1));
+    ctx.addFunction($$, $1);
 }
 
 func_def: type IDENTIFIER LPAREN params RPAREN block {
-    $$ = new FunctionDef(*$1, *$2, *$4, std::shared_ptr<BlockStmt>($6), yylineno);
-    delete $1; delete $2; delete $4;
+    $$ = ctx.make<FunctionDef>($1, $2, $4, $6, ctx.currentLine());
 }
 
-type: INT { $$ = new std::string("int"); }
-| VOID { $$ = new std::string("void"); }
+type: INT { $$ = "int"; }
+| VOID { $$ = "void"; }
 
 params: param_list { $$ = $1; }
-| /* empty */ { $$ = new std::vector<Param>(); }
+| %empty { }
 
 param_list: param_list COMMA INT IDENTIFIER {
     $$ = $1;
-    $$->push_back(Param(*$4, yylineno));
-    delete $4;
+    $$.emplace_back($4, ctx.currentLine());
 }
 | INT IDENTIFIER {
-    $$ = new std::vector<Param>();
-    $$->push_back(Param(*$2, yylineno));
-    delete $2;
+    $$.emplace_back($2, ctx.currentLine());
 }
 
 block: LBRACE stmt_list RBRACE {
-    $$ = new BlockStmt(*$2, yylineno);
-    delete $2;
+    $$ = ctx.make<BlockStmt>($2, ctx.currentLine());
 }
 
 stmt_list: stmt_list stmt {
     $$ = $1;
-    if ($2) $$->push_back(std::shared_ptr<Stmt>($2));
-}
-| /* empty */ {
-    $$ = new std::vector<std::shared_ptr<Stmt>>();
+    auto s = $2;
+    if (s) $$.push_back(std::move(s));
 }
+| %empty { }
 
 stmt: var_decl { $$ = $1; }
 | assign_stmt { $$ = $1; }
 | if_stmt { $$ = $1; }
 | while_stmt { $$ = $1; }
 | return_stmt { $$ = $1; }
-| BREAK SEMICOLON { $$ = new BreakStmt(yylineno); }
-| CONTINUE SEMICOLON { $$ = new ContinueStmt(yylineno); }
+| BREAK SEMICOLON { $$ = ctx.make<BreakStmt>(ctx.currentLine()); }
+| CONTINUE SEMICOLON { $$ = ctx.make<ContinueStmt>(ctx.currentLine()); }
 | expr_stmt { $$ = $1; }
 | block { $$ = $1; }
 | SEMICOLON { $$ = nullptr; } // Empty statement
 
 var_decl: INT IDENTIFIER ASSIGN expr SEMICOLON {
-    $$ = new VarDeclStmt(*$2, std::shared_ptr<Expr>($4), yylineno);
-    delete $2;
+    $$ = ctx.make<VarDeclStmt>($2, $4, ctx.currentLine());
 }
 | CONST INT IDENTIFIER ASSIGN expr SEMICOLON {
-    $$ = new VarDeclStmt(*$3, std::shared_ptr<Expr>($5), yylineno);
-    delete $3;
+    auto decl = ctx.make<VarDeclStmt>($3, $5, ctx.currentLine());
+    decl->isConst = true;
+    $$ = decl;
 }
 | INT IDENTIFIER SEMICOLON {
-    $$ = new VarDeclStmt(*$2, nullptr, yylineno);
-    delete $2;
+    $$ = ctx.make<VarDeclStmt>($2, nullptr, ctx.currentLine());
 }
 
 assign_stmt: IDENTIFIER ASSIGN expr SEMICOLON {
-    $$ = new AssignStmt(*$1, std::shared_ptr<Expr>($3), yylineno);
-    delete $1;
+    $$ = ctx.make<AssignStmt>($1, $3, ctx.currentLine());
 }
 
 if_stmt: IF LPAREN expr RPAREN stmt ELSE stmt {
-    $$ = new IfStmt(std::shared_ptr<Expr>($3), std::shared_ptr<Stmt>($5), std::shared_ptr<Stmt>($7), yylineno);
+    $$ = ctx.make<IfStmt>($3, $5, $7, ctx.currentLine());
 }
-| IF LPAREN expr RPAREN stmt {
-    $$ = new IfStmt(std::shared_ptr<Expr>($3), std::shared_ptr<Stmt>($5), nullptr, yylineno);
+| IF LPAREN expr RPAREN stmt %prec THEN {
+    $$ = ctx.make<IfStmt>($3, $5, nullptr, ctx.currentLine());
 }
 
 while_stmt: WHILE LPAREN expr RPAREN stmt {
-    $$ = new WhileStmt(std::shared_ptr<Expr>($3), std::shared_ptr<Stmt>($5), yylineno);
+    $$ = ctx.make<WhileStmt>($3, $5, ctx.currentLine());
 }
 
 return_stmt: RETURN expr SEMICOLON {
-    $$ = new ReturnStmt(std::shared_ptr<Expr>($2), yylineno);
+    $$ = ctx.make<ReturnStmt>($2, ctx.currentLine());
 }
 | RETURN SEMICOLON {
-    $$ = new ReturnStmt(nullptr, yylineno);
+    $$ = ctx.make<ReturnStmt>(nullptr, ctx.currentLine());
 }
 
 expr_stmt: expr SEMICOLON {
-    $$ = new ExprStmt(std::shared_ptr<Expr>($1), yylineno);
+    $$ = ctx.make<ExprStmt>($1, ctx.currentLine());
 }
 
 expr: lor_expr { $$ = $1; }
 
 lor_expr: lor_expr OR land_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "||", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "||", $3, ctx.currentLine());
 }
 | land_expr { $$ = $1; }
 
 land_expr: land_expr AND eq_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "&&", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "&&", $3, ctx.currentLine());
 }
 | eq_expr { $$ = $1; }
 
 eq_expr: eq_expr EQ rel_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "==", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "==", $3, ctx.currentLine());
 }
 | eq_expr NEQ rel_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "!=", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "!=", $3, ctx.currentLine());
 }
 | rel_expr { $$ = $1; }
 
 rel_expr: rel_expr LT add_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "<", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "<", $3, ctx.currentLine());
 }
 | rel_expr GT add_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), ">", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, ">", $3, ctx.currentLine());
 }
 | rel_expr LE add_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "<=", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "<=", $3, ctx.currentLine());
 }
 | rel_expr GE add_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), ">=", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, ">=", $3, ctx.currentLine());
 }
 | add_expr { $$ = $1; }
 
 add_expr: add_expr PLUS mul_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "+", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "+", $3, ctx.currentLine());
 }
 | add_expr MINUS mul_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "-", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "-", $3, ctx.currentLine());
 }
 | mul_expr { $$ = $1; }
 
 mul_expr: mul_expr MULTIPLY unary_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "*", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "*", $3, ctx.currentLine());
 }
 | mul_expr DIVIDE unary_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "/", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "/", $3, ctx.currentLine());
 }
 | mul_expr MODULO unary_expr {
-    $$ = new BinaryExpr(std::shared_ptr<Expr>($1), "%", std::shared_ptr<Expr>($3), yylineno);
+    $$ = ctx.make<BinaryExpr>($1, "%", $3, ctx.currentLine());
 }
 | unary_expr { $$ = $1; }
 
 unary_expr: PLUS unary_expr {
-    $$ = new UnaryExpr("+", std::shared_ptr<Expr>($2), yylineno);
+    $$ = ctx.make<UnaryExpr>("+", $2, ctx.currentLine());
 }
 | MINUS unary_expr {
-    $$ = new UnaryExpr("-", std::shared_ptr<Expr>($2), yylineno);
+    $$ = ctx.make<UnaryExpr>("-", $2, ctx.currentLine());
 }
 | NOT unary_expr {
-    $$ = new UnaryExpr("!", std::shared_ptr<Expr>($2), yylineno);
+    $$ = ctx.make<UnaryExpr>("!", $2, ctx.currentLine());
 }
 | primary_expr { $$ = $1; }
 
 primary_expr: LPAREN expr RPAREN { $$ = $2; }
-| NUMBER { $$ = new NumberExpr($1, yylineno); }
+| NUMBER { $$ = ctx.make<NumberExpr>($1, ctx.currentLine()); }
 | IDENTIFIER {
-    $$ = new VariableExpr(*$1, yylineno);
-    delete $1;
+    $$ = ctx.make<VariableExpr>($1, ctx.currentLine());
 }
 | IDENTIFIER LPAREN args RPAREN {
-    $$ = new CallExpr(*$1, *$3, yylineno);
-    delete $1; delete $3;
+    $$ = ctx.make<CallExpr>($1, $3, ctx.currentLine());
 }
 
 args: arg_list { $$ = $1; }
-| /* empty */ { $$ = new std::vector<std::shared_ptr<Expr>>(); }
+| %empty { }
 
 arg_list: arg_list COMMA expr {
     $$ = $1;
-    $$->push_back(std::shared_ptr<Expr>($3));
+    $$.push_back($3);
 }
 | expr {
-    $$ = new std::vector<std::shared_ptr<Expr>>();
-    $$->push_back(std::shared_ptr<Expr>($1));
+    $$.push_back($1);
 }
 
 %%
 
-void yyerror(const char* s) {
-    std::cerr << "Error: " << s << " at line " << yylineno << std::endl;
-}
\ No newline at end of file
+void yy::parser::error(const std::string& message) {
+    ctx.reportError(message);
+}
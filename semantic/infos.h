@@ -2,6 +2,18 @@
 #include <string>
 #include <vector>
 
+struct OptionalInt {
+    bool hasValue;
+    int value;
+    
+    OptionalInt() : hasValue(false), value(0) {}
+    OptionalInt(int v) : hasValue(true), value(v) {}
+    
+    bool has_value() const { return hasValue; }
+    int operator*() const { return value; }
+    explicit operator bool() const { return hasValue; }
+};
+
 struct Symbol
 {
     enum class Kind { VARIABLE, FUNCTION, PARAMETER };
@@ -13,6 +25,8 @@ struct Symbol
     int paramIndex = -1;
     std::vector<std::pair<std::string, std::string>> params;
     bool used = false;
+    bool isConst = false;
+    OptionalInt constValue;   // const 且初值是常量表达式时的值
     
     Symbol() = default;
     
@@ -39,18 +53,6 @@ struct FunctionInfo
         : returnType(returnType), line(line), column(column), used(false) {}
 };
 
-struct OptionalInt {
-    bool hasValue;
-    int value;
-    
-    OptionalInt() : hasValue(false), value(0) {}
-    OptionalInt(int v) : hasValue(true), value(v) {}
-    
-    bool has_value() const { return hasValue; }
-    int operator*() const { return value; }
-    explicit operator bool() const { return hasValue; }
-};
-
 class SemanticError : public std::runtime_error {
 public:
     int line;
@@ -1,9 +1,8 @@
 #include "semantic.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
-SemanticAnalyzer* analyzeHelper::semanticOwner = nullptr;
-
 void analyzeHelper::setSemanticOwner(SemanticAnalyzer& analyzer) {
     semanticOwner = &analyzer;
 }
@@ -45,6 +44,12 @@ OptionalInt analyzeHelper::evaluateConstant(const std::shared_ptr<Expr>& expr) {
         return OptionalInt(numExpr->value);
     }
     
+    if (auto varExpr = std::dynamic_pointer_cast<VariableExpr>(expr)) {
+        Symbol* symbol = findSymbol(varExpr->name);
+        if (symbol && symbol->isConst) return symbol->constValue;
+        return OptionalInt();
+    }
+    
     if (auto unaryExpr = std::dynamic_pointer_cast<UnaryExpr>(expr)) {
         OptionalInt operandValue = evaluateConstant(unaryExpr->operand);
         if (!operandValue.has_value()) return OptionalInt();
@@ -499,6 +504,11 @@ void analyzeVisitor::visit(VarDeclStmt &stmt) {
     
     Symbol symbol(Symbol::Kind::VARIABLE, "int", stmt.line, stmt.column);
     symbol.used = false;
+    if (stmt.isConst) {
+        // 初值先于声明求值，引用的同名符号是外层的
+        symbol.isConst = true;
+        symbol.constValue = helper.evaluateConstant(stmt.initializer);
+    }
     helper.declareSymbol(stmt.name, symbol);
 }
 
@@ -513,6 +523,8 @@ void analyzeVisitor::visit(AssignStmt &stmt) {
     
     if (symbol->kind != Symbol::Kind::VARIABLE && symbol->kind != Symbol::Kind::PARAMETER) {
         helper.error("Cannot assign to '" + stmt.name + "' (not a variable)", stmt.line, stmt.column);
+    } else if (symbol->isConst) {
+        helper.error("Cannot assign to constant '" + stmt.name + "'", stmt.line, stmt.column);
     }
     
     stmt.value->accept(*this);
@@ -706,9 +718,43 @@ void analyzeVisitor::detectDeadCode() {
 }
 
 bool SemanticAnalyzer::analyze(std::shared_ptr<CompUnit> ast) {
+    begin();
+
+    bool hasMain = false;
+    for (const auto &func : ast->functions) {
+        if (func->name == "main") {
+            hasMain = true;
+        }
+    }
+
+    for (const auto &func : ast->functions) {
+        analyzeFunction(*func);
+    }
+
+    return finish(hasMain);
+}
+
+void SemanticAnalyzer::begin() {
     clearMessages();
-    analyzeHelper::setSemanticOwner(*this);
-    ast->accept(visitor);
+    visitor.helper.setSemanticOwner(*this);
+}
+
+bool SemanticAnalyzer::analyzeFunction(FunctionDef &funcDef) {
+    // 函数必须先定义后调用，逐个分析与整体分析看到的函数表相同
+    funcDef.accept(visitor);
+    return success;
+}
+
+bool SemanticAnalyzer::finish(bool hasMain) {
+    if (!hasMain) {
+        // 整体分析时这条错误最先报告，保持相同的输出顺序
+        size_t before = errorMessages.size();
+        visitor.helper.error("Program must have a main function");
+        if (errorMessages.size() > before) {
+            std::rotate(errorMessages.begin(), errorMessages.end() - 1, errorMessages.end());
+        }
+    }
+    visitor.detectDeadCode();
     
     if (success) {
         checkUnusedVariables();
@@ -716,11 +762,11 @@ bool SemanticAnalyzer::analyze(std::shared_ptr<CompUnit> ast) {
     }
     
     for (const auto& error : errorMessages) {
-        std::cerr << "Semantic error: " << error << std::endl;
+        *diagnostics << "Semantic error: " << error << std::endl;
     }
     
     for (const auto& warning : warningMessages) {
-        std::cerr << "Warning: " << warning << std::endl;
+        *diagnostics << "Warning: " << warning << std::endl;
     }
     
     return success;
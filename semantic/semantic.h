@@ -5,6 +5,7 @@
 #include <vector>
 #include <set>
 #include <stdexcept>
+#include <iostream>
 #include "parser/ast.h"
 #include "infos.h"
 
@@ -14,7 +15,7 @@ class SemanticAnalyzer;
 class analyzeHelper {
 private:
     analyzeVisitor &owner;
-    static SemanticAnalyzer* semanticOwner;
+    SemanticAnalyzer* semanticOwner = nullptr;
     std::set<std::string> reportedErrors;
     std::set<std::string> reportedWarnings;
     int loopDepth = 0;
@@ -22,7 +23,7 @@ private:
 public:
     explicit analyzeHelper(analyzeVisitor &owner) : owner(owner) {}
     
-    static void setSemanticOwner(SemanticAnalyzer& analyzer);
+    void setSemanticOwner(SemanticAnalyzer& analyzer);
     
     void enterScope();
     void exitScope();
@@ -141,6 +142,7 @@ public:
 class SemanticAnalyzer {
 private:
     analyzeVisitor visitor;
+    std::ostream* diagnostics = &std::cerr;
     
 public:
     SemanticAnalyzer() : visitor() {}
@@ -150,6 +152,13 @@ public:
     std::vector<std::string> warningMessages;
     
     bool analyze(std::shared_ptr<CompUnit> ast);
+
+    // 流式分析：begin() 后按源码顺序逐个 analyzeFunction()，
+    // 最后 finish() 做全局检查并输出诊断；结果与 analyze() 完全相同
+    void begin();
+    bool analyzeFunction(FunctionDef& funcDef);
+    bool finish(bool hasMain);
+    void setDiagnostics(std::ostream& out) { diagnostics = &out; }
     const std::vector<std::string>& getErrors() const { return errorMessages; }
     const std::vector<std::string>& getWarnings() const { return warningMessages; }
     
@@ -0,0 +1,274 @@
+#include "simplify.h"
+#include <climits>
+#include <cstdint>
+#include <optional>
+
+namespace {
+
+std::optional<int> constantOf(const std::shared_ptr<Expr>& expr) {
+    if (auto number = std::dynamic_pointer_cast<NumberExpr>(expr)) {
+        return number->value;
+    }
+    return std::nullopt;
+}
+
+std::shared_ptr<Expr> makeNumber(int value, const Expr& at) {
+    return std::make_shared<NumberExpr>(value, at.line, at.column);
+}
+
+// 表达式里有没有调用；没有调用的表达式丢掉也不改变程序行为
+bool hasCall(const std::shared_ptr<Expr>& expr) {
+    if (std::dynamic_pointer_cast<CallExpr>(expr)) {
+        return true;
+    }
+    if (auto binary = std::dynamic_pointer_cast<BinaryExpr>(expr)) {
+        return hasCall(binary->left) || hasCall(binary->right);
+    }
+    if (auto unary = std::dynamic_pointer_cast<UnaryExpr>(expr)) {
+        return hasCall(unary->operand);
+    }
+    return false;
+}
+
+// 值一定是 0 或 1 的表达式
+bool isBoolean(const std::shared_ptr<Expr>& expr) {
+    if (auto binary = std::dynamic_pointer_cast<BinaryExpr>(expr)) {
+        const std::string& op = binary->op;
+        return op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=" ||
+               op == "&&" || op == "||";
+    }
+    if (auto unary = std::dynamic_pointer_cast<UnaryExpr>(expr)) {
+        return unary->op == "!";
+    }
+    return false;
+}
+
+// 两个常量的运算；结果按 32 位补码回绕，与目标机器一致
+std::optional<int> fold(const std::string& op, int left, int right) {
+    auto wrap = [](int64_t value) { return static_cast<int>(static_cast<uint32_t>(value)); };
+    if (op == "+") return wrap(int64_t(left) + right);
+    if (op == "-") return wrap(int64_t(left) - right);
+    if (op == "*") return wrap(int64_t(left) * right);
+    if (op == "/" || op == "%") {
+        if (right == 0 || (left == INT_MIN && right == -1)) {
+            return std::nullopt;
+        }
+        return op == "/" ? left / right : left % right;
+    }
+    if (op == "<") return left < right ? 1 : 0;
+    if (op == ">") return left > right ? 1 : 0;
+    if (op == "<=") return left <= right ? 1 : 0;
+    if (op == ">=") return left >= right ? 1 : 0;
+    if (op == "==") return left == right ? 1 : 0;
+    if (op == "!=") return left != right ? 1 : 0;
+    if (op == "&&") return (left && right) ? 1 : 0;
+    if (op == "||") return (left || right) ? 1 : 0;
+    return std::nullopt;
+}
+
+// 语句执行后一定不会落到下一条
+bool endsFlow(const std::shared_ptr<Stmt>& stmt) {
+    return std::dynamic_pointer_cast<ReturnStmt>(stmt) || std::dynamic_pointer_cast<BreakStmt>(stmt) ||
+           std::dynamic_pointer_cast<ContinueStmt>(stmt);
+}
+
+// 不带花括号的分支里的声明属于外层作用域，分支删掉后声明本身还要留下（不初始化）
+std::shared_ptr<Stmt> declarationOf(const std::shared_ptr<Stmt>& dropped) {
+    auto decl = std::dynamic_pointer_cast<VarDeclStmt>(dropped);
+    if (!decl) {
+        return nullptr;
+    }
+    return std::make_shared<VarDeclStmt>(decl->name, nullptr, decl->line, decl->column);
+}
+
+}  // namespace
+
+// ==================== AST 化简 ====================
+
+void ASTSimplifier::simplify(FunctionDef& funcDef) {
+    scopes.clear();
+    if (funcDef.body) {
+        simplifyBlock(*funcDef.body);
+    }
+}
+
+std::optional<int> ASTSimplifier::constantNamed(const std::string& name) const {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        auto it = scope->find(name);
+        if (it != scope->end()) {
+            return it->second;
+        }
+    }
+    return std::nullopt;
+}
+
+std::shared_ptr<Expr> ASTSimplifier::simplifyExpr(const std::shared_ptr<Expr>& expr) {
+    if (auto variable = std::dynamic_pointer_cast<VariableExpr>(expr)) {
+        if (auto value = constantNamed(variable->name)) {
+            return makeNumber(*value, *variable);
+        }
+        return expr;
+    }
+
+    if (auto unary = std::dynamic_pointer_cast<UnaryExpr>(expr)) {
+        unary->operand = simplifyExpr(unary->operand);
+        if (unary->op == "+") {
+            return unary->operand;
+        }
+        if (auto value = constantOf(unary->operand)) {
+            if (unary->op == "-") {
+                return makeNumber(static_cast<int>(0u - static_cast<uint32_t>(*value)), *unary);
+            }
+            if (unary->op == "!") {
+                return makeNumber(!*value, *unary);
+            }
+        }
+        return expr;
+    }
+
+    if (auto call = std::dynamic_pointer_cast<CallExpr>(expr)) {
+        for (auto& argument : call->arguments) {
+            argument = simplifyExpr(argument);
+        }
+        return expr;
+    }
+
+    auto binary = std::dynamic_pointer_cast<BinaryExpr>(expr);
+    if (!binary) {
+        return expr;
+    }
+    binary->left = simplifyExpr(binary->left);
+    binary->right = simplifyExpr(binary->right);
+    std::optional<int> left = constantOf(binary->left);
+    std::optional<int> right = constantOf(binary->right);
+    const std::string& op = binary->op;
+
+    if (left && right) {
+        if (auto value = fold(op, *left, *right)) {
+            return makeNumber(*value, *binary);
+        }
+        return expr;
+    }
+
+    // 短路：左边决定结果时右边不求值；否则结果就是右边的真假
+    if (left && (op == "&&" || op == "||")) {
+        bool decided = op == "&&" ? *left == 0 : *left != 0;
+        if (decided) {
+            return makeNumber(op == "||", *binary);
+        }
+        if (isBoolean(binary->right)) {
+            return binary->right;
+        }
+        return std::make_shared<BinaryExpr>(binary->right, "!=", makeNumber(0, *binary),
+                                            binary->line, binary->column);
+    }
+
+    if (right && *right == 0 && (op == "+" || op == "-")) {
+        return binary->left;
+    }
+    if (left && *left == 0 && op == "+") {
+        return binary->right;
+    }
+    if (right && *right == 1 && (op == "*" || op == "/")) {
+        return binary->left;
+    }
+    if (left && *left == 1 && op == "*") {
+        return binary->right;
+    }
+    if (op == "*" && ((right && *right == 0 && !hasCall(binary->left)) ||
+                      (left && *left == 0 && !hasCall(binary->right)))) {
+        return makeNumber(0, *binary);
+    }
+    return expr;
+}
+
+std::shared_ptr<Stmt> ASTSimplifier::simplifyStmt(const std::shared_ptr<Stmt>& stmt) {
+    if (auto exprStmt = std::dynamic_pointer_cast<ExprStmt>(stmt)) {
+        if (exprStmt->expression) {
+            exprStmt->expression = simplifyExpr(exprStmt->expression);
+        }
+        return stmt;
+    }
+    if (auto decl = std::dynamic_pointer_cast<VarDeclStmt>(stmt)) {
+        // 初值里的同名引用指向外层，先化简初值再登记
+        if (decl->initializer) {
+            decl->initializer = simplifyExpr(decl->initializer);
+        }
+        std::optional<int> value = decl->isConst ? constantOf(decl->initializer) : std::nullopt;
+        scopes.back()[decl->name] = value;
+        // 所有使用都会换成立即数，不需要存储
+        return value ? nullptr : stmt;
+    }
+    if (auto assign = std::dynamic_pointer_cast<AssignStmt>(stmt)) {
+        assign->value = simplifyExpr(assign->value);
+        return stmt;
+    }
+    if (auto ret = std::dynamic_pointer_cast<ReturnStmt>(stmt)) {
+        if (ret->value) {
+            ret->value = simplifyExpr(ret->value);
+        }
+        return stmt;
+    }
+    if (auto block = std::dynamic_pointer_cast<BlockStmt>(stmt)) {
+        simplifyBlock(*block);
+        return stmt;
+    }
+
+    if (auto ifStmt = std::dynamic_pointer_cast<IfStmt>(stmt)) {
+        ifStmt->condition = simplifyExpr(ifStmt->condition);
+        ifStmt->thenBranch = simplifyStmt(ifStmt->thenBranch);
+        if (ifStmt->elseBranch) {
+            ifStmt->elseBranch = simplifyStmt(ifStmt->elseBranch);
+        }
+        auto value = constantOf(ifStmt->condition);
+        if (!value) {
+            if (!ifStmt->thenBranch) {
+                ifStmt->thenBranch = std::make_shared<BlockStmt>(std::vector<std::shared_ptr<Stmt>>{},
+                                                                 ifStmt->line, ifStmt->column);
+            }
+            return stmt;
+        }
+        std::shared_ptr<Stmt> taken = *value ? ifStmt->thenBranch : ifStmt->elseBranch;
+        std::shared_ptr<Stmt> dropped = *value ? ifStmt->elseBranch : ifStmt->thenBranch;
+        if (std::dynamic_pointer_cast<VarDeclStmt>(dropped)) {
+            // 两个分支都是不带花括号的声明时一条语句替换不了，保留原样
+            return taken ? stmt : declarationOf(dropped);
+        }
+        return taken;
+    }
+
+    if (auto whileStmt = std::dynamic_pointer_cast<WhileStmt>(stmt)) {
+        whileStmt->condition = simplifyExpr(whileStmt->condition);
+        // 循环体先化简：其中的常量声明即使不执行也要登记
+        whileStmt->body = simplifyStmt(whileStmt->body);
+        auto value = constantOf(whileStmt->condition);
+        if (value && *value == 0) {
+            return declarationOf(whileStmt->body);
+        }
+        if (!whileStmt->body) {
+            whileStmt->body = std::make_shared<BlockStmt>(std::vector<std::shared_ptr<Stmt>>{},
+                                                          whileStmt->line, whileStmt->column);
+        }
+        return stmt;
+    }
+
+    return stmt;
+}
+
+void ASTSimplifier::simplifyBlock(BlockStmt& block) {
+    scopes.emplace_back();
+    std::vector<std::shared_ptr<Stmt>> statements;
+    statements.reserve(block.statements.size());
+    for (const auto& stmt : block.statements) {
+        std::shared_ptr<Stmt> simplified = simplifyStmt(stmt);
+        if (!simplified) {
+            continue;
+        }
+        statements.push_back(simplified);
+        if (endsFlow(simplified)) {
+            break;
+        }
+    }
+    block.statements = std::move(statements);
+    scopes.pop_back();
+}
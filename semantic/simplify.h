@@ -0,0 +1,39 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "parser/ast.h"
+
+// ==================== AST 化简 ====================
+
+/**
+ * 语义分析通过后对单个函数的 AST 做化简，让 IR 生成一开始就拿到更小的输入。
+ *
+ * - 常量子表达式原地折叠成数字；除数为 0（以及 INT_MIN / -1）不折叠，留给运行时
+ * - x + 0、0 + x、x - 0、x * 1、1 * x、x / 1 化为 x；不含调用的 x * 0 化为 0
+ * - && / || 左边是常量时按短路规则化掉，结果仍然是 0/1
+ * - 条件为常量的 if 只留下会执行的分支，while (0) 整个删掉；
+ *   不带花括号的声明分支属于外层作用域，删掉时留下不初始化的声明
+ * - 块内 return / break / continue 之后的语句不可达，直接删掉
+ * - 初值化简后是数字的 const int 不再声明，每处使用直接换成这个数字
+ *
+ * 诊断（死代码警告等）在语义分析阶段已经报告，这里只改写不报告。
+ * 新建的节点不在解析用的内存池里，与原有节点混用没有问题。
+ */
+class ASTSimplifier {
+public:
+    void simplify(FunctionDef& funcDef);
+
+private:
+    // 返回化简后的表达式，可能就是原节点
+    std::shared_ptr<Expr> simplifyExpr(const std::shared_ptr<Expr>& expr);
+    // 返回化简后的语句；整个语句可以删掉时返回空
+    std::shared_ptr<Stmt> simplifyStmt(const std::shared_ptr<Stmt>& stmt);
+    void simplifyBlock(BlockStmt& block);
+
+    // 每层作用域里声明的名字；有值的是常量，没有值的是遮住外层常量的普通变量
+    std::vector<std::unordered_map<std::string, std::optional<int>>> scopes;
+    std::optional<int> constantNamed(const std::string& name) const;
+};
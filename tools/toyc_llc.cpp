@@ -0,0 +1,65 @@
+// toyc_llc.cpp - 只运行后端
+//
+// 用法: toyc_llc [-O0..-O3|-Os] [-regalloc=naive|linear|graph|ssa|auto] [file.ir] [-o out.s]
+// 读入文本 IR（toyc_compiler -emit-ir 或 toyc_opt 的输出，默认 stdin），
+// 只做寄存器分配和汇编生成，代码生成配置与 toyc_compiler 的同名选项相同。
+#include "driver/driver.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    CompileOptions options;
+    std::string inputPath;
+    std::string outputPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        OptionParse parsed = parseCompileOption(arg, options, std::cerr);
+        if (parsed == OptionParse::INVALID) {
+            return 1;
+        }
+        if (parsed == OptionParse::ACCEPTED) {
+            continue;
+        }
+        if (arg == "-o") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: Missing path after -o" << std::endl;
+                return 1;
+            }
+            outputPath = argv[++i];
+        } else {
+            inputPath = arg;
+        }
+    }
+
+    std::stringstream text;
+    if (!inputPath.empty()) {
+        std::ifstream input(inputPath, std::ios::binary);
+        if (!input) {
+            std::cerr << "Error: Cannot open file " << inputPath << std::endl;
+            return 1;
+        }
+        text << input.rdbuf();
+    } else {
+        text << std::cin.rdbuf();
+    }
+
+    std::ostringstream assembly;
+    if (!compileIRText(text.str(), options, assembly, std::cerr)) {
+        return 1;
+    }
+
+    if (outputPath.empty()) {
+        std::cout << assembly.str();
+        return 0;
+    }
+    std::ofstream output(outputPath, std::ios::binary);
+    if (!output) {
+        std::cerr << "Error: Cannot open file " << outputPath << " for writing" << std::endl;
+        return 1;
+    }
+    output << assembly.str();
+    return 0;
+}
@@ -0,0 +1,123 @@
+// toyc_opt.cpp - 只运行 IR 优化遍
+//
+// 用法: toyc_opt [-passes=constfold,dce,...] [-time-passes] [file.ir] [-o out.ir]
+//       toyc_opt -list-passes
+// 读入文本 IR（toyc_compiler -emit-ir 的输出，默认 stdin），逐个函数运行指定的遍，
+// 按同样的格式输出。不给 -passes 时运行与 -opt 相同的默认优化序列。
+// -time-passes 把每个遍的累计耗时写到 stderr。
+#include "ir/ir.h"
+#include "ir/irgen.h"
+#include "ir/ir_reader.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> splitPasses(const std::string& list) {
+    std::vector<std::string> passes;
+    std::stringstream stream(list);
+    std::string name;
+    while (std::getline(stream, name, ',')) {
+        if (!name.empty()) {
+            passes.push_back(name);
+        }
+    }
+    return passes;
+}
+
+int main(int argc, char* argv[]) {
+    std::string inputPath;
+    std::string outputPath;
+    std::vector<std::string> passes;
+    bool passesGiven = false;
+    bool timePasses = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("-passes=", 0) == 0) {
+            passes = splitPasses(arg.substr(8));
+            passesGiven = true;
+        } else if (arg == "-list-passes") {
+            for (const auto& name : IRGenerator::passNames()) {
+                std::cout << name << std::endl;
+            }
+            return 0;
+        } else if (arg == "-time-passes") {
+            timePasses = true;
+        } else if (arg == "-o") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: Missing path after -o" << std::endl;
+                return 1;
+            }
+            outputPath = argv[++i];
+        } else {
+            inputPath = arg;
+        }
+    }
+
+    std::stringstream text;
+    if (!inputPath.empty()) {
+        std::ifstream input(inputPath, std::ios::binary);
+        if (!input) {
+            std::cerr << "Error: Cannot open file " << inputPath << std::endl;
+            return 1;
+        }
+        text << input.rdbuf();
+    } else {
+        text << std::cin.rdbuf();
+    }
+
+    std::vector<std::shared_ptr<IRInstr>> instructions;
+    if (!IRReader::parse(text.str(), instructions, std::cerr)) {
+        return 1;
+    }
+
+    IRGenerator optimizer;
+    std::map<std::string, double> passSeconds;
+    std::vector<std::shared_ptr<IRInstr>> result;
+    for (auto& function : IRReader::splitFunctions(instructions)) {
+        if (!passesGiven) {
+            auto start = std::chrono::steady_clock::now();
+            optimizer.optimizeFunction(function);
+            passSeconds["default"] += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        } else if (!timePasses) {
+            if (!optimizer.runPasses(function, passes)) {
+                std::cerr << "Error: Unknown pass in -passes (see -list-passes)" << std::endl;
+                return 1;
+            }
+        } else {
+            for (const auto& pass : passes) {
+                auto start = std::chrono::steady_clock::now();
+                if (!optimizer.runPasses(function, {pass})) {
+                    std::cerr << "Error: Unknown pass '" << pass << "' (see -list-passes)" << std::endl;
+                    return 1;
+                }
+                passSeconds[pass] += std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+            }
+        }
+        result.insert(result.end(), function.begin(), function.end());
+    }
+
+    if (timePasses) {
+        for (const auto& [name, seconds] : passSeconds) {
+            std::cerr << name << ": " << seconds * 1000.0 << " ms" << std::endl;
+        }
+    }
+
+    if (outputPath.empty()) {
+        IRPrinter::print(result, std::cout);
+        return 0;
+    }
+    std::ofstream output(outputPath, std::ios::binary);
+    if (!output) {
+        std::cerr << "Error: Cannot open file " << outputPath << " for writing" << std::endl;
+        return 1;
+    }
+    IRPrinter::print(result, output);
+    return 0;
+}